@@ -6,6 +6,8 @@
 #include "Components/BoxComponent.h"
 #include "Components/SphereComponent.h"
 #include "Components/WidgetComponent.h"
+#include "DormantItemSubsystem.h"
+#include "Net/UnrealNetwork.h"
 #include "ShooterCharacter.h"
 
 AAmmo::AAmmo()
@@ -73,7 +75,67 @@ void AAmmo::SetItemProperties(EItemState State)
 		AmmoMesh->SetCollisionResponseToAllChannels(ECR_Ignore);
 		AmmoMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 		break;
+	case EItemState::EIS_Pooled:
+		// Set Mesh properties
+		AmmoMesh->SetSimulatePhysics(false);
+		AmmoMesh->SetEnableGravity(false);
+		AmmoMesh->SetVisibility(false);
+		AmmoMesh->SetCollisionResponseToAllChannels(ECR_Ignore);
+		AmmoMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		break;
+	}
+
+	if (State == EItemState::EIS_Pickup)
+	{
+		if (HasAuthority())
+		{
+			UpdatePickupRecord();
+		}
+		else if (bHasPickupRecord)
+		{
+			ApplyPickupRecord();
+		}
+	}
+}
+
+void AAmmo::UpdatePickupRecord()
+{
+	PickupRecord.AmmoType = AmmoType;
+	PickupRecord.Count = GetItemCount();
+	PickupRecord.Location = GetActorLocation();
+	PickupRecord.Rotation = GetActorRotation();
+}
+
+void AAmmo::ApplyPickupRecord()
+{
+	AmmoType = PickupRecord.AmmoType;
+	SetItemCount(PickupRecord.Count);
+
+	// The dormant instance was placed at the old transform
+	if (UDormantItemSubsystem* DormantItems = GetWorld()->GetSubsystem<UDormantItemSubsystem>())
+	{
+		DormantItems->RemoveItem(this);
 	}
+	SetActorLocationAndRotation(PickupRecord.Location, PickupRecord.Rotation, false, nullptr, ETeleportType::ResetPhysics);
+}
+
+void AAmmo::OnRep_PickupRecord()
+{
+	bHasPickupRecord = true;
+
+	// Otherwise applied when OnRep_ItemState brings the stack back to the Pickup state
+	if (GetItemState() == EItemState::EIS_Pickup)
+	{
+		ApplyPickupRecord();
+		UpdateItemRegistration();
+	}
+}
+
+void AAmmo::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AAmmo, PickupRecord);
 }
 
 void AAmmo::AmmoSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
@@ -100,3 +162,26 @@ void AAmmo::DisableCustomDepth()
 	AmmoMesh->SetRenderCustomDepth(false);
 }
 
+
+void AAmmo::OnReleasedToPool()
+{
+	Super::OnReleasedToPool();
+
+	AmmoCollisionSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+}
+
+void AAmmo::OnAcquiredFromPool()
+{
+	Super::OnAcquiredFromPool();
+
+	// Disabled when the ammo was picked up
+	AmmoCollisionSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+}
+
+UStaticMesh* AAmmo::GetDormantMesh(FTransform& OutTransform) const
+{
+	UStaticMesh* Mesh = Super::GetDormantMesh(OutTransform);
+	OutTransform = AmmoMesh->GetComponentTransform();
+	if (Mesh) return Mesh;
+	return AmmoMesh->GetStaticMesh();
+}
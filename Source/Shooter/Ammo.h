@@ -5,6 +5,7 @@
 #include "CoreMinimal.h"
 #include "Item.h"
 #include "AmmoType.h"
+#include "AmmoPickupRecord.h"
 #include "Ammo.generated.h"
 
 /**
@@ -20,6 +21,8 @@ public:
 
 	virtual void Tick(float DeltaTime) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
 protected:
 
 	virtual void BeginPlay() override;
@@ -27,6 +30,15 @@ protected:
 	// Override of SetItemProperties, so we can set AmmoMesh properties
 	virtual void SetItemProperties(EItemState State) override;
 
+	// Copies the ammo type, count and transform into PickupRecord on the server
+	void UpdatePickupRecord();
+
+	// Moves a client's copy to where PickupRecord says the stack lies
+	void ApplyPickupRecord();
+
+	UFUNCTION()
+	void OnRep_PickupRecord();
+
 	UFUNCTION()
 	void AmmoSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
 	
@@ -47,10 +59,23 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category= Ammo, meta=(AllowPrivateAccess = "True"))
 	class USphereComponent* AmmoCollisionSphere;
 
+	// Replicated in place of the actor's movement while the stack lies on the ground
+	UPROPERTY(ReplicatedUsing = OnRep_PickupRecord)
+	FAmmoPickupRecord PickupRecord;
+
+	// False until the first record arrives, level placed stacks may never get one
+	bool bHasPickupRecord{ false };
+
 public:
 	FORCEINLINE UStaticMeshComponent* GetAmmoMesh() const { return AmmoMesh; }
 	FORCEINLINE EAmmoType GetAmmoType() const { return AmmoType; }
 
 	virtual void EnableCustomDepth() override;
 	virtual void DisableCustomDepth() override;
+
+	virtual void OnReleasedToPool() override;
+	virtual void OnAcquiredFromPool() override;
+
+	// Falls back to the AmmoMesh's static mesh
+	virtual UStaticMesh* GetDormantMesh(FTransform& OutTransform) const override;
 };
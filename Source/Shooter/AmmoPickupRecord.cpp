@@ -0,0 +1,37 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AmmoPickupRecord.h"
+
+#include "Engine/NetSerialization.h"
+#include "Serialization/BitWriter.h"
+
+bool FAmmoPickupRecord::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	uint32 Type{ static_cast<uint32>(AmmoType) };
+	Ar.SerializeInt(Type, static_cast<uint32>(EAmmoType::EAT_MAX));
+
+	uint32 PackedCount{ static_cast<uint32>(FMath::Max(Count, 0)) };
+	Ar.SerializeIntPacked(PackedCount);
+
+	const bool bLocationSuccess{ SerializePackedVector<1, 24>(Location, Ar) };
+	Rotation.SerializeCompressedShort(Ar);
+
+	if (Ar.IsLoading())
+	{
+		AmmoType = static_cast<EAmmoType>(Type);
+		Count = static_cast<int32>(PackedCount);
+	}
+
+	bOutSuccess = bLocationSuccess && !Ar.IsError();
+	return true;
+}
+
+int32 FAmmoPickupRecord::GetSerializedBits() const
+{
+	FBitWriter Writer(0, true);
+	bool bSuccess{ true };
+	FAmmoPickupRecord Copy{ *this };
+	Copy.NetSerialize(Writer, nullptr, bSuccess);
+	return static_cast<int32>(Writer.GetNumBits());
+}
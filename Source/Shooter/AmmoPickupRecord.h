@@ -0,0 +1,45 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "AmmoType.h"
+#include "AmmoPickupRecord.generated.h"
+
+/**
+ * Everything a client needs to show an ammo stack lying on the ground. AAmmo replicates this
+ * instead of its movement, so a pooled stack moved to a new spot costs one small record.
+ */
+USTRUCT()
+struct FAmmoPickupRecord
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	EAmmoType AmmoType{ EAmmoType::EAT_9mm };
+
+	UPROPERTY()
+	int32 Count{ 0 };
+
+	// Quantized to 1 unit
+	UPROPERTY()
+	FVector Location{ FVector::ZeroVector };
+
+	// 16 bits per component, scale is not sent since pickups are never scaled
+	UPROPERTY()
+	FRotator Rotation{ FRotator::ZeroRotator };
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	// Payload size in bits, used for the bandwidth stats
+	int32 GetSerializedBits() const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FAmmoPickupRecord> : public TStructOpsTypeTraitsBase2<FAmmoPickupRecord>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
@@ -0,0 +1,207 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "AnimBudgetSubsystem.h"
+
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "Camera/PlayerCameraManager.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+
+static TAutoConsoleVariable<float> CVarAnimBudgetMs(
+	TEXT("Shooter.AnimBudget.BudgetMs"),
+	2.f,
+	TEXT("Estimated milliseconds per frame for shooter character animation.\n")
+	TEXT("Characters ranked past the budget are dropped to the Far tier. 0 disables the budget."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAnimNearDistance(
+	TEXT("Shooter.AnimBudget.NearDistance"),
+	1500.f,
+	TEXT("Characters closer than this to the camera use the Near tier."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAnimFarDistance(
+	TEXT("Shooter.AnimBudget.FarDistance"),
+	4000.f,
+	TEXT("Characters further than this from the camera use the Far tier."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAnimFABRIKDistance(
+	TEXT("Shooter.AnimBudget.FABRIKDistance"),
+	2500.f,
+	TEXT("Characters further than this from the camera skip the FABRIK hand IK."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarAnimEstimatedGraphCostMs(
+	TEXT("Shooter.AnimBudget.EstimatedGraphCostMs"),
+	0.1f,
+	TEXT("Estimated cost of one anim graph evaluation, added to the measured native update cost."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAnimMidUpdateRate(
+	TEXT("Shooter.AnimBudget.MidUpdateRate"),
+	2,
+	TEXT("Mid tier characters update their anim graph every N frames."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAnimFarUpdateRate(
+	TEXT("Shooter.AnimBudget.FarUpdateRate"),
+	4,
+	TEXT("Far tier characters update their anim graph every N frames."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarAnimOffscreenUpdateRate(
+	TEXT("Shooter.AnimBudget.OffscreenUpdateRate"),
+	8,
+	TEXT("Off screen characters update their anim graph every N frames."),
+	ECVF_Default);
+
+void UAnimBudgetSubsystem::Deinitialize()
+{
+	AnimInstances.Empty();
+	Entries.Empty();
+
+	Super::Deinitialize();
+}
+
+void UAnimBudgetSubsystem::RegisterAnimInstance(UShooterAnimInstance* AnimInstance)
+{
+	AnimInstances.AddUnique(AnimInstance);
+}
+
+void UAnimBudgetSubsystem::UnregisterAnimInstance(UShooterAnimInstance* AnimInstance)
+{
+	AnimInstances.RemoveSwap(AnimInstance);
+}
+
+int32 UAnimBudgetSubsystem::GetUpdateRate(EShooterAnimTier Tier)
+{
+	switch (Tier)
+	{
+	case EShooterAnimTier::ESAT_Mid:
+		return FMath::Max(1, CVarAnimMidUpdateRate.GetValueOnGameThread());
+	case EShooterAnimTier::ESAT_Far:
+		return FMath::Max(1, CVarAnimFarUpdateRate.GetValueOnGameThread());
+	case EShooterAnimTier::ESAT_Offscreen:
+		return FMath::Max(1, CVarAnimOffscreenUpdateRate.GetValueOnGameThread());
+	default:
+		return 1;
+	}
+}
+
+bool UAnimBudgetSubsystem::GatherViewLocations()
+{
+	ViewLocations.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		if (PlayerController && PlayerController->IsLocalController() && PlayerController->PlayerCameraManager)
+		{
+			ViewLocations.Add(PlayerController->PlayerCameraManager->GetCameraLocation());
+		}
+	}
+	return ViewLocations.Num() > 0;
+}
+
+void UAnimBudgetSubsystem::Tick(float DeltaTime)
+{
+	AnimInstances.RemoveAllSwap([](const TWeakObjectPtr<UShooterAnimInstance>& AnimInstance) { return !AnimInstance.IsValid(); });
+
+	// Nobody is watching a dedicated server, but the rewound bone traces in UShotValidationSubsystem
+	// need every character's pose, so everything stays at the Near tier it starts in
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer) return;
+
+	const bool bHasViewer{ GatherViewLocations() };
+
+	Entries.Reset();
+	for (const TWeakObjectPtr<UShooterAnimInstance>& AnimInstance : AnimInstances)
+	{
+		const USkeletalMeshComponent* Mesh = AnimInstance->GetSkelMeshComponent();
+		const APawn* Pawn = Cast<APawn>(AnimInstance->GetOwningActor());
+		if (Mesh == nullptr || Pawn == nullptr) continue;
+
+		FAnimBudgetEntry& Entry = Entries.AddDefaulted_GetRef();
+		Entry.AnimInstance = AnimInstance.Get();
+		Entry.bLocallyControlled = Pawn->IsLocallyControlled();
+		Entry.bVisible = bHasViewer && Mesh->WasRecentlyRendered(0.2f);
+		Entry.DistanceSquared = TNumericLimits<float>::Max();
+		for (const FVector& ViewLocation : ViewLocations)
+		{
+			Entry.DistanceSquared = FMath::Min(Entry.DistanceSquared, static_cast<float>(FVector::DistSquared(ViewLocation, Mesh->GetComponentLocation())));
+		}
+	}
+
+	// Highest priority first
+	Entries.Sort([](const FAnimBudgetEntry& A, const FAnimBudgetEntry& B)
+	{
+		if (A.bLocallyControlled != B.bLocallyControlled) return A.bLocallyControlled;
+		if (A.bVisible != B.bVisible) return A.bVisible;
+		return A.DistanceSquared < B.DistanceSquared;
+	});
+
+	const float BudgetMs{ CVarAnimBudgetMs.GetValueOnGameThread() };
+	const float NearDistanceSquared{ FMath::Square(CVarAnimNearDistance.GetValueOnGameThread()) };
+	const float FarDistanceSquared{ FMath::Square(CVarAnimFarDistance.GetValueOnGameThread()) };
+	const float FABRIKDistanceSquared{ FMath::Square(CVarAnimFABRIKDistance.GetValueOnGameThread()) };
+	const float GraphCostMs{ CVarAnimEstimatedGraphCostMs.GetValueOnGameThread() };
+
+	int32 TierCounts[static_cast<int32>(EShooterAnimTier::ESAT_MAX)]{};
+	int32 NumDemoted{ 0 };
+	float SpentMs{ 0.f };
+
+	for (const FAnimBudgetEntry& Entry : Entries)
+	{
+		EShooterAnimTier Tier{ EShooterAnimTier::ESAT_Near };
+		if (!Entry.bLocallyControlled)
+		{
+			if (!Entry.bVisible)
+			{
+				Tier = EShooterAnimTier::ESAT_Offscreen;
+			}
+			else if (Entry.DistanceSquared >= FarDistanceSquared)
+			{
+				Tier = EShooterAnimTier::ESAT_Far;
+			}
+			else if (Entry.DistanceSquared >= NearDistanceSquared)
+			{
+				Tier = EShooterAnimTier::ESAT_Mid;
+			}
+		}
+
+		const float UpdateCostMs{ static_cast<float>(Entry.AnimInstance->GetLastUpdateSeconds() * 1000.0) + GraphCostMs };
+		float CostMs{ UpdateCostMs / GetUpdateRate(Tier) };
+
+		// The local character always gets a full update, everyone else competes for what is left
+		if (BudgetMs > 0.f && !Entry.bLocallyControlled && Tier < EShooterAnimTier::ESAT_Far && SpentMs + CostMs > BudgetMs)
+		{
+			Tier = EShooterAnimTier::ESAT_Far;
+			CostMs = UpdateCostMs / GetUpdateRate(Tier);
+			NumDemoted++;
+		}
+		SpentMs += CostMs;
+
+		const bool bAllowFABRIK{ Tier != EShooterAnimTier::ESAT_Offscreen && Entry.DistanceSquared < FABRIKDistanceSquared };
+		Entry.AnimInstance->SetAnimTier(Tier, bAllowFABRIK, GetUpdateRate(Tier));
+		TierCounts[static_cast<int32>(Tier)]++;
+	}
+
+	SET_DWORD_STAT(STAT_AnimTierNear, TierCounts[static_cast<int32>(EShooterAnimTier::ESAT_Near)]);
+	SET_DWORD_STAT(STAT_AnimTierMid, TierCounts[static_cast<int32>(EShooterAnimTier::ESAT_Mid)]);
+	SET_DWORD_STAT(STAT_AnimTierFar, TierCounts[static_cast<int32>(EShooterAnimTier::ESAT_Far)]);
+	SET_DWORD_STAT(STAT_AnimTierOffscreen, TierCounts[static_cast<int32>(EShooterAnimTier::ESAT_Offscreen)]);
+	SET_DWORD_STAT(STAT_AnimBudgetDemoted, NumDemoted);
+	SET_FLOAT_STAT(STAT_AnimBudgetEstimatedMs, SpentMs);
+}
+
+TStatId UAnimBudgetSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UAnimBudgetSubsystem, STATGROUP_Tickables);
+}
+
+bool UAnimBudgetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
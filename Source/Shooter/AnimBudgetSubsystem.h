@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterAnimInstance.h"
+#include "AnimBudgetSubsystem.generated.h"
+
+/**
+ * Picks an animation tier for every shooter anim instance once per frame.
+ * Instances are ranked by locally controlled, on screen, then distance to the
+ * nearest local camera (every split screen player's), and get their distance tier until the estimated cost of the
+ * ranked instances passes Shooter.AnimBudget.BudgetMs. Everything after that
+ * is dropped to the Far tier. A dedicated server leaves every instance at Near,
+ * its shot validation traces need the real poses.
+ */
+UCLASS()
+class SHOOTER_API UAnimBudgetSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Called from UShooterAnimInstance::NativeInitializeAnimation / NativeUninitializeAnimation
+	void RegisterAnimInstance(UShooterAnimInstance* AnimInstance);
+	void UnregisterAnimInstance(UShooterAnimInstance* AnimInstance);
+
+	// Graph update rate used for a tier, 1 is every frame
+	static int32 GetUpdateRate(EShooterAnimTier Tier);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FAnimBudgetEntry
+	{
+		UShooterAnimInstance* AnimInstance{ nullptr };
+		float DistanceSquared{ 0.f };
+		bool bLocallyControlled{ false };
+		bool bVisible{ false };
+	};
+
+	// Camera locations of every local player controller into ViewLocations, returns false if there are none
+	bool GatherViewLocations();
+
+	TArray<TWeakObjectPtr<UShooterAnimInstance>> AnimInstances;
+
+	// Scratch array reused every tick
+	TArray<FVector> ViewLocations;
+
+	// Scratch array reused every tick
+	TArray<FAnimBudgetEntry> Entries;
+};
@@ -0,0 +1,53 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakedCurve.h"
+
+#include "Curves/CurveFloat.h"
+#include "Curves/CurveVector.h"
+
+void FBakedCurve::Bake(const UCurveBase* Curve, float SamplesPerSecond)
+{
+	Source = Curve;
+	Samples.Reset();
+	MinTime = 0.f;
+	SamplesPerTime = 0.f;
+	LastPosition = 0.f;
+	if (Curve == nullptr)
+	{
+		// Same as a single key at zero, Sample still needs its two samples
+		Samples.Init(FVector4f(0.f, 0.f, 0.f, 0.f), 2);
+		return;
+	}
+
+	float MaxTime{ 0.f };
+	Curve->GetTimeRange(MinTime, MaxTime);
+	const float Duration{ FMath::Max(MaxTime - MinTime, 0.f) };
+	const int32 NumSamples{ FMath::Max(2, FMath::CeilToInt(Duration * FMath::Max(SamplesPerSecond, 1.f)) + 1) };
+
+	const UCurveFloat* FloatCurve = Cast<UCurveFloat>(Curve);
+	const UCurveVector* VectorCurve = Cast<UCurveVector>(Curve);
+
+	Samples.SetNumUninitialized(NumSamples);
+	for (int32 i = 0; i < NumSamples; i++)
+	{
+		const float Time{ MinTime + Duration * i / (NumSamples - 1) };
+		if (FloatCurve)
+		{
+			Samples[i] = FVector4f(FloatCurve->GetFloatValue(Time), 0.f, 0.f, 0.f);
+		}
+		else if (VectorCurve)
+		{
+			const FVector Value{ VectorCurve->GetVectorValue(Time) };
+			Samples[i] = FVector4f(Value.X, Value.Y, Value.Z, 0.f);
+		}
+		else
+		{
+			Samples[i] = FVector4f(0.f, 0.f, 0.f, 0.f);
+		}
+	}
+
+	// A curve with a single key bakes to two equal samples and always reads the first
+	SamplesPerTime = Duration > 0.f ? (NumSamples - 1) / Duration : 0.f;
+	LastPosition = static_cast<float>(NumSamples - 1);
+}
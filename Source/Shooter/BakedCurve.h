@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/VectorRegister.h"
+
+class UCurveBase;
+
+/**
+ * Fixed step lookup table sampled from a UCurveFloat or UCurveVector, evaluated with
+ * one SIMD lerp between the two nearest samples. Float curves use X only.
+ * Times outside the curve's key range clamp to the first / last key.
+ */
+struct SHOOTER_API FBakedCurve
+{
+	// Samples Curve over its key range, SamplesPerSecond trades accuracy for memory
+	void Bake(const UCurveBase* Curve, float SamplesPerSecond);
+
+	FORCEINLINE FVector4f Sample(float Time) const
+	{
+		const float Position{ FMath::Clamp((Time - MinTime) * SamplesPerTime, 0.f, LastPosition) };
+		const int32 Index{ FMath::Min(static_cast<int32>(Position), Samples.Num() - 2) };
+
+		const VectorRegister4Float A{ VectorLoad(&Samples[Index].X) };
+		const VectorRegister4Float B{ VectorLoad(&Samples[Index + 1].X) };
+		const VectorRegister4Float Alpha{ VectorSetFloat1(Position - Index) };
+
+		FVector4f Result;
+		VectorStore(VectorMultiplyAdd(VectorSubtract(B, A), Alpha, A), &Result.X);
+		return Result;
+	}
+
+	FORCEINLINE float SampleFloat(float Time) const { return Sample(Time).X; }
+
+	FORCEINLINE FVector SampleVector(float Time) const
+	{
+		const FVector4f Value{ Sample(Time) };
+		return FVector(Value.X, Value.Y, Value.Z);
+	}
+
+	FORCEINLINE const UCurveBase* GetSource() const { return Source.Get(); }
+
+	FORCEINLINE int32 GetNumSamples() const { return Samples.Num(); }
+
+private:
+	TWeakObjectPtr<const UCurveBase> Source;
+
+	// At least two samples, so Sample never needs a bounds branch
+	TArray<FVector4f> Samples;
+
+	float MinTime{ 0.f };
+	float SamplesPerTime{ 0.f };
+	float LastPosition{ 0.f };
+};
+
+// One entry of a batched evaluation, Value is only written when Curve is set
+struct FBakedCurveSample
+{
+	const FBakedCurve* Curve{ nullptr };
+	float Time{ 0.f };
+	FVector4f Value{ 0.f, 0.f, 0.f, 0.f };
+};
+
+// Evaluates all samples in one tight loop
+FORCEINLINE void EvaluateBakedCurves(TArrayView<FBakedCurveSample> CurveSamples)
+{
+	for (FBakedCurveSample& CurveSample : CurveSamples)
+	{
+		if (CurveSample.Curve)
+		{
+			CurveSample.Value = CurveSample.Curve->Sample(CurveSample.Time);
+		}
+	}
+}
@@ -0,0 +1,120 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BakedCurve.h"
+
+#include "Curves/CurveFloat.h"
+#include "Curves/CurveVector.h"
+#include "Misc/AutomationTest.h"
+#include "UObject/Package.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+namespace ShooterBakedCurveTests
+{
+	constexpr float SamplesPerSecond{ 120.f };
+	constexpr int32 NumTestSamples{ 997 };
+
+	// Off the bake grid and a little past both ends, so the lerp and the clamping are both covered
+	FORCEINLINE float GetTestTime(int32 Index, float MinTime, float MaxTime)
+	{
+		const float Padding{ (MaxTime - MinTime) * 0.1f };
+		return FMath::Lerp(MinTime - Padding, MaxTime + Padding, (Index + 0.37f) / NumTestSamples);
+	}
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBakedCurveFloatTest, "Shooter.Curves.BakedCurve.Float",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBakedCurveFloatTest::RunTest(const FString& Parameters)
+{
+	using namespace ShooterBakedCurveTests;
+
+	UCurveFloat* Curve = NewObject<UCurveFloat>(GetTransientPackage());
+	Curve->FloatCurve.AddKey(0.f, 0.f);
+	Curve->FloatCurve.AddKey(0.5f, 10.f);
+	Curve->FloatCurve.AddKey(1.f, -5.f);
+	Curve->FloatCurve.AddKey(2.f, 3.f);
+
+	FBakedCurve Baked;
+	Baked.Bake(Curve, SamplesPerSecond);
+	TestTrue(TEXT("Baked curve keeps its source"), Baked.GetSource() == Curve);
+
+	// 1% of the curve's value range, same bar as Shooter.Curves.Validate
+	const float Tolerance{ 15.f * 0.01f };
+	for (int32 i = 0; i < NumTestSamples; i++)
+	{
+		const float Time{ GetTestTime(i, 0.f, 2.f) };
+		const float Expected{ Curve->GetFloatValue(Time) };
+		if (!TestEqual(FString::Printf(TEXT("Float sample at %.4f"), Time), Baked.SampleFloat(Time), Expected, Tolerance))
+		{
+			break;
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBakedCurveVectorTest, "Shooter.Curves.BakedCurve.Vector",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBakedCurveVectorTest::RunTest(const FString& Parameters)
+{
+	using namespace ShooterBakedCurveTests;
+
+	UCurveVector* Curve = NewObject<UCurveVector>(GetTransientPackage());
+	Curve->FloatCurves[0].AddKey(0.f, 0.f);
+	Curve->FloatCurves[0].AddKey(1.f, 4.f);
+	Curve->FloatCurves[1].AddKey(0.25f, -2.f);
+	Curve->FloatCurves[1].AddKey(0.75f, 2.f);
+	Curve->FloatCurves[2].AddKey(0.f, 1.f);
+	Curve->FloatCurves[2].AddKey(0.5f, 6.f);
+	Curve->FloatCurves[2].AddKey(1.f, 1.f);
+
+	FBakedCurve Baked;
+	Baked.Bake(Curve, SamplesPerSecond);
+
+	const float Tolerance{ 5.f * 0.01f };
+	for (int32 i = 0; i < NumTestSamples; i++)
+	{
+		const float Time{ GetTestTime(i, 0.f, 1.f) };
+		const FVector Expected{ Curve->GetVectorValue(Time) };
+		if (!TestEqual(FString::Printf(TEXT("Vector sample at %.4f"), Time), Baked.SampleVector(Time), Expected, Tolerance))
+		{
+			break;
+		}
+	}
+
+	return true;
+}
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FBakedCurveDegenerateTest, "Shooter.Curves.BakedCurve.Degenerate",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::ProductFilter)
+
+bool FBakedCurveDegenerateTest::RunTest(const FString& Parameters)
+{
+	FBakedCurve Baked;
+	Baked.Bake(nullptr, 60.f);
+	TestEqual(TEXT("Null curve sample count"), Baked.GetNumSamples(), 2);
+	TestTrue(TEXT("Null curve samples zero"), Baked.Sample(0.5f).Equals(FVector4f(0.f, 0.f, 0.f, 0.f)));
+
+	// A single key has a zero length time range, every sample must read that key
+	UCurveFloat* SingleKey = NewObject<UCurveFloat>(GetTransientPackage());
+	SingleKey->FloatCurve.AddKey(1.f, 7.f);
+	Baked.Bake(SingleKey, 60.f);
+	TestEqual(TEXT("Single key sample count"), Baked.GetNumSamples(), 2);
+	for (const float Time : { -1.f, 0.f, 1.f, 2.f })
+	{
+		TestEqual(FString::Printf(TEXT("Single key sample at %.1f"), Time), Baked.SampleFloat(Time), SingleKey->GetFloatValue(Time));
+	}
+
+	// No keys at all, the curve's own value is its default
+	UCurveFloat* NoKeys = NewObject<UCurveFloat>(GetTransientPackage());
+	Baked.Bake(NoKeys, 60.f);
+	TestEqual(TEXT("Empty curve sample count"), Baked.GetNumSamples(), 2);
+	TestEqual(TEXT("Empty curve sample"), Baked.SampleFloat(0.f), NoKeys->GetFloatValue(0.f));
+
+	return true;
+}
+
+#endif // WITH_DEV_AUTOMATION_TESTS
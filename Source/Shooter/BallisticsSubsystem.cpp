@@ -0,0 +1,345 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "BallisticsSubsystem.h"
+
+#include "DamageSubsystem.h"
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "ShooterProfiling.h"
+#include "Weapon.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Math/RandomStream.h"
+#include "Math/VectorRegister.h"
+
+static TAutoConsoleVariable<float> CVarBallisticsSubstep(
+	TEXT("Shooter.Ballistics.Substep"),
+	1.f / 120.f,
+	TEXT("Longest integration step for projectiles, in seconds. Frames longer than this are split into equal substeps."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarBallisticsMaxSubsteps(
+	TEXT("Shooter.Ballistics.MaxSubsteps"),
+	8,
+	TEXT("Most substeps per frame, long frames use longer substeps past this."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarBallisticsMaxLifetime(
+	TEXT("Shooter.Ballistics.MaxLifetime"),
+	4.f,
+	TEXT("Seconds after which a projectile that hit nothing is removed."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarBallisticsMaxProjectiles(
+	TEXT("Shooter.Ballistics.MaxProjectiles"),
+	16384,
+	TEXT("Most live projectiles, further rounds are dropped when fired."),
+	ECVF_Default);
+
+namespace ShooterBallistics
+{
+	FORCEINLINE void StepScalar(float& PX, float& PY, float& PZ, float& VX, float& VY, float& VZ, float Drag, float GravityZ, float DeltaTime)
+	{
+		const float Speed{ FMath::Sqrt(VX * VX + VY * VY + VZ * VZ) };
+
+		// Clamped so a long step can never turn the round around
+		const float Scale{ FMath::Max(1.f - Drag * Speed * DeltaTime, 0.f) };
+		VX *= Scale;
+		VY *= Scale;
+		VZ = VZ * Scale + GravityZ * DeltaTime;
+
+		PX += VX * DeltaTime;
+		PY += VY * DeltaTime;
+		PZ += VZ * DeltaTime;
+	}
+
+	// A round starts inside its shooter's capsule and the weapon that fired it, so both are left out of its traces
+	FORCEINLINE FCollisionQueryParams MakeQueryParams(const AShooterCharacter* Shooter, const AWeapon* Weapon)
+	{
+		FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(BallisticsTrace), false, Shooter);
+		QueryParams.AddIgnoredActor(Weapon);
+		return QueryParams;
+	}
+}
+
+int32 FProjectileArrays::Add(const FVector& Location, const FVector& Velocity, float Drag, float GravityZ)
+{
+	PositionX.Add(Location.X);
+	PositionY.Add(Location.Y);
+	PositionZ.Add(Location.Z);
+	VelocityX.Add(Velocity.X);
+	VelocityY.Add(Velocity.Y);
+	VelocityZ.Add(Velocity.Z);
+	Drags.Add(Drag);
+	GravityZs.Add(GravityZ);
+	return Ages.Add(0.f);
+}
+
+void FProjectileArrays::RemoveAtSwap(int32 Index)
+{
+	PositionX.RemoveAtSwap(Index, 1, false);
+	PositionY.RemoveAtSwap(Index, 1, false);
+	PositionZ.RemoveAtSwap(Index, 1, false);
+	VelocityX.RemoveAtSwap(Index, 1, false);
+	VelocityY.RemoveAtSwap(Index, 1, false);
+	VelocityZ.RemoveAtSwap(Index, 1, false);
+	Drags.RemoveAtSwap(Index, 1, false);
+	GravityZs.RemoveAtSwap(Index, 1, false);
+	Ages.RemoveAtSwap(Index, 1, false);
+}
+
+void FProjectileArrays::Reset()
+{
+	PositionX.Reset();
+	PositionY.Reset();
+	PositionZ.Reset();
+	VelocityX.Reset();
+	VelocityY.Reset();
+	VelocityZ.Reset();
+	Drags.Reset();
+	GravityZs.Reset();
+	Ages.Reset();
+}
+
+void FProjectileArrays::Integrate(float DeltaTime)
+{
+	const int32 NumRounds{ Num() };
+	const int32 NumVectorRounds{ NumRounds & ~3 };
+
+	const VectorRegister4Float Dt{ VectorSetFloat1(DeltaTime) };
+	const VectorRegister4Float Zero{ VectorZeroFloat() };
+	const VectorRegister4Float One{ VectorOneFloat() };
+
+	for (int32 i = 0; i < NumVectorRounds; i += 4)
+	{
+		VectorRegister4Float VX{ VectorLoad(&VelocityX[i]) };
+		VectorRegister4Float VY{ VectorLoad(&VelocityY[i]) };
+		VectorRegister4Float VZ{ VectorLoad(&VelocityZ[i]) };
+
+		const VectorRegister4Float SpeedSquared{ VectorMultiplyAdd(VZ, VZ, VectorMultiplyAdd(VY, VY, VectorMultiply(VX, VX))) };
+		const VectorRegister4Float Speed{ VectorSqrt(SpeedSquared) };
+		const VectorRegister4Float DragStep{ VectorMultiply(VectorMultiply(VectorLoad(&Drags[i]), Speed), Dt) };
+		const VectorRegister4Float Scale{ VectorMax(VectorSubtract(One, DragStep), Zero) };
+
+		VX = VectorMultiply(VX, Scale);
+		VY = VectorMultiply(VY, Scale);
+		VZ = VectorMultiplyAdd(VectorLoad(&GravityZs[i]), Dt, VectorMultiply(VZ, Scale));
+
+		VectorStore(VectorMultiplyAdd(VX, Dt, VectorLoad(&PositionX[i])), &PositionX[i]);
+		VectorStore(VectorMultiplyAdd(VY, Dt, VectorLoad(&PositionY[i])), &PositionY[i]);
+		VectorStore(VectorMultiplyAdd(VZ, Dt, VectorLoad(&PositionZ[i])), &PositionZ[i]);
+		VectorStore(VX, &VelocityX[i]);
+		VectorStore(VY, &VelocityY[i]);
+		VectorStore(VZ, &VelocityZ[i]);
+		VectorStore(VectorAdd(VectorLoad(&Ages[i]), Dt), &Ages[i]);
+	}
+
+	for (int32 i = NumVectorRounds; i < NumRounds; i++)
+	{
+		ShooterBallistics::StepScalar(PositionX[i], PositionY[i], PositionZ[i], VelocityX[i], VelocityY[i], VelocityZ[i], Drags[i], GravityZs[i], DeltaTime);
+		Ages[i] += DeltaTime;
+	}
+}
+
+void FProjectileArrays::IntegrateScalar(float DeltaTime)
+{
+	for (int32 i = 0; i < Num(); i++)
+	{
+		ShooterBallistics::StepScalar(PositionX[i], PositionY[i], PositionZ[i], VelocityX[i], VelocityY[i], VelocityZ[i], Drags[i], GravityZs[i], DeltaTime);
+		Ages[i] += DeltaTime;
+	}
+}
+
+void UBallisticsSubsystem::Deinitialize()
+{
+	Projectiles.Reset();
+	Infos.Empty();
+
+	Super::Deinitialize();
+}
+
+void UBallisticsSubsystem::Tick(float DeltaTime)
+{
+	if (Projectiles.Num() == 0) return;
+
+	SHOOTER_PROFILE_SCOPE(Ballistics_Update);
+
+	// Segments submitted last frame, before anything moves further
+	ResolveTraces();
+
+	{
+		SHOOTER_PROFILE_SCOPE(Ballistics_Integrate);
+
+		const float MaxSubstep{ FMath::Max(CVarBallisticsSubstep.GetValueOnGameThread(), UE_KINDA_SMALL_NUMBER) };
+		const int32 NumSubsteps{ FMath::Clamp(FMath::CeilToInt(DeltaTime / MaxSubstep), 1, FMath::Max(CVarBallisticsMaxSubsteps.GetValueOnGameThread(), 1)) };
+		const float Substep{ DeltaTime / NumSubsteps };
+		for (int32 Step = 0; Step < NumSubsteps; Step++)
+		{
+			Projectiles.Integrate(Substep);
+		}
+	}
+
+	RemoveExpired();
+	SubmitTraces();
+
+	SET_DWORD_STAT(STAT_BallisticsProjectiles, Projectiles.Num());
+}
+
+TStatId UBallisticsSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UBallisticsSubsystem, STATGROUP_Tickables);
+}
+
+void UBallisticsSubsystem::FireProjectile(AShooterCharacter* Shooter, const FTransform& MuzzleTransform, const FVector& Velocity, float Drag, float GravityScale)
+{
+	if (Projectiles.Num() >= CVarBallisticsMaxProjectiles.GetValueOnGameThread()) return;
+
+	const FVector MuzzleLocation{ MuzzleTransform.GetLocation() };
+	Projectiles.Add(MuzzleLocation, Velocity, FMath::Max(Drag, 0.f), GetWorld()->GetGravityZ() * GravityScale);
+
+	FProjectileInfo& Info = Infos.AddDefaulted_GetRef();
+	Info.Shooter = Shooter;
+	Info.Weapon = Shooter ? Shooter->GetEquippedWeapon() : nullptr;
+	Info.BaseDamage = Info.Weapon.IsValid() ? Info.Weapon->GetDamage() : 0.f;
+	Info.MuzzleTransform = MuzzleTransform;
+	Info.SegmentStart = MuzzleLocation;
+}
+
+bool UBallisticsSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UBallisticsSubsystem::ResolveTraces()
+{
+	SHOOTER_PROFILE_SCOPE(Ballistics_ResolveTraces);
+
+	UWorld* World = GetWorld();
+	UDamageSubsystem* Damage = World->GetNetMode() != NM_Client ? World->GetSubsystem<UDamageSubsystem>() : nullptr;
+
+	// Backwards, so the round swapped into a removed slot has already been looked at
+	for (int32 Index = Infos.Num() - 1; Index >= 0; Index--)
+	{
+		FProjectileInfo& Info = Infos[Index];
+		if (!Info.TraceHandle.IsValid()) continue;
+
+		FHitResult Hit;
+		FTraceDatum TraceData;
+		if (World->QueryTraceData(Info.TraceHandle, TraceData))
+		{
+			if (TraceData.OutHits.Num() > 0)
+			{
+				Hit = TraceData.OutHits[0];
+			}
+		}
+		else if (World->IsTraceHandleValid(Info.TraceHandle, false))
+		{
+			// Still in flight, the next segment waits for it
+			continue;
+		}
+		else
+		{
+			// Result was discarded before we read it, fall back to a blocking trace
+			World->LineTraceSingleByChannel(Hit, Info.TraceStart, Info.TraceEnd, ECC_Visibility, ShooterBallistics::MakeQueryParams(Info.Shooter.Get(), Info.Weapon.Get()));
+			INC_DWORD_STAT(STAT_ShooterTraces);
+		}
+		Info.TraceHandle = FTraceHandle();
+
+		if (Hit.bBlockingHit)
+		{
+			INC_DWORD_STAT(STAT_BallisticsHits);
+			AShooterCharacter* Shooter = Info.Shooter.Get();
+			if (Shooter)
+			{
+				Shooter->ResolveBullet(Info.MuzzleTransform, Hit);
+			}
+			if (Damage)
+			{
+				Damage->QueueHit(Shooter, Hit, Info.BaseDamage);
+			}
+			RemoveProjectile(Index);
+		}
+	}
+}
+
+void UBallisticsSubsystem::RemoveExpired()
+{
+	const float MaxLifetime{ CVarBallisticsMaxLifetime.GetValueOnGameThread() };
+	const AWorldSettings* WorldSettings = GetWorld()->GetWorldSettings();
+	const float KillZ{ WorldSettings ? WorldSettings->KillZ : -UE_BIG_NUMBER };
+
+	for (int32 Index = Projectiles.Num() - 1; Index >= 0; Index--)
+	{
+		// A round with a trace in flight waits for its result, it may have hit something
+		if (Infos[Index].TraceHandle.IsValid()) continue;
+
+		if (Projectiles.Ages[Index] > MaxLifetime || Projectiles.PositionZ[Index] < KillZ)
+		{
+			RemoveProjectile(Index);
+		}
+	}
+}
+
+void UBallisticsSubsystem::SubmitTraces()
+{
+	SHOOTER_PROFILE_SCOPE(Ballistics_SubmitTraces);
+
+	UWorld* World = GetWorld();
+
+	int32 NumTraces{ 0 };
+	for (int32 Index = 0; Index < Infos.Num(); Index++)
+	{
+		FProjectileInfo& Info = Infos[Index];
+		if (Info.TraceHandle.IsValid()) continue;
+
+		const FVector Position{ Projectiles.GetPosition(Index) };
+		if (Position.Equals(Info.SegmentStart)) continue;
+
+		// One segment per round per frame, all of them run as the world's async trace batch
+		Info.TraceStart = Info.SegmentStart;
+		Info.TraceEnd = Position;
+		Info.TraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, Info.TraceStart, Info.TraceEnd, ECC_Visibility,
+			ShooterBallistics::MakeQueryParams(Info.Shooter.Get(), Info.Weapon.Get()));
+		Info.SegmentStart = Position;
+		NumTraces++;
+	}
+
+	INC_DWORD_STAT_BY(STAT_ShooterTraces, NumTraces);
+	INC_DWORD_STAT_BY(STAT_BallisticsTraces, NumTraces);
+}
+
+void UBallisticsSubsystem::RemoveProjectile(int32 Index)
+{
+	Projectiles.RemoveAtSwap(Index);
+	Infos.RemoveAtSwap(Index, 1, false);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs BallisticsStressCommand(
+	TEXT("Shooter.Ballistics.Stress"),
+	TEXT("Fires rounds in a cone from the first player's view, without impact effects. Usage: Shooter.Ballistics.Stress [Count] [MuzzleVelocity] [Drag]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UBallisticsSubsystem* Ballistics = World ? World->GetSubsystem<UBallisticsSubsystem>() : nullptr;
+		const APlayerController* PlayerController = World ? World->GetFirstPlayerController() : nullptr;
+		if (Ballistics == nullptr || PlayerController == nullptr) return;
+
+		const int32 Count{ Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000 };
+		const float MuzzleVelocity{ Args.Num() > 1 ? FCString::Atof(*Args[1]) : 90000.f };
+		const float Drag{ Args.Num() > 2 ? FCString::Atof(*Args[2]) : 8e-6f };
+
+		FVector ViewLocation;
+		FRotator ViewRotation;
+		PlayerController->GetPlayerViewPoint(ViewLocation, ViewRotation);
+
+		FRandomStream Random(1337);
+		for (int32 i = 0; i < Count; i++)
+		{
+			const FVector Direction{ Random.VRandCone(ViewRotation.Vector(), FMath::DegreesToRadians(10.f)) };
+			Ballistics->FireProjectile(nullptr, FTransform(Direction.Rotation(), ViewLocation), Direction * MuzzleVelocity, Drag, 1.f);
+		}
+
+		UE_LOG(LogShooter, Log, TEXT("Ballistics: fired %d rounds, %d live"), Count, Ballistics->GetNumProjectiles());
+	}));
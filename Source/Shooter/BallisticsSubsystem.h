@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "BallisticsSubsystem.generated.h"
+
+class AShooterCharacter;
+class AWeapon;
+
+/**
+ * Live projectiles, one array per component so the integrator loads four rounds per vector register.
+ * Drag is quadratic: every second a round loses Drag * Speed * Velocity, Drag in 1/units.
+ */
+struct SHOOTER_API FProjectileArrays
+{
+	TArray<float> PositionX;
+	TArray<float> PositionY;
+	TArray<float> PositionZ;
+	TArray<float> VelocityX;
+	TArray<float> VelocityY;
+	TArray<float> VelocityZ;
+	TArray<float> Drags;
+
+	// World gravity times the weapon's gravity scale
+	TArray<float> GravityZs;
+
+	// Seconds since the round was fired
+	TArray<float> Ages;
+
+	FORCEINLINE int32 Num() const { return PositionX.Num(); }
+
+	FORCEINLINE FVector GetPosition(int32 Index) const { return FVector(PositionX[Index], PositionY[Index], PositionZ[Index]); }
+
+	int32 Add(const FVector& Location, const FVector& Velocity, float Drag, float GravityZ);
+
+	// Moves the last round into Index
+	void RemoveAtSwap(int32 Index);
+
+	void Reset();
+
+	// One semi-implicit Euler step of every round, four at a time with a scalar tail
+	void Integrate(float DeltaTime);
+
+	// The same step one round at a time, reference for Integrate and the benchmark
+	void IntegrateScalar(float DeltaTime);
+};
+
+/**
+ * Simulates the rounds of weapons whose data table row has bProjectile set, so they have travel
+ * time and drop instead of resolving instantly. Rounds are integrated in fixed substeps, and
+ * the segment each round covered during the frame goes into the world's async trace batch.
+ * Hits are read back the next frame and go through AShooterCharacter::ResolveBullet like hitscan hits,
+ * with the damage of the weapon that fired the round, not whatever the shooter holds when it lands.
+ */
+UCLASS()
+class SHOOTER_API UBallisticsSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Called from AShooterCharacter::SendBullet, and ServerFire / MulticastShotCosmetics for the server's and remote copies. Shooter may be null for rounds without impact effects, like the stress test's
+	void FireProjectile(AShooterCharacter* Shooter, const FTransform& MuzzleTransform, const FVector& Velocity, float Drag, float GravityScale);
+
+	FORCEINLINE int32 GetNumProjectiles() const { return Projectiles.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Cold per-round data, kept out of the integrator's arrays
+	struct FProjectileInfo
+	{
+		TWeakObjectPtr<AShooterCharacter> Shooter;
+
+		// Weapon that fired the round and its damage then, the shooter may have swapped or dropped it since
+		TWeakObjectPtr<AWeapon> Weapon;
+		float BaseDamage{ 0.f };
+
+		// Barrel socket transform when fired, the beam particles start here
+		FTransform MuzzleTransform;
+
+		// Where the next trace starts, the end of the last traced segment
+		FVector SegmentStart;
+
+		// Segment of the trace in flight, for the blocking fallback if its result was discarded
+		FVector TraceStart;
+		FVector TraceEnd;
+		FTraceHandle TraceHandle;
+	};
+
+	// Reads last frame's traces, resolving and removing the rounds that hit something
+	void ResolveTraces();
+
+	// Removes rounds past their lifetime or below the world's KillZ
+	void RemoveExpired();
+
+	// Submits the segment every round covered since its last trace
+	void SubmitTraces();
+
+	void RemoveProjectile(int32 Index);
+
+	FProjectileArrays Projectiles;
+
+	// Parallel to Projectiles
+	TArray<FProjectileInfo> Infos;
+};
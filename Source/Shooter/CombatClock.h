@@ -0,0 +1,164 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "EnumIndexedArray.h"
+#include "Shooter.h"
+
+/**
+ * Per-actor replacement for a handful of FTimerHandles.
+ * Every event is pending at most once, so the min-heap holds at most one entry per
+ * enum value and lives inline in the owner. The owner calls Update once per tick
+ * with the world time and due events are dispatched in due time order.
+ *
+ * While an event is dispatched GetTime returns its due time instead of the world
+ * time, so an event scheduled from a handler, like an automatic weapon arming its
+ * next shot, keeps the ideal cadence and can fire more than once in a long frame.
+ */
+template<typename EventType, EventType MaxEvent>
+class TCombatClock
+{
+public:
+	static constexpr int32 Capacity{ static_cast<int32>(MaxEvent) };
+	static_assert(Capacity > 0 && Capacity < 128, "TCombatClock stores heap positions as int8");
+
+	// Bounds the events one Update dispatches, so an event that keeps rescheduling itself with no delay can't stall the frame
+	static constexpr int32 MaxDispatchesPerUpdate{ 32 };
+
+	TCombatClock() :
+	HeapIndices(INDEX_NONE),
+	StartTimes(0.0),
+	DueTimes(0.0)
+	{
+	}
+
+	// The world time, or the due time of the event being dispatched
+	FORCEINLINE double GetTime(double WorldTime) const { return bDispatching ? DispatchTime : WorldTime; }
+
+	// Starts Event Delay seconds after Now, restarting it if it is already pending
+	void Schedule(EventType Event, double Now, double Delay)
+	{
+		Cancel(Event);
+
+		StartTimes[Event] = Now;
+		DueTimes[Event] = Now + FMath::Max(Delay, 0.0);
+
+		const int32 Index{ NumPending++ };
+		Heap[Index] = Event;
+		HeapIndices[Event] = static_cast<int8>(Index);
+		SiftUp(Index);
+
+		INC_DWORD_STAT(STAT_ShooterTimersSet);
+	}
+
+	void Cancel(EventType Event)
+	{
+		const int32 Index{ HeapIndices[Event] };
+		if (Index != INDEX_NONE)
+		{
+			RemoveAt(Index);
+		}
+	}
+
+	void Reset()
+	{
+		for (int32 i = 0; i < NumPending; i++)
+		{
+			HeapIndices[Heap[i]] = INDEX_NONE;
+		}
+		NumPending = 0;
+	}
+
+	FORCEINLINE bool IsScheduled(EventType Event) const { return HeapIndices[Event] != INDEX_NONE; }
+
+	// Seconds since Event was scheduled, -1 if it isn't pending, like FTimerManager::GetTimerElapsed
+	FORCEINLINE double GetElapsed(EventType Event, double Now) const
+	{
+		return IsScheduled(Event) ? Now - StartTimes[Event] : -1.0;
+	}
+
+	FORCEINLINE bool HasDueEvents(double WorldTime) const
+	{
+		return NumPending > 0 && DueTimes[Heap[0]] <= WorldTime;
+	}
+
+	// Dispatches every event due at WorldTime to Handler(EventType)
+	template<typename HandlerType>
+	void Update(double WorldTime, HandlerType&& Handler)
+	{
+		for (int32 Dispatched = 0; Dispatched < MaxDispatchesPerUpdate && HasDueEvents(WorldTime); Dispatched++)
+		{
+			const EventType Event{ Heap[0] };
+			DispatchTime = DueTimes[Event];
+			RemoveAt(0);
+
+			bDispatching = true;
+			Handler(Event);
+			bDispatching = false;
+		}
+	}
+
+private:
+	FORCEINLINE bool IsEarlier(int32 A, int32 B) const
+	{
+		return DueTimes[Heap[A]] < DueTimes[Heap[B]];
+	}
+
+	FORCEINLINE void Swap(int32 A, int32 B)
+	{
+		::Swap(Heap[A], Heap[B]);
+		HeapIndices[Heap[A]] = static_cast<int8>(A);
+		HeapIndices[Heap[B]] = static_cast<int8>(B);
+	}
+
+	void SiftUp(int32 Index)
+	{
+		while (Index > 0)
+		{
+			const int32 Parent{ (Index - 1) / 2 };
+			if (!IsEarlier(Index, Parent)) break;
+			Swap(Index, Parent);
+			Index = Parent;
+		}
+	}
+
+	void SiftDown(int32 Index)
+	{
+		for (;;)
+		{
+			const int32 Left{ Index * 2 + 1 };
+			const int32 Right{ Left + 1 };
+			int32 Earliest{ Index };
+			if (Left < NumPending && IsEarlier(Left, Earliest)) Earliest = Left;
+			if (Right < NumPending && IsEarlier(Right, Earliest)) Earliest = Right;
+			if (Earliest == Index) break;
+			Swap(Index, Earliest);
+			Index = Earliest;
+		}
+	}
+
+	void RemoveAt(int32 Index)
+	{
+		HeapIndices[Heap[Index]] = INDEX_NONE;
+		NumPending--;
+		if (Index == NumPending) return;
+
+		Heap[Index] = Heap[NumPending];
+		HeapIndices[Heap[Index]] = static_cast<int8>(Index);
+		SiftDown(Index);
+		SiftUp(Index);
+	}
+
+	// Pending events, ordered by due time
+	EventType Heap[Capacity];
+	int32 NumPending{ 0 };
+
+	// Position of each event in Heap, INDEX_NONE when it isn't pending
+	TEnumIndexedArray<EventType, int8, MaxEvent> HeapIndices;
+	TEnumIndexedArray<EventType, double, MaxEvent> StartTimes;
+	TEnumIndexedArray<EventType, double, MaxEvent> DueTimes;
+
+	double DispatchTime{ 0.0 };
+	bool bDispatching{ false };
+};
@@ -0,0 +1,180 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "CurveBakeSubsystem.h"
+
+#include "Shooter.h"
+#include "Curves/CurveFloat.h"
+#include "Curves/CurveVector.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "UObject/UObjectIterator.h"
+
+static TAutoConsoleVariable<int32> CVarCurvesBaked(
+	TEXT("Shooter.Curves.Baked"),
+	1,
+	TEXT("1 evaluates item and weapon curves from baked lookup tables, 0 evaluates the curve assets."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarCurvesSamplesPerSecond(
+	TEXT("Shooter.Curves.SamplesPerSecond"),
+	240.f,
+	TEXT("Samples per second of curve time in the baked lookup tables. Higher is more accurate and uses more memory.\n")
+	TEXT("Changing it rebakes every curve."),
+	ECVF_Default);
+
+static void OnCurveBakeSettingsChanged()
+{
+	static float LastSamplesPerSecond{ CVarCurvesSamplesPerSecond.GetValueOnGameThread() };
+	const float SamplesPerSecond{ CVarCurvesSamplesPerSecond.GetValueOnGameThread() };
+	if (SamplesPerSecond == LastSamplesPerSecond) return;
+	LastSamplesPerSecond = SamplesPerSecond;
+
+	for (TObjectIterator<UCurveBakeSubsystem> It; It; ++It)
+	{
+		It->RebakeAll();
+	}
+}
+
+static FAutoConsoleVariableSink CurveBakeSettingsSink(FConsoleCommandDelegate::CreateStatic(&OnCurveBakeSettingsChanged));
+
+void UCurveBakeSubsystem::Deinitialize()
+{
+	BakedCurves.Empty();
+
+	Super::Deinitialize();
+}
+
+const FBakedCurve* UCurveBakeSubsystem::GetBakedCurve(const UCurveBase* Curve)
+{
+	if (Curve == nullptr) return nullptr;
+
+	TUniquePtr<FBakedCurve>& BakedCurve = BakedCurves.FindOrAdd(Curve);
+	if (!BakedCurve.IsValid())
+	{
+		BakedCurve = MakeUnique<FBakedCurve>();
+		BakedCurve->Bake(Curve, CVarCurvesSamplesPerSecond.GetValueOnGameThread());
+	}
+	return BakedCurve.Get();
+}
+
+const FBakedCurve* UCurveBakeSubsystem::FindBakedCurve(const UObject* WorldContextObject, const UCurveBase* Curve)
+{
+	const UWorld* World = WorldContextObject ? WorldContextObject->GetWorld() : nullptr;
+	UCurveBakeSubsystem* CurveBake = World ? World->GetSubsystem<UCurveBakeSubsystem>() : nullptr;
+	return CurveBake ? CurveBake->GetBakedCurve(Curve) : nullptr;
+}
+
+bool UCurveBakeSubsystem::IsBakingEnabled()
+{
+	return CVarCurvesBaked.GetValueOnGameThread() != 0;
+}
+
+float UCurveBakeSubsystem::EvaluateFloat(const FBakedCurve* Baked, const UCurveFloat* Curve, float Time)
+{
+	if (Baked && IsBakingEnabled())
+	{
+		return Baked->SampleFloat(Time);
+	}
+	return Curve ? Curve->GetFloatValue(Time) : 0.f;
+}
+
+FVector UCurveBakeSubsystem::EvaluateVector(const FBakedCurve* Baked, const UCurveVector* Curve, float Time)
+{
+	if (Baked && IsBakingEnabled())
+	{
+		return Baked->SampleVector(Time);
+	}
+	return Curve ? Curve->GetVectorValue(Time) : FVector::ZeroVector;
+}
+
+void UCurveBakeSubsystem::RebakeAll()
+{
+	const float SamplesPerSecond{ CVarCurvesSamplesPerSecond.GetValueOnGameThread() };
+	for (TPair<TObjectKey<UCurveBase>, TUniquePtr<FBakedCurve>>& BakedCurve : BakedCurves)
+	{
+		BakedCurve.Value->Bake(BakedCurve.Value->GetSource(), SamplesPerSecond);
+	}
+}
+
+void UCurveBakeSubsystem::ValidateCurves(int32 NumTestSamples) const
+{
+	NumTestSamples = FMath::Max(NumTestSamples, 2);
+
+	for (const TPair<TObjectKey<UCurveBase>, TUniquePtr<FBakedCurve>>& BakedCurve : BakedCurves)
+	{
+		const UCurveBase* Curve = BakedCurve.Value->GetSource();
+		if (Curve == nullptr) continue;
+
+		const UCurveFloat* FloatCurve = Cast<UCurveFloat>(Curve);
+		const UCurveVector* VectorCurve = Cast<UCurveVector>(Curve);
+		if (FloatCurve == nullptr && VectorCurve == nullptr) continue;
+
+		float MinTime{ 0.f };
+		float MaxTime{ 0.f };
+		Curve->GetTimeRange(MinTime, MaxTime);
+
+		// Off the bake grid on purpose, halfway between samples is where the lerp is worst
+		TArray<float> Times;
+		Times.SetNumUninitialized(NumTestSamples);
+		for (int32 i = 0; i < NumTestSamples; i++)
+		{
+			Times[i] = FMath::Lerp(MinTime, MaxTime, (i + 0.37f) / NumTestSamples);
+		}
+
+		TArray<FVector> Reference;
+		Reference.SetNumUninitialized(NumTestSamples);
+		const double ReferenceStart{ FPlatformTime::Seconds() };
+		for (int32 i = 0; i < NumTestSamples; i++)
+		{
+			Reference[i] = FloatCurve ? FVector(FloatCurve->GetFloatValue(Times[i]), 0.f, 0.f) : VectorCurve->GetVectorValue(Times[i]);
+		}
+		const double ReferenceSeconds{ FPlatformTime::Seconds() - ReferenceStart };
+
+		TArray<FVector4f> Baked;
+		Baked.SetNumUninitialized(NumTestSamples);
+		const double BakedStart{ FPlatformTime::Seconds() };
+		for (int32 i = 0; i < NumTestSamples; i++)
+		{
+			Baked[i] = BakedCurve.Value->Sample(Times[i]);
+		}
+		const double BakedSeconds{ FPlatformTime::Seconds() - BakedStart };
+
+		double MaxError{ 0.0 };
+		FVector MinValue{ Reference[0] };
+		FVector MaxValue{ Reference[0] };
+		for (int32 i = 0; i < NumTestSamples; i++)
+		{
+			const FVector BakedValue{ Baked[i].X, Baked[i].Y, Baked[i].Z };
+			MaxError = FMath::Max(MaxError, (BakedValue - Reference[i]).GetAbsMax());
+			MinValue = MinValue.ComponentMin(Reference[i]);
+			MaxValue = MaxValue.ComponentMax(Reference[i]);
+		}
+
+		// Error relative to the curve's value range, 1% of the range is the most we accept
+		const double ValueRange{ FMath::Max((MaxValue - MinValue).GetMax(), UE_KINDA_SMALL_NUMBER) };
+		const bool bPassed{ MaxError <= ValueRange * 0.01 };
+
+		UE_LOG(LogShooter, Display, TEXT("%s %s: %d samples, max error %.6f (%.3f%% of range), reference %.1f ns, baked %.1f ns"),
+			bPassed ? TEXT("PASS") : TEXT("FAIL"), *Curve->GetPathName(), BakedCurve.Value->GetNumSamples(),
+			MaxError, MaxError / ValueRange * 100.0,
+			ReferenceSeconds * 1e9 / NumTestSamples, BakedSeconds * 1e9 / NumTestSamples);
+	}
+}
+
+bool UCurveBakeSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ValidateCurvesCommand(
+	TEXT("Shooter.Curves.Validate"),
+	TEXT("Compares every baked curve in the world against its curve asset. Usage: Shooter.Curves.Validate [Samples]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		const UCurveBakeSubsystem* CurveBake = World ? World->GetSubsystem<UCurveBakeSubsystem>() : nullptr;
+		if (CurveBake == nullptr) return;
+
+		CurveBake->ValidateCurves(Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 10000);
+	}));
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BakedCurve.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "UObject/ObjectKey.h"
+#include "CurveBakeSubsystem.generated.h"
+
+/**
+ * Owns one FBakedCurve per curve asset used in the world, shared by every item
+ * that uses the curve. Baked per world, so a new PIE session picks up curve edits.
+ * Shooter.Curves.Baked switches back to the reference curves, and
+ * Shooter.Curves.SamplesPerSecond sets the bake resolution.
+ */
+UCLASS()
+class SHOOTER_API UCurveBakeSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Baked copy of Curve, baked on first use. The pointer stays valid for the lifetime of the world
+	const FBakedCurve* GetBakedCurve(const UCurveBase* Curve);
+
+	// Convenience for actors caching their baked curves, returns null for a null world or curve
+	static const FBakedCurve* FindBakedCurve(const UObject* WorldContextObject, const UCurveBase* Curve);
+
+	static bool IsBakingEnabled();
+
+	// Baked value when baking is enabled, otherwise the reference curve
+	static float EvaluateFloat(const FBakedCurve* Baked, const class UCurveFloat* Curve, float Time);
+	static FVector EvaluateVector(const FBakedCurve* Baked, const class UCurveVector* Curve, float Time);
+
+	// Bakes every curve again at the current sample rate, in place
+	void RebakeAll();
+
+	// Logs the largest error of every baked curve against its reference over NumTestSamples times, and the cost of each
+	void ValidateCurves(int32 NumTestSamples) const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	TMap<TObjectKey<UCurveBase>, TUniquePtr<FBakedCurve>> BakedCurves;
+};
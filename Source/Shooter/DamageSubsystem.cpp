@@ -0,0 +1,195 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DamageSubsystem.h"
+
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "ShooterProfiling.h"
+#include "Weapon.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/DamageEvents.h"
+#include "Engine/SkeletalMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/DamageType.h"
+#include "PhysicsEngine/BodyInstance.h"
+
+namespace ShooterDamage
+{
+	// Bone of the physics body a trace against Mesh hit, for skeletal meshes Hit.Item is the body index
+	FORCEINLINE int32 GetHitBoneIndex(const USkeletalMeshComponent* Mesh, const FHitResult& Hit)
+	{
+		const FBodyInstance* Body = Mesh->Bodies.IsValidIndex(Hit.Item) ? Mesh->Bodies[Hit.Item] : nullptr;
+		return Body ? Body->InstanceBoneIndex : INDEX_NONE;
+	}
+}
+
+void UDamageSubsystem::Deinitialize()
+{
+	QueuedHits.Empty();
+	ApplyingHits.Empty();
+	HitZoneTables.Empty();
+
+	Super::Deinitialize();
+}
+
+void UDamageSubsystem::Tick(float DeltaTime)
+{
+	ApplyQueuedHits();
+}
+
+TStatId UDamageSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDamageSubsystem, STATGROUP_Tickables);
+}
+
+void UDamageSubsystem::QueueHit(AShooterCharacter* Shooter, const FHitResult& Hit, float BaseDamage)
+{
+	AShooterCharacter* Victim = Cast<AShooterCharacter>(Hit.GetActor());
+	if (Victim == nullptr || Victim == Shooter || BaseDamage <= 0.f) return;
+
+	const USkeletalMeshComponent* Mesh = Victim->GetMesh();
+	FName BoneName{ Hit.BoneName };
+	int32 BoneIndex{ INDEX_NONE };
+	if (Hit.GetComponent() == Mesh)
+	{
+		BoneIndex = ShooterDamage::GetHitBoneIndex(Mesh, Hit);
+	}
+	else if (Hit.TraceStart != Hit.TraceEnd)
+	{
+		// The capsule was hit, find the bone along the same segment. Only the victim's mesh is tested, not the scene
+		FHitResult BoneHit;
+		if (Mesh->LineTraceComponent(BoneHit, Hit.TraceStart, Hit.TraceEnd, FCollisionQueryParams(SCENE_QUERY_STAT(DamageBoneTrace))))
+		{
+			BoneName = BoneHit.BoneName;
+			BoneIndex = ShooterDamage::GetHitBoneIndex(Mesh, BoneHit);
+		}
+	}
+
+	FQueuedHit& QueuedHit = QueuedHits.AddDefaulted_GetRef();
+	QueuedHit.Victim = Victim;
+	QueuedHit.Shooter = Shooter;
+	QueuedHit.BoneName = BoneName;
+	QueuedHit.BoneIndex = BoneIndex;
+	QueuedHit.ImpactPoint = Hit.ImpactPoint;
+	QueuedHit.ShotDirection = (Hit.TraceEnd - Hit.TraceStart).GetSafeNormal();
+	QueuedHit.BaseDamage = BaseDamage;
+
+	INC_DWORD_STAT(STAT_DamageHitsQueued);
+}
+
+void UDamageSubsystem::ApplyQueuedHits()
+{
+	if (QueuedHits.Num() == 0) return;
+
+	SHOOTER_PROFILE_SCOPE(Damage_ApplyQueuedHits);
+
+	// TakeDamage may fire more shots through Blueprint events, those wait for the next batch
+	Swap(QueuedHits, ApplyingHits);
+
+	// Hits on the same victim from the same shooter end up next to each other
+	ApplyingHits.Sort([](const FQueuedHit& A, const FQueuedHit& B)
+	{
+		const UPTRINT VictimA{ reinterpret_cast<UPTRINT>(A.Victim.Get()) };
+		const UPTRINT VictimB{ reinterpret_cast<UPTRINT>(B.Victim.Get()) };
+		if (VictimA != VictimB) return VictimA < VictimB;
+		return reinterpret_cast<UPTRINT>(A.Shooter.Get()) < reinterpret_cast<UPTRINT>(B.Shooter.Get());
+	});
+
+	for (int32 Start = 0; Start < ApplyingHits.Num(); )
+	{
+		AShooterCharacter* Victim = ApplyingHits[Start].Victim.Get();
+		AShooterCharacter* Shooter = ApplyingHits[Start].Shooter.Get();
+
+		int32 End{ Start + 1 };
+		while (End < ApplyingHits.Num() && ApplyingHits[End].Victim.Get() == Victim && ApplyingHits[End].Shooter.Get() == Shooter)
+		{
+			End++;
+		}
+
+		if (Victim)
+		{
+			float TotalDamage{ 0.f };
+			float StrongestDamage{ -1.f };
+			int32 StrongestIndex{ Start };
+			for (int32 Index = Start; Index < End; Index++)
+			{
+				const FQueuedHit& QueuedHit = ApplyingHits[Index];
+				const EHitZone Zone{ FindHitZone(Victim, QueuedHit.BoneIndex) };
+				if (Zone == EHitZone::EHZ_Head)
+				{
+					INC_DWORD_STAT(STAT_DamageHeadshots);
+				}
+
+				const float Damage{ QueuedHit.BaseDamage * Victim->GetHitZoneMultiplier(Zone) };
+				TotalDamage += Damage;
+				if (Damage > StrongestDamage)
+				{
+					StrongestDamage = Damage;
+					StrongestIndex = Index;
+				}
+			}
+
+			// One damage event per victim and shooter, carrying the hit that did the most damage
+			const FQueuedHit& StrongestHit = ApplyingHits[StrongestIndex];
+			FHitResult HitInfo(Victim, Victim->GetMesh(), StrongestHit.ImpactPoint, -StrongestHit.ShotDirection);
+			HitInfo.BoneName = StrongestHit.BoneName;
+			const FPointDamageEvent DamageEvent(TotalDamage, HitInfo, StrongestHit.ShotDirection, UDamageType::StaticClass());
+
+			AActor* DamageCauser = Shooter ? static_cast<AActor*>(Shooter->GetEquippedWeapon()) : nullptr;
+			Victim->TakeDamage(TotalDamage, DamageEvent, Shooter ? Shooter->GetController() : nullptr, DamageCauser ? DamageCauser : Shooter);
+
+			++NumDamageEvents;
+			INC_DWORD_STAT(STAT_DamageEvents);
+		}
+
+		NumHitsApplied += End - Start;
+		INC_DWORD_STAT_BY(STAT_DamageHitsProcessed, End - Start);
+		Start = End;
+	}
+
+	ApplyingHits.Reset();
+}
+
+EHitZone UDamageSubsystem::FindHitZone(const AShooterCharacter* Victim, int32 BoneIndex)
+{
+	const USkeletalMeshComponent* MeshComponent = Victim->GetMesh();
+	const USkeletalMesh* Mesh = MeshComponent ? MeshComponent->GetSkeletalMeshAsset() : nullptr;
+	if (Mesh == nullptr || BoneIndex == INDEX_NONE) return EHitZone::EHZ_Torso;
+
+	const FHitZoneTable& Table = FindOrBuildTable(Victim, Mesh);
+	return Table.ZonesByBone.IsValidIndex(BoneIndex) ? Table.ZonesByBone[BoneIndex] : EHitZone::EHZ_Torso;
+}
+
+bool UDamageSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+const FHitZoneTable& UDamageSubsystem::FindOrBuildTable(const AShooterCharacter* Victim, const USkeletalMesh* Mesh)
+{
+	if (const FHitZoneTable* Table = HitZoneTables.Find(Mesh))
+	{
+		return *Table;
+	}
+
+	// Built from the first character seen with this mesh, characters sharing a mesh share its zones
+	FHitZoneTable& Table = HitZoneTables.Add(Mesh);
+	const FReferenceSkeleton& RefSkeleton = Mesh->GetRefSkeleton();
+	const TMap<FName, EHitZone>& HitZoneBones = Victim->GetHitZoneBones();
+
+	// Parents come before their children, so every bone not listed itself takes its parent's zone
+	Table.ZonesByBone.SetNumUninitialized(RefSkeleton.GetNum());
+	for (int32 BoneIndex = 0; BoneIndex < RefSkeleton.GetNum(); BoneIndex++)
+	{
+		if (const EHitZone* Zone = HitZoneBones.Find(RefSkeleton.GetBoneName(BoneIndex)))
+		{
+			Table.ZonesByBone[BoneIndex] = *Zone;
+			continue;
+		}
+
+		const int32 ParentIndex{ RefSkeleton.GetParentIndex(BoneIndex) };
+		Table.ZonesByBone[BoneIndex] = ParentIndex != INDEX_NONE ? Table.ZonesByBone[ParentIndex] : EHitZone::EHZ_Torso;
+	}
+	return Table;
+}
@@ -0,0 +1,78 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HitZone.h"
+#include "DamageSubsystem.generated.h"
+
+class AShooterCharacter;
+class USkeletalMesh;
+
+// Hit zone of every bone of one skeletal mesh, indexed by bone index
+struct FHitZoneTable
+{
+	TArray<EHitZone> ZonesByBone;
+};
+
+// A bullet hit waiting for the end of the frame
+struct FQueuedHit
+{
+	TWeakObjectPtr<AShooterCharacter> Victim;
+	TWeakObjectPtr<AShooterCharacter> Shooter;
+	FName BoneName;
+
+	// Bone of the physics body that was hit, INDEX_NONE if no body was
+	int32 BoneIndex;
+	FVector ImpactPoint;
+	FVector ShotDirection;
+	float BaseDamage;
+};
+
+/**
+ * Applies the damage of bullet hits on the server. Hits are queued as they are resolved during
+ * the frame and applied together at the end of it: the hits on one victim from one shooter are
+ * summed into a single TakeDamage call. Each hit's damage is scaled by the victim's multiplier for
+ * the zone the hit bone is in, looked up by the hit body's bone index in a table built once per
+ * skeletal mesh from the character's HitZoneBones. No bone names are compared per hit.
+ */
+UCLASS()
+class SHOOTER_API UDamageSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Queues the damage of a bullet Shooter fired, ignored unless Hit is on another AShooterCharacter
+	void QueueHit(AShooterCharacter* Shooter, const FHitResult& Hit, float BaseDamage);
+
+	// Applies the queued hits now instead of at the end of the frame
+	void ApplyQueuedHits();
+
+	// Zone of the bone at BoneIndex on Victim's mesh, torso for bones the table doesn't know
+	EHitZone FindHitZone(const AShooterCharacter* Victim, int32 BoneIndex);
+
+	FORCEINLINE int64 GetNumHitsApplied() const { return NumHitsApplied; }
+	FORCEINLINE int64 GetNumDamageEvents() const { return NumDamageEvents; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	const FHitZoneTable& FindOrBuildTable(const AShooterCharacter* Victim, const USkeletalMesh* Mesh);
+
+	TArray<FQueuedHit> QueuedHits;
+
+	// The batch being applied, swapped with QueuedHits
+	TArray<FQueuedHit> ApplyingHits;
+
+	TMap<TWeakObjectPtr<const USkeletalMesh>, FHitZoneTable> HitZoneTables;
+
+	// Totals since the world started, for the simulation commandlet's report
+	int64 NumHitsApplied{ 0 };
+	int64 NumDamageEvents{ 0 };
+};
@@ -0,0 +1,301 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "DormantItemSubsystem.h"
+
+#include "Item.h"
+#include "ItemRegistrySubsystem.h"
+#include "Shooter.h"
+#include "ShooterProfiling.h"
+#include "Components/InstancedStaticMeshComponent.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarItemsDormant(
+	TEXT("Shooter.Items.Dormant"),
+	0,
+	TEXT("1 draws pickups no player is near as mesh instances and unregisters their components.\n")
+	TEXT("Only items with a DormantMesh take part."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarItemsDormantWakeDistance(
+	TEXT("Shooter.Items.DormantWakeDistance"),
+	500.f,
+	TEXT("Distance beyond an item's pickup radius at which a pawn wakes the item up."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarItemsDormantHysteresis(
+	TEXT("Shooter.Items.DormantHysteresis"),
+	250.f,
+	TEXT("Extra distance a pawn has to move away before an awake item goes dormant again."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarItemsDormantUpdateInterval(
+	TEXT("Shooter.Items.DormantUpdateInterval"),
+	0.1f,
+	TEXT("Seconds between dormancy updates."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarItemsDormantMaxPerUpdate(
+	TEXT("Shooter.Items.DormantMaxPerUpdate"),
+	256,
+	TEXT("Maximum number of items put to sleep per update, spreads the cost when a large loot field first goes dormant.\n")
+	TEXT("Waking items up is never limited."),
+	ECVF_Default);
+
+// Per-instance custom data: glow color RGB and the rarity index
+static constexpr int32 DormantCustomDataFloats{ 4 };
+
+void UDormantItemSubsystem::Deinitialize()
+{
+	Batches.Empty();
+	DormantInstances.Empty();
+	AwakeItems.Empty();
+	InstanceOwner = nullptr;
+
+	Super::Deinitialize();
+}
+
+void UDormantItemSubsystem::Tick(float DeltaTime)
+{
+	if (CVarItemsDormant.GetValueOnGameThread() == 0)
+	{
+		if (DormantInstances.Num() > 0)
+		{
+			WakeUpAll();
+		}
+		return;
+	}
+
+	TimeSinceUpdate += DeltaTime;
+	if (TimeSinceUpdate < CVarItemsDormantUpdateInterval.GetValueOnGameThread()) return;
+	TimeSinceUpdate = 0.f;
+
+	UpdateDormancy();
+
+	SET_DWORD_STAT(STAT_ItemsDormant, DormantInstances.Num());
+	SET_DWORD_STAT(STAT_ItemsAwake, AwakeItems.Num());
+}
+
+TStatId UDormantItemSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UDormantItemSubsystem, STATGROUP_Tickables);
+}
+
+void UDormantItemSubsystem::AddItem(AItem* Item)
+{
+	if (Item && !Item->IsDormant())
+	{
+		AwakeItems.Add(Item);
+	}
+}
+
+void UDormantItemSubsystem::RemoveItem(AItem* Item, bool bWakeUp)
+{
+	AwakeItems.Remove(Item);
+	if (!DormantInstances.Contains(Item)) return;
+
+	RemoveInstance(Item);
+	if (bWakeUp)
+	{
+		Item->SetDormant(false);
+	}
+}
+
+void UDormantItemSubsystem::UpdateDormancy()
+{
+	SHOOTER_PROFILE_SCOPE(DormantItem_UpdateDormancy);
+
+	const UItemRegistrySubsystem* ItemRegistry = GetWorld()->GetSubsystem<UItemRegistrySubsystem>();
+	if (ItemRegistry == nullptr) return;
+
+	const float WakeDistance{ CVarItemsDormantWakeDistance.GetValueOnGameThread() };
+	const float SleepDistance{ WakeDistance + FMath::Max(CVarItemsDormantHysteresis.GetValueOnGameThread(), 0.f) };
+
+	// Servers wake items for every player, clients for their local players
+	ItemsToKeepAwake.Reset();
+	for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+	{
+		const APlayerController* PlayerController = It->Get();
+		const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr;
+		if (Pawn == nullptr) continue;
+
+		const FVector PawnLocation{ Pawn->GetActorLocation() };
+
+		NearbyItems.Reset();
+		ItemRegistry->QueryItemsInRange(PawnLocation, WakeDistance, NearbyItems);
+		for (AItem* Item : NearbyItems)
+		{
+			if (Item->IsDormant())
+			{
+				WakeUp(Item);
+			}
+		}
+
+		NearbyItems.Reset();
+		ItemRegistry->QueryItemsInRange(PawnLocation, SleepDistance, NearbyItems);
+		ItemsToKeepAwake.Append(NearbyItems);
+	}
+
+	const int32 MaxPerUpdate{ CVarItemsDormantMaxPerUpdate.GetValueOnGameThread() };
+	ItemsToSleep.Reset();
+	for (AItem* Item : AwakeItems)
+	{
+		if (ItemsToSleep.Num() >= MaxPerUpdate) break;
+		if (!ItemsToKeepAwake.Contains(Item))
+		{
+			ItemsToSleep.Add(Item);
+		}
+	}
+
+	for (AItem* Item : ItemsToSleep)
+	{
+		MakeDormant(Item);
+	}
+}
+
+bool UDormantItemSubsystem::MakeDormant(AItem* Item)
+{
+	FTransform Transform;
+	UStaticMesh* Mesh = Item->GetDormantMesh(Transform);
+	if (Mesh == nullptr)
+	{
+		// Added again when the item re-enters the Pickup state or gets a dormant mesh
+		AwakeItems.Remove(Item);
+		return false;
+	}
+
+	// Dedicated servers only need the components unregistered
+	if (GetWorld()->GetNetMode() != NM_DedicatedServer)
+	{
+		FDormantMeshBatch& Batch = FindOrAddBatch(Mesh);
+		const int32 Index{ Batch.Component->AddInstance(Transform, true) };
+
+		const FLinearColor GlowColor{ Item->GetGlowColor() };
+		const float CustomData[DormantCustomDataFloats]{ GlowColor.R, GlowColor.G, GlowColor.B, static_cast<float>(Item->GetItemRarity()) };
+		Batch.Component->SetCustomData(Index, MakeArrayView(CustomData));
+
+		Batch.Items.Add(Item);
+		DormantInstances.Add(Item, FDormantInstance{ Mesh, Index });
+	}
+	else
+	{
+		DormantInstances.Add(Item, FDormantInstance{ Mesh, INDEX_NONE });
+	}
+
+	AwakeItems.Remove(Item);
+	Item->SetDormant(true);
+	return true;
+}
+
+void UDormantItemSubsystem::WakeUp(AItem* Item)
+{
+	RemoveInstance(Item);
+	Item->SetDormant(false);
+}
+
+void UDormantItemSubsystem::WakeUpAll()
+{
+	TArray<AItem*> Items;
+	DormantInstances.GetKeys(Items);
+	for (AItem* Item : Items)
+	{
+		WakeUp(Item);
+	}
+}
+
+void UDormantItemSubsystem::RemoveInstance(AItem* Item)
+{
+	FDormantInstance Instance;
+	if (!DormantInstances.RemoveAndCopyValue(Item, Instance) || Instance.Index == INDEX_NONE) return;
+
+	FDormantMeshBatch* Batch = Batches.Find(Instance.Mesh);
+	if (Batch == nullptr || !IsValid(Batch->Component)) return;
+
+	// Fill the hole with the last instance, so no other instance index changes
+	const int32 LastIndex{ Batch->Items.Num() - 1 };
+	if (Instance.Index != LastIndex)
+	{
+		FTransform LastTransform;
+		Batch->Component->GetInstanceTransform(LastIndex, LastTransform, true);
+		Batch->Component->UpdateInstanceTransform(Instance.Index, LastTransform, true, false, true);
+
+		float LastCustomData[DormantCustomDataFloats];
+		FMemory::Memcpy(LastCustomData, &Batch->Component->PerInstanceSMCustomData[LastIndex * DormantCustomDataFloats], sizeof(LastCustomData));
+		Batch->Component->SetCustomData(Instance.Index, MakeArrayView(LastCustomData));
+
+		AItem* MovedItem = Batch->Items[LastIndex];
+		Batch->Items[Instance.Index] = MovedItem;
+		DormantInstances.FindChecked(MovedItem).Index = Instance.Index;
+	}
+
+	Batch->Items.Pop(false);
+	Batch->Component->RemoveInstance(LastIndex);
+}
+
+FDormantMeshBatch& UDormantItemSubsystem::FindOrAddBatch(UStaticMesh* Mesh)
+{
+	if (InstanceOwner == nullptr)
+	{
+		FActorSpawnParameters SpawnParameters;
+		SpawnParameters.Name = TEXT("DormantItemInstances");
+		SpawnParameters.ObjectFlags |= RF_Transient;
+		SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+		InstanceOwner = GetWorld()->SpawnActor<AActor>(AActor::StaticClass(), FTransform::Identity, SpawnParameters);
+
+		// Movable like the batches attached to it, their instances are added, removed and recolored at runtime
+		USceneComponent* Root = NewObject<USceneComponent>(InstanceOwner, TEXT("Root"));
+		Root->SetMobility(EComponentMobility::Movable);
+		InstanceOwner->SetRootComponent(Root);
+		Root->RegisterComponent();
+	}
+
+	FDormantMeshBatch& Batch = Batches.FindOrAdd(Mesh);
+	if (Batch.Component == nullptr)
+	{
+		UInstancedStaticMeshComponent* Component = NewObject<UInstancedStaticMeshComponent>(InstanceOwner);
+		Component->SetMobility(EComponentMobility::Movable);
+		Component->SetStaticMesh(Mesh);
+		Component->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		Component->SetGenerateOverlapEvents(false);
+		Component->SetCanEverAffectNavigation(false);
+		Component->NumCustomDataFloats = DormantCustomDataFloats;
+		Component->SetupAttachment(InstanceOwner->GetRootComponent());
+		Component->RegisterComponent();
+		InstanceOwner->AddInstanceComponent(Component);
+
+		Batch.Component = Component;
+		INC_DWORD_STAT(STAT_DormantMeshBatches);
+	}
+	return Batch;
+}
+
+void UDormantItemSubsystem::LogReport() const
+{
+	UE_LOG(LogShooter, Log, TEXT("Dormant items: %d, awake pickups: %d, instanced components: %d"),
+		DormantInstances.Num(), AwakeItems.Num(), Batches.Num());
+
+	for (const TPair<UStaticMesh*, FDormantMeshBatch>& Batch : Batches)
+	{
+		UE_LOG(LogShooter, Log, TEXT("  %-40s %6d instances"), *GetNameSafe(Batch.Key), Batch.Value.Items.Num());
+	}
+}
+
+bool UDormantItemSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+static FAutoConsoleCommandWithWorld DormantItemReportCommand(
+	TEXT("Shooter.Items.DormantReport"),
+	TEXT("Logs how many pickups are dormant and the instance count of every dormant mesh."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		const UDormantItemSubsystem* DormantItems = World ? World->GetSubsystem<UDormantItemSubsystem>() : nullptr;
+		if (DormantItems == nullptr) return;
+
+		DormantItems->LogReport();
+	}));
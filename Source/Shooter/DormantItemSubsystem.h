@@ -0,0 +1,98 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "DormantItemSubsystem.generated.h"
+
+class AItem;
+class UInstancedStaticMeshComponent;
+
+// Instances of one dormant mesh, instance i stands in for Items[i]
+USTRUCT()
+struct FDormantMeshBatch
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	UInstancedStaticMeshComponent* Component{ nullptr };
+
+	UPROPERTY()
+	TArray<AItem*> Items;
+};
+
+// Where a dormant item's instance lives
+struct FDormantInstance
+{
+	UStaticMesh* Mesh;
+	int32 Index;
+};
+
+/**
+ * Draws pickups that no character is near as instances of their dormant mesh, one instanced
+ * static mesh component per mesh, with the rarity glow color in the per-instance custom data.
+ * A dormant item keeps its actor and replicated state but has no registered primitive components.
+ * Items wake up when a player's pawn comes within their pickup radius plus
+ * Shooter.Items.DormantWakeDistance, found through the item registry, and go dormant again
+ * once every pawn is further than that plus Shooter.Items.DormantHysteresis.
+ */
+UCLASS()
+class SHOOTER_API UDormantItemSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Called when an item enters the Pickup state. It stays awake until an update finds no pawn near it
+	void AddItem(AItem* Item);
+
+	// Called when an item leaves the Pickup state or play. Wakes the item up unless it is leaving play
+	void RemoveItem(AItem* Item, bool bWakeUp = true);
+
+	// Logs the dormant and awake item counts and the instances per mesh
+	void LogReport() const;
+
+	FORCEINLINE int32 GetNumDormantItems() const { return DormantInstances.Num(); }
+	FORCEINLINE int32 GetNumAwakeItems() const { return AwakeItems.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void UpdateDormancy();
+
+	// Returns false if the item has no dormant mesh
+	bool MakeDormant(AItem* Item);
+
+	void WakeUp(AItem* Item);
+
+	void WakeUpAll();
+
+	// Removes the item's instance, moving the last instance of the batch into its place
+	void RemoveInstance(AItem* Item);
+
+	FDormantMeshBatch& FindOrAddBatch(UStaticMesh* Mesh);
+
+	// Owns the instanced components
+	UPROPERTY()
+	AActor* InstanceOwner{ nullptr };
+
+	UPROPERTY()
+	TMap<UStaticMesh*, FDormantMeshBatch> Batches;
+
+	TMap<AItem*, FDormantInstance> DormantInstances;
+
+	// Items in the Pickup state with their components registered
+	TSet<AItem*> AwakeItems;
+
+	// Scratch containers for UpdateDormancy
+	TArray<AItem*> NearbyItems;
+	TSet<AItem*> ItemsToKeepAwake;
+	TArray<AItem*> ItemsToSleep;
+
+	float TimeSinceUpdate{ 0.f };
+};
@@ -0,0 +1,129 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "EmitterPoolSubsystem.h"
+
+#include "Shooter.h"
+#include "Engine/Engine.h"
+#include "Engine/World.h"
+#include "GameFramework/WorldSettings.h"
+#include "HAL/IConsoleManager.h"
+#include "Kismet/GameplayStatics.h"
+#include "Particles/ParticleSystem.h"
+#include "Particles/ParticleSystemComponent.h"
+
+static TAutoConsoleVariable<int32> CVarEmitterPoolMaxPerTemplate(
+	TEXT("Shooter.EmitterPool.MaxPerTemplate"),
+	16,
+	TEXT("Maximum number of pooled particle components per particle template.\n")
+	TEXT("When all of them are playing, the oldest one is restarted.\n")
+	TEXT("0: Pooling disabled, every effect spawns a new component."),
+	ECVF_Default);
+
+void UEmitterPoolSubsystem::Deinitialize()
+{
+	for (TPair<UParticleSystem*, FEmitterRing>& Ring : Rings)
+	{
+		for (UParticleSystemComponent* Component : Ring.Value.Components)
+		{
+			if (IsValid(Component))
+			{
+				Component->DestroyComponent();
+			}
+		}
+	}
+	Rings.Empty();
+
+	Super::Deinitialize();
+}
+
+UParticleSystemComponent* UEmitterPoolSubsystem::SpawnEmitter(UParticleSystem* Template, const FTransform& Transform)
+{
+	if (Template == nullptr) return nullptr;
+
+	const int32 MaxPerTemplate = CVarEmitterPoolMaxPerTemplate.GetValueOnGameThread();
+	if (MaxPerTemplate <= 0)
+	{
+		INC_DWORD_STAT(STAT_EmitterComponentsCreated);
+		++NumCreated;
+		return UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), Template, Transform);
+	}
+
+	FEmitterRing& Ring = Rings.FindOrAdd(Template);
+
+	// Drop components destroyed behind our back, e.g. by a level unload
+	Ring.Components.RemoveAll([](const UParticleSystemComponent* Component) { return !IsValid(Component); });
+	if (Ring.NextIndex >= Ring.Components.Num())
+	{
+		Ring.NextIndex = 0;
+	}
+
+	if (Ring.Components.Num() > 0)
+	{
+		UParticleSystemComponent* Oldest = Ring.Components[Ring.NextIndex];
+
+		// Reuse the oldest component if it has finished, or if the ring can't grow
+		if (!Oldest->IsActive() || Ring.Components.Num() >= MaxPerTemplate)
+		{
+			Ring.NextIndex = (Ring.NextIndex + 1) % Ring.Components.Num();
+
+			Oldest->SetWorldTransform(Transform);
+			Oldest->Activate(true);
+
+			INC_DWORD_STAT(STAT_EmitterComponentsReused);
+			++NumReused;
+			return Oldest;
+		}
+	}
+
+	UParticleSystemComponent* Component = CreateComponent(Template, Transform);
+	if (Component)
+	{
+		// The new component is the newest, so it goes just before the oldest
+		Ring.Components.Insert(Component, Ring.NextIndex);
+		Ring.NextIndex = (Ring.NextIndex + 1) % Ring.Components.Num();
+	}
+	return Component;
+}
+
+UParticleSystemComponent* UEmitterPoolSubsystem::SpawnEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* Template, const FTransform& Transform)
+{
+	INC_DWORD_STAT(STAT_ShooterEmittersSpawned);
+
+	UWorld* World = GEngine->GetWorldFromContextObject(WorldContextObject, EGetWorldErrorMode::LogAndReturnNull);
+	if (World == nullptr) return nullptr;
+
+	if (UEmitterPoolSubsystem* EmitterPool = World->GetSubsystem<UEmitterPoolSubsystem>())
+	{
+		return EmitterPool->SpawnEmitter(Template, Transform);
+	}
+	return UGameplayStatics::SpawnEmitterAtLocation(World, Template, Transform);
+}
+
+bool UEmitterPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+UParticleSystemComponent* UEmitterPoolSubsystem::CreateComponent(UParticleSystem* Template, const FTransform& Transform)
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr) return nullptr;
+
+	UParticleSystemComponent* Component = NewObject<UParticleSystemComponent>(World->GetWorldSettings());
+	Component->bAutoActivate = false;
+	// Pooled components live until the world goes away
+	Component->bAutoDestroy = false;
+	Component->bAllowAnyoneToDestroyMe = true;
+	Component->SetTemplate(Template);
+	Component->SetUsingAbsoluteLocation(true);
+	Component->SetUsingAbsoluteRotation(true);
+	Component->SetUsingAbsoluteScale(true);
+	Component->SetWorldTransform(Transform);
+	Component->RegisterComponentWithWorld(World);
+	Component->Activate(true);
+
+	INC_DWORD_STAT(STAT_EmitterComponentsCreated);
+	++NumCreated;
+	return Component;
+}
@@ -0,0 +1,60 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "EmitterPoolSubsystem.generated.h"
+
+class UParticleSystem;
+class UParticleSystemComponent;
+
+// Reusable components for one particle template, oldest first starting at NextIndex
+USTRUCT()
+struct FEmitterRing
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<UParticleSystemComponent*> Components;
+
+	int32 NextIndex{ 0 };
+};
+
+/**
+ * Ring buffers of particle components for the fire, impact and beam effects.
+ * Each template gets up to Shooter.EmitterPool.MaxPerTemplate components; once the ring
+ * is full the oldest component is restarted at the new location instead of creating one.
+ */
+UCLASS()
+class SHOOTER_API UEmitterPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Plays Template at Transform using a pooled component
+	UParticleSystemComponent* SpawnEmitter(UParticleSystem* Template, const FTransform& Transform);
+
+	// Uses the world's pool if there is one, otherwise UGameplayStatics::SpawnEmitterAtLocation
+	static UParticleSystemComponent* SpawnEmitterAtLocation(const UObject* WorldContextObject, UParticleSystem* Template, const FTransform& Transform);
+
+	FORCEINLINE int32 GetNumCreated() const { return NumCreated; }
+	FORCEINLINE int32 GetNumReused() const { return NumReused; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	UParticleSystemComponent* CreateComponent(UParticleSystem* Template, const FTransform& Transform);
+
+	UPROPERTY()
+	TMap<UParticleSystem*, FEmitterRing> Rings;
+
+	// Components created since the world started
+	int32 NumCreated{ 0 };
+
+	// Times an existing component was restarted instead of creating one
+	int32 NumReused{ 0 };
+};
@@ -0,0 +1,113 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+/**
+ * Fixed size array with one element per value of a contiguous UENUM, indexed by the enum itself.
+ * MaxValue is the enum's _MAX entry. Stands in for small TMap<EnumType, ValueType> maps: lookups
+ * are an array index instead of a hash, and every key always has a value.
+ *
+ * Not a UPROPERTY type, so expose it to Blueprints through UFUNCTION accessors that take the enum.
+ */
+template<typename EnumType, typename ValueType, EnumType MaxValue>
+class TEnumIndexedArray
+{
+	static_assert(TIsEnum<EnumType>::Value, "TEnumIndexedArray must be indexed by an enum");
+
+public:
+	static constexpr int32 Num() { return static_cast<int32>(MaxValue); }
+
+	TEnumIndexedArray()
+		: Elements()
+	{
+	}
+
+	explicit TEnumIndexedArray(const ValueType& InitialValue)
+	{
+		Fill(InitialValue);
+	}
+
+	FORCEINLINE static bool IsValidIndex(EnumType Index)
+	{
+		return static_cast<int32>(Index) >= 0 && static_cast<int32>(Index) < Num();
+	}
+
+	FORCEINLINE ValueType& operator[](EnumType Index)
+	{
+		checkSlow(IsValidIndex(Index));
+		return Elements[static_cast<int32>(Index)];
+	}
+
+	FORCEINLINE const ValueType& operator[](EnumType Index) const
+	{
+		checkSlow(IsValidIndex(Index));
+		return Elements[static_cast<int32>(Index)];
+	}
+
+	// Element for Index, or nullptr if Index is out of range (e.g. the _MAX entry)
+	FORCEINLINE ValueType* Find(EnumType Index)
+	{
+		return IsValidIndex(Index) ? &Elements[static_cast<int32>(Index)] : nullptr;
+	}
+
+	FORCEINLINE const ValueType* Find(EnumType Index) const
+	{
+		return IsValidIndex(Index) ? &Elements[static_cast<int32>(Index)] : nullptr;
+	}
+
+	// Element for Index, or Default if Index is out of range
+	FORCEINLINE ValueType FindRef(EnumType Index, const ValueType& Default = ValueType()) const
+	{
+		return IsValidIndex(Index) ? Elements[static_cast<int32>(Index)] : Default;
+	}
+
+	void Fill(const ValueType& Value)
+	{
+		for (ValueType& Element : Elements)
+		{
+			Element = Value;
+		}
+	}
+
+	bool operator==(const TEnumIndexedArray& Other) const
+	{
+		for (int32 i = 0; i < Num(); i++)
+		{
+			if (!(Elements[i] == Other.Elements[i])) return false;
+		}
+		return true;
+	}
+
+	bool operator!=(const TEnumIndexedArray& Other) const { return !(*this == Other); }
+
+	FORCEINLINE ValueType* begin() { return Elements; }
+	FORCEINLINE ValueType* end() { return Elements + Num(); }
+	FORCEINLINE const ValueType* begin() const { return Elements; }
+	FORCEINLINE const ValueType* end() const { return Elements + Num(); }
+
+	// Writes the element count first so data saved before an enum grew still loads
+	friend FArchive& operator<<(FArchive& Ar, TEnumIndexedArray& Array)
+	{
+		int32 SerializedNum{ Num() };
+		Ar << SerializedNum;
+		for (int32 i = 0; i < SerializedNum; i++)
+		{
+			if (i < Num())
+			{
+				Ar << Array.Elements[i];
+			}
+			else
+			{
+				// Entry for an enum value that no longer exists
+				ValueType Discarded{};
+				Ar << Discarded;
+			}
+		}
+		return Ar;
+	}
+
+private:
+	ValueType Elements[static_cast<int32>(MaxValue)];
+};
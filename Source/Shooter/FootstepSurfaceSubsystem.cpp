@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "FootstepSurfaceSubsystem.h"
+
+#include "Shooter.h"
+#include "Components/PrimitiveComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/Character.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+#include "PhysicalMaterials/PhysicalMaterial.h"
+
+static TAutoConsoleVariable<int32> CVarFootstepsSurfaceCache(
+	TEXT("Shooter.Footsteps.SurfaceCache"),
+	1,
+	TEXT("1 takes footstep surfaces from the movement floor and caches them per floor primitive.\n")
+	TEXT("0 traces the scene on every footstep."),
+	ECVF_Default);
+
+// Stale floors are dropped from the cache once it grows past this
+static constexpr int32 MaxCachedSurfaces{ 1024 };
+
+void UFootstepSurfaceSubsystem::Deinitialize()
+{
+	Surfaces.Empty();
+
+	Super::Deinitialize();
+}
+
+EPhysicalSurface UFootstepSurfaceSubsystem::GetFloorSurface(const ACharacter* Character)
+{
+	if (Character == nullptr) return SurfaceType_Default;
+
+	UWorld* World = Character->GetWorld();
+	UFootstepSurfaceSubsystem* FootstepSurfaces = World ? World->GetSubsystem<UFootstepSurfaceSubsystem>() : nullptr;
+
+	EPhysicalSurface Surface{ SurfaceType_Default };
+	if (FootstepSurfaces && CVarFootstepsSurfaceCache.GetValueOnGameThread() != 0 && FootstepSurfaces->FindFloorSurface(Character, Surface))
+	{
+		return Surface;
+	}
+	return TraceSurface(Character);
+}
+
+void UFootstepSurfaceSubsystem::ClearCache()
+{
+	Surfaces.Reset();
+}
+
+bool UFootstepSurfaceSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UFootstepSurfaceSubsystem::FindFloorSurface(const ACharacter* Character, EPhysicalSurface& OutSurface)
+{
+	const UCharacterMovementComponent* CharacterMovement = Character->GetCharacterMovement();
+	if (CharacterMovement == nullptr) return false;
+
+	const FFindFloorResult& Floor{ CharacterMovement->CurrentFloor };
+	const UPrimitiveComponent* FloorComponent = Floor.HitResult.GetComponent();
+	if (!Floor.IsWalkableFloor() || FloorComponent == nullptr) return false;
+
+	if (const EPhysicalSurface* CachedSurface = Surfaces.Find(FloorComponent))
+	{
+		INC_DWORD_STAT(STAT_FootstepSurfaceCacheHits);
+		OutSurface = *CachedSurface;
+		return true;
+	}
+
+	// New base. The floor sweep does not return physical materials, so trace this one component
+	// across the floor impact point, which is not a scene query
+	FHitResult HitResult;
+	const FVector ImpactPoint{ Floor.HitResult.ImpactPoint };
+	const FVector Offset{ Floor.HitResult.ImpactNormal * 10.f };
+	FCollisionQueryParams QueryParams;
+	QueryParams.bReturnPhysicalMaterial = true;
+	const_cast<UPrimitiveComponent*>(FloorComponent)->LineTraceComponent(HitResult, ImpactPoint + Offset, ImpactPoint - Offset, QueryParams);
+	INC_DWORD_STAT(STAT_FootstepSurfaceCacheMisses);
+
+	if (Surfaces.Num() >= MaxCachedSurfaces)
+	{
+		for (auto It = Surfaces.CreateIterator(); It; ++It)
+		{
+			if (!It.Key().IsValid())
+			{
+				It.RemoveCurrent();
+			}
+		}
+	}
+
+	OutSurface = UPhysicalMaterial::DetermineSurfaceType(HitResult.PhysMaterial.Get());
+	Surfaces.Add(FloorComponent, OutSurface);
+	return true;
+}
+
+EPhysicalSurface UFootstepSurfaceSubsystem::TraceSurface(const ACharacter* Character)
+{
+	FHitResult HitResult;
+	const FVector Start{ Character->GetActorLocation() };
+	const FVector End{ Start + FVector(0.f, 0.f, -400.f) };
+	FCollisionQueryParams QueryParams;
+	QueryParams.bReturnPhysicalMaterial = true;
+
+	Character->GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECC_Visibility, QueryParams);
+	INC_DWORD_STAT(STAT_ShooterTraces);
+
+	return UPhysicalMaterial::DetermineSurfaceType(HitResult.PhysMaterial.Get());
+}
+
+static FAutoConsoleCommandWithWorld FootstepSurfaceClearCommand(
+	TEXT("Shooter.Footsteps.ClearSurfaceCache"),
+	TEXT("Forgets the cached footstep surface of every floor primitive."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		UFootstepSurfaceSubsystem* FootstepSurfaces = World ? World->GetSubsystem<UFootstepSurfaceSubsystem>() : nullptr;
+		if (FootstepSurfaces == nullptr) return;
+
+		UE_LOG(LogShooter, Log, TEXT("Footsteps: cleared %d cached surfaces"), FootstepSurfaces->GetNumCachedSurfaces());
+		FootstepSurfaces->ClearCache();
+	}));
@@ -0,0 +1,49 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "FootstepSurfaceSubsystem.generated.h"
+
+class ACharacter;
+class UPrimitiveComponent;
+
+/**
+ * Surface type under a character's feet for footstep notifies, without a scene query per footstep.
+ * The floor comes from the character movement component's CurrentFloor, and the surface of each
+ * floor primitive is cached the first time a character stands on it, with a trace against that
+ * one component. Characters only pay for a lookup until they step onto a new base.
+ */
+UCLASS()
+class SHOOTER_API UFootstepSurfaceSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Surface under Character's feet. Falls back to a downward trace while there is no walkable floor,
+	// and in worlds without the subsystem, like the animation editor's preview.
+	UFUNCTION(BlueprintCallable, Category = Footsteps)
+	static EPhysicalSurface GetFloorSurface(const ACharacter* Character);
+
+	// Forgets every cached surface, for floors whose physical material changed at runtime
+	UFUNCTION(BlueprintCallable, Category = Footsteps)
+	void ClearCache();
+
+	FORCEINLINE int32 GetNumCachedSurfaces() const { return Surfaces.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Surface of the floor Character is standing on, false if it has no walkable floor
+	bool FindFloorSurface(const ACharacter* Character, EPhysicalSurface& OutSurface);
+
+	// The scene trace GetSurfaceType used to make on every footstep
+	static EPhysicalSurface TraceSurface(const ACharacter* Character);
+
+	// Surface per floor primitive
+	TMap<TWeakObjectPtr<const UPrimitiveComponent>, EPhysicalSurface> Surfaces;
+};
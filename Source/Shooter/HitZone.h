@@ -0,0 +1,12 @@
+#pragma once
+
+// Part of a character a bullet hit, see UDamageSubsystem
+UENUM(BlueprintType)
+enum class EHitZone : uint8
+{
+	EHZ_Head UMETA(DisplayName = "Head"),
+	EHZ_Torso UMETA(DisplayName = "Torso"),
+	EHZ_Limb UMETA(DisplayName = "Limb"),
+
+	EHZ_MAX UMETA(DisplayName = "DefaultMAX"),
+};
@@ -0,0 +1,203 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "HitscanSubsystem.h"
+
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarHitscanBatched(
+	TEXT("Shooter.Hitscan.Batched"),
+	1,
+	TEXT("1: Shots are queued and resolved with batched async traces.\n")
+	TEXT("0: Shots trace immediately when fired."),
+	ECVF_Default);
+
+void UHitscanSubsystem::Deinitialize()
+{
+	CrosshairStageShots.Empty();
+	WeaponStageShots.Empty();
+
+	Super::Deinitialize();
+}
+
+bool UHitscanSubsystem::IsBatchingEnabled()
+{
+	return CVarHitscanBatched.GetValueOnGameThread() != 0;
+}
+
+void UHitscanSubsystem::QueueShot(AShooterCharacter* Shooter, const FTransform& MuzzleTransform,
+	const FVector& CrosshairTraceStart, const FVector& CrosshairTraceEnd)
+{
+	UWorld* World = GetWorld();
+	if (Shooter == nullptr || World == nullptr) return;
+
+	FHitscanShot& Shot = CrosshairStageShots.AddDefaulted_GetRef();
+	Shot.Shooter = Shooter;
+	Shot.MuzzleTransform = MuzzleTransform;
+	Shot.CrosshairTraceStart = CrosshairTraceStart;
+	Shot.CrosshairTraceEnd = CrosshairTraceEnd;
+	Shot.BeamTarget = CrosshairTraceEnd;
+	Shot.FireTime = World->GetTimeSeconds();
+	Shot.FireFrame = GFrameCounter;
+
+	// Every async trace requested this frame is run as one batch by the world
+	Shot.CrosshairTraceHandle = World->AsyncLineTraceByChannel(EAsyncTraceType::Single, CrosshairTraceStart, CrosshairTraceEnd, ECC_Visibility);
+	INC_DWORD_STAT(STAT_ShooterTraces);
+
+	INC_DWORD_STAT(STAT_HitscanShotsQueued);
+	INC_DWORD_STAT(STAT_HitscanAsyncTraces);
+}
+
+void UHitscanSubsystem::QueueShotAtTarget(AShooterCharacter* Shooter, const FTransform& MuzzleTransform, const FVector& BeamTarget)
+{
+	UWorld* World = GetWorld();
+	if (Shooter == nullptr || World == nullptr) return;
+
+	FHitscanShot& Shot = WeaponStageShots.AddDefaulted_GetRef();
+	Shot.Shooter = Shooter;
+	Shot.MuzzleTransform = MuzzleTransform;
+	Shot.CrosshairTraceStart = BeamTarget;
+	Shot.CrosshairTraceEnd = BeamTarget;
+	Shot.BeamTarget = BeamTarget;
+	Shot.FireTime = World->GetTimeSeconds();
+	Shot.FireFrame = GFrameCounter;
+
+	SubmitWeaponTrace(Shot);
+
+	INC_DWORD_STAT(STAT_HitscanShotsQueued);
+}
+
+void UHitscanSubsystem::Tick(float DeltaTime)
+{
+	// Barrel results first, so shots advanced by the crosshair stage wait for their own trace
+	UpdateWeaponStage();
+	UpdateCrosshairStage();
+}
+
+void UHitscanSubsystem::UpdateCrosshairStage()
+{
+	UWorld* World = GetWorld();
+
+	for (int32 Index = 0; Index < CrosshairStageShots.Num(); )
+	{
+		FHitscanShot& Shot = CrosshairStageShots[Index];
+
+		FTraceDatum TraceData;
+		if (World->QueryTraceData(Shot.CrosshairTraceHandle, TraceData))
+		{
+			if (TraceData.OutHits.Num() > 0 && TraceData.OutHits[0].bBlockingHit)
+			{
+				// Tentative beam location - still need to trace from gun
+				Shot.BeamTarget = TraceData.OutHits[0].Location;
+			}
+		}
+		else if (World->IsTraceHandleValid(Shot.CrosshairTraceHandle, false))
+		{
+			// Still in flight
+			++Index;
+			continue;
+		}
+		else
+		{
+			// Result was discarded before we read it, fall back to a blocking trace
+			FHitResult CrosshairHit;
+			World->LineTraceSingleByChannel(CrosshairHit, Shot.CrosshairTraceStart, Shot.CrosshairTraceEnd, ECC_Visibility);
+			INC_DWORD_STAT(STAT_ShooterTraces);
+			INC_DWORD_STAT(STAT_HitscanImmediateTraces);
+			if (CrosshairHit.bBlockingHit)
+			{
+				Shot.BeamTarget = CrosshairHit.Location;
+			}
+		}
+
+		SubmitWeaponTrace(Shot);
+		WeaponStageShots.Add(Shot);
+		CrosshairStageShots.RemoveAt(Index, 1, false);
+	}
+}
+
+void UHitscanSubsystem::UpdateWeaponStage()
+{
+	UWorld* World = GetWorld();
+
+	double MaxLatencyMs = 0.0;
+	uint64 MaxLatencyFrames = 0;
+
+	for (int32 Index = 0; Index < WeaponStageShots.Num(); )
+	{
+		FHitscanShot& Shot = WeaponStageShots[Index];
+
+		FHitResult WeaponTraceHit;
+		FTraceDatum TraceData;
+		if (World->QueryTraceData(Shot.WeaponTraceHandle, TraceData))
+		{
+			if (TraceData.OutHits.Num() > 0)
+			{
+				WeaponTraceHit = TraceData.OutHits[0];
+			}
+		}
+		else if (World->IsTraceHandleValid(Shot.WeaponTraceHandle, false))
+		{
+			++Index;
+			continue;
+		}
+		else
+		{
+			const FVector WeaponTraceStart{ Shot.MuzzleTransform.GetLocation()};
+			const FVector WeaponTraceEnd{ WeaponTraceStart + (Shot.BeamTarget - WeaponTraceStart) * 1.25f};
+			World->LineTraceSingleByChannel(WeaponTraceHit, WeaponTraceStart, WeaponTraceEnd, ECC_Visibility);
+			INC_DWORD_STAT(STAT_ShooterTraces);
+			INC_DWORD_STAT(STAT_HitscanImmediateTraces);
+		}
+
+		ResolveShot(Shot, WeaponTraceHit);
+
+		MaxLatencyMs = FMath::Max(MaxLatencyMs, (World->GetTimeSeconds() - Shot.FireTime) * 1000.0);
+		MaxLatencyFrames = FMath::Max(MaxLatencyFrames, GFrameCounter - Shot.FireFrame);
+
+		WeaponStageShots.RemoveAt(Index, 1, false);
+	}
+
+	SET_FLOAT_STAT(STAT_HitscanLatencyMs, MaxLatencyMs);
+	SET_DWORD_STAT(STAT_HitscanLatencyFrames, MaxLatencyFrames);
+}
+
+void UHitscanSubsystem::SubmitWeaponTrace(FHitscanShot& Shot)
+{
+	// Trace outward from gun barrel world location, past the crosshair hit point
+	const FVector WeaponTraceStart{ Shot.MuzzleTransform.GetLocation()};
+	const FVector StartToEnd{ Shot.BeamTarget - WeaponTraceStart};
+	const FVector WeaponTraceEnd{ WeaponTraceStart + StartToEnd * 1.25f};
+
+	Shot.WeaponTraceHandle = GetWorld()->AsyncLineTraceByChannel(EAsyncTraceType::Single, WeaponTraceStart, WeaponTraceEnd, ECC_Visibility);
+	INC_DWORD_STAT(STAT_ShooterTraces);
+	INC_DWORD_STAT(STAT_HitscanAsyncTraces);
+}
+
+void UHitscanSubsystem::ResolveShot(const FHitscanShot& Shot, const FHitResult& WeaponTraceHit)
+{
+	INC_DWORD_STAT(STAT_HitscanShotsResolved);
+
+	AShooterCharacter* Shooter = Shot.Shooter.Get();
+	if (Shooter == nullptr) return;
+
+	// Object between barrel and beam end point
+	if (WeaponTraceHit.bBlockingHit)
+	{
+		Shooter->ResolveBullet(Shot.MuzzleTransform, WeaponTraceHit);
+		Shooter->QueueBulletDamage(WeaponTraceHit);
+	}
+}
+
+TStatId UHitscanSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UHitscanSubsystem, STATGROUP_Tickables);
+}
+
+bool UHitscanSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
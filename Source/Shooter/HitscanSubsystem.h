@@ -0,0 +1,77 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "HitscanSubsystem.generated.h"
+
+// A shot waiting on its crosshair and barrel traces
+struct FHitscanShot
+{
+	// Character that fired the shot
+	TWeakObjectPtr<class AShooterCharacter> Shooter;
+
+	// Barrel socket transform when the shot was fired
+	FTransform MuzzleTransform;
+
+	// Crosshair trace segment, deprojected from the viewport center
+	FVector CrosshairTraceStart;
+	FVector CrosshairTraceEnd;
+
+	// Point the barrel trace aims at, known once the crosshair trace resolves
+	FVector BeamTarget;
+
+	FTraceHandle CrosshairTraceHandle;
+	FTraceHandle WeaponTraceHandle;
+
+	// World time and frame the shot was fired on, used for latency stats
+	double FireTime;
+	uint64 FireFrame;
+};
+
+/**
+ * Collects the shots fired by every AShooterCharacter and resolves them with async traces.
+ * Crosshair traces go into the world's async trace batch for the frame they are fired in,
+ * barrel traces are submitted once the crosshair result is in, and impacts are applied when
+ * the barrel result is ready.
+ */
+UCLASS()
+class SHOOTER_API UHitscanSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// True when shots go through the batched path (Shooter.Hitscan.Batched)
+	static bool IsBatchingEnabled();
+
+	// Called from AShooterCharacter::SendBullet
+	void QueueShot(AShooterCharacter* Shooter, const FTransform& MuzzleTransform, const FVector& CrosshairTraceStart, const FVector& CrosshairTraceEnd);
+
+	// Queues a shot whose crosshair hit is already known, only the barrel trace is submitted
+	void QueueShotAtTarget(AShooterCharacter* Shooter, const FTransform& MuzzleTransform, const FVector& BeamTarget);
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Reads finished crosshair traces and submits the barrel trace for each
+	void UpdateCrosshairStage();
+
+	// Reads finished barrel traces and hands the result back to the shooter
+	void UpdateWeaponStage();
+
+	void SubmitWeaponTrace(FHitscanShot& Shot);
+
+	void ResolveShot(const FHitscanShot& Shot, const FHitResult& WeaponTraceHit);
+
+	// Shots waiting on the crosshair trace
+	TArray<FHitscanShot> CrosshairStageShots;
+
+	// Shots waiting on the barrel trace
+	TArray<FHitscanShot> WeaponStageShots;
+};
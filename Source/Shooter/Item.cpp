@@ -6,17 +6,39 @@
 #include <tiffio.h>
 
 #include "AssetDefinition.h"
+#include "ItemRegistrySubsystem.h"
+#include "ItemTickSubsystem.h"
+#include "CurveBakeSubsystem.h"
+#include "DormantItemSubsystem.h"
+#include "Shooter.h"
 #include "ShooterCharacter.h"
+#include "ShooterDataTableSubsystem.h"
+#include "ShooterProfiling.h"
 #include "Camera/CameraComponent.h"
 #include "Components/BoxComponent.h"
 #include "Components/SphereComponent.h"
 #include "Components/WidgetComponent.h"
 #include "Curves/CurveVector.h"
 #include "DSP/AudioDebuggingUtilities.h"
+#include "HAL/IConsoleManager.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
 #include "Math/UnitConversion.h"
 #include "Sound/SoundCue.h"
 
+static TAutoConsoleVariable<int32> CVarItemsNetDormancy(
+	TEXT("Shooter.Items.NetDormancy"),
+	1,
+	TEXT("1 keeps pickups and pooled items net dormant, flushed once per item state change.\n")
+	TEXT("0 leaves them awake. Takes effect on each item's next state change."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarItemsNetRelevancyGrid(
+	TEXT("Shooter.Items.NetRelevancyGrid"),
+	1,
+	TEXT("1 decides pickup relevancy by item registry cell, 0 uses the engine's per-actor distance check."),
+	ECVF_Default);
+
 // Sets default values
 AItem::AItem():
 ItemName(FString("Default")),
@@ -39,12 +61,32 @@ bCanChangeCustomDepth(true),
 GlowAmount(150.f),
 FresnelExponent(3.f),
 FresnelReflectFraction(4.f),
+LastPulseCurveValue(FVector::ZeroVector),
+bPulseParametersWritten(false),
+BakedZCurve(nullptr),
+BakedScaleCurve(nullptr),
+BakedPulseCurve(nullptr),
+BakedInterpPulseCurve(nullptr),
+PulseStartTime(0.0),
 PulseCurveTime(5.f),
 SlotIndex(0),
-bCharacterInventoryFull(false)
+bCharacterInventoryFull(false),
+DormantMesh(nullptr),
+bDormant(false),
+RegistryCell(FIntPoint::ZeroValue),
+bInItemRegistry(false),
+ActiveItemIndex(INDEX_NONE),
+bTickInterping(false),
+bTickPulsing(false)
 {
- 	// Set this actor to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
-	PrimaryActorTick.bCanEverTick = true;
+ 	// Items don't tick, UItemTickSubsystem updates them while they are interping or pulsing
+	PrimaryActorTick.bCanEverTick = false;
+
+	// The server owns item state, clients follow it through OnRep_ItemState
+	bReplicates = true;
+
+	// Placed pickups are already on every client, see UpdateNetDormancy for spawned ones
+	NetDormancy = DORM_Initial;
 
 	ItemMesh = CreateDefaultSubobject<USkeletalMeshComponent>(TEXT("ItemMesh"));
 	SetRootComponent(ItemMesh);
@@ -59,6 +101,8 @@ bCharacterInventoryFull(false)
 
 	AreaSphere = CreateDefaultSubobject<USphereComponent>(TEXT("AreaSphere"));
 	AreaSphere->SetupAttachment(GetRootComponent());
+	AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+	AreaSphere->SetGenerateOverlapEvents(false);
 }
 
 // Called when the game starts or when spawned
@@ -74,43 +118,162 @@ void AItem::BeginPlay()
 	// Sets ActiveStars array based on item rarity
 	SetActiveStars();
 
-	// Setup Overlap for AreaSphere
-	AreaSphere->OnComponentBeginOverlap.AddDynamic(this, &AItem::OnSphereOverlap);
-	AreaSphere->OnComponentEndOverlap.AddDynamic(this, &AItem::OnSphereEndOverlap);
-
 	// Set item properties based on ItemState
 	SetItemProperties(ItemState);
 
 	//Set custom depth to disabled
 	InitializeCustomDepth();
 
-	StartPulseTimer();
+	CacheBakedCurves();
+
+	StartPulse();
+
+	UpdateItemRegistration();
+
+	// Placed items stay DORM_Initial until their first state change
+	if (!IsNetStartupActor())
+	{
+		UpdateNetDormancy();
+	}
+}
+
+void AItem::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UDormantItemSubsystem* DormantItems = GetWorld()->GetSubsystem<UDormantItemSubsystem>())
+	{
+		DormantItems->RemoveItem(this, false);
+	}
+	if (UItemRegistrySubsystem* ItemRegistry = GetWorld()->GetSubsystem<UItemRegistrySubsystem>())
+	{
+		ItemRegistry->UnregisterItem(this);
+	}
+	if (UItemTickSubsystem* ItemTicker = GetWorld()->GetSubsystem<UItemTickSubsystem>())
+	{
+		ItemTicker->RemoveItem(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void AItem::UpdateItemRegistration()
+{
+	UItemRegistrySubsystem* ItemRegistry = GetWorld()->GetSubsystem<UItemRegistrySubsystem>();
+	UItemTickSubsystem* ItemTicker = GetWorld()->GetSubsystem<UItemTickSubsystem>();
+	UDormantItemSubsystem* DormantItems = GetWorld()->GetSubsystem<UDormantItemSubsystem>();
+
+	if (ItemState == EItemState::EIS_Pickup)
+	{
+		if (ItemRegistry)
+		{
+			ItemRegistry->RegisterItem(this);
+		}
+		// Pulse only matters while the glow material is in use
+		if (ItemTicker && PulseCurve && DynamicMaterialInstance && !bDormant)
+		{
+			ItemTicker->AddPulsingItem(this);
+		}
+		// Goes dormant on the next update if no character is near
+		if (DormantItems)
+		{
+			DormantItems->AddItem(this);
+		}
+	}
+	else
+	{
+		if (ItemRegistry)
+		{
+			ItemRegistry->UnregisterItem(this);
+		}
+		if (ItemTicker)
+		{
+			ItemTicker->RemovePulsingItem(this);
+		}
+		if (DormantItems)
+		{
+			DormantItems->RemoveItem(this);
+		}
+	}
+}
+
+void AItem::UpdateNetDormancy()
+{
+	if (!HasAuthority()) return;
+
+	const bool bAtRest{ ItemState == EItemState::EIS_Pickup || ItemState == EItemState::EIS_Pooled };
+	if (!bAtRest || CVarItemsNetDormancy.GetValueOnGameThread() == 0)
+	{
+		SetNetDormancy(DORM_Awake);
+		return;
+	}
+
+	// A dormant item's channel sends the new state once and goes back to sleep
+	if (NetDormancy > DORM_Awake)
+	{
+		FlushNetDormancy();
+		INC_DWORD_STAT(STAT_NetItemDormancyFlushes);
+	}
+	else
+	{
+		SetNetDormancy(DORM_DormantAll);
+	}
 }
 
-void AItem::OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
-	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult)
+bool AItem::IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const
 {
-	if (OtherActor)
+	if (ItemState == EItemState::EIS_Pickup && !bAlwaysRelevant && CVarItemsNetRelevancyGrid.GetValueOnGameThread() != 0)
 	{
-		AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(OtherActor);
-		if (ShooterCharacter)
+		const UItemRegistrySubsystem* ItemRegistry = GetWorld()->GetSubsystem<UItemRegistrySubsystem>();
+		bool bInRange{ false };
+		if (ItemRegistry && ItemRegistry->IsWithinCellRange(this, SrcLocation, NetCullDistanceSquared, bInRange))
 		{
-			ShooterCharacter->IncrememntOverlappedItemCount(1);
-			ShooterCharacter->UnHighlightInventorySlot();
+			return bInRange;
 		}
 	}
+	return Super::IsNetRelevantFor(RealViewer, ViewTarget, SrcLocation);
+}
+
+UStaticMesh* AItem::GetDormantMesh(FTransform& OutTransform) const
+{
+	OutTransform = ItemMesh->GetComponentTransform();
+	return DormantMesh;
 }
 
-void AItem::OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor,
-	UPrimitiveComponent* OtherComp, int32 OtherBodyIndex)
+void AItem::SetDormant(bool bNewDormant)
 {
-	if (OtherActor)
+	if (bDormant == bNewDormant) return;
+	bDormant = bNewDormant;
+
+	if (bDormant)
+	{
+		if (UItemTickSubsystem* ItemTicker = GetWorld()->GetSubsystem<UItemTickSubsystem>())
+		{
+			ItemTicker->RemovePulsingItem(this);
+		}
+
+		TInlineComponentArray<UPrimitiveComponent*> Primitives(this);
+		for (UPrimitiveComponent* Primitive : Primitives)
+		{
+			if (Primitive->IsRegistered())
+			{
+				Primitive->UnregisterComponent();
+				DormantComponents.Add(Primitive);
+			}
+		}
+	}
+	else
 	{
-		AShooterCharacter* ShooterCharacter = Cast<AShooterCharacter>(OtherActor);
-		if (ShooterCharacter)
+		// Parents were gathered before their children, so attachments register in order
+		for (UPrimitiveComponent* Primitive : DormantComponents)
 		{
-			ShooterCharacter->IncrememntOverlappedItemCount(-1);
+			if (IsValid(Primitive))
+			{
+				Primitive->RegisterComponent();
+			}
 		}
+		DormantComponents.Reset();
+
+		StartPulse();
+		UpdateItemRegistration();
 	}
 }
 
@@ -163,9 +326,9 @@ void AItem::SetItemProperties(EItemState State)
 		ItemMesh->SetVisibility(true);
 		ItemMesh->SetCollisionResponseToAllChannels(ECR_Ignore);
 		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
-		// Set AreaSphere properties
-		AreaSphere->SetCollisionResponseToAllChannels(ECR_Overlap);
-		AreaSphere->SetCollisionEnabled(ECollisionEnabled::QueryOnly);
+		// Set AreaSphere properties, pickup range is handled by the item registry
+		AreaSphere->SetCollisionResponseToAllChannels(ECR_Ignore);
+		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 		// Set CollisionBox properties
 		CollisionBox->SetCollisionResponseToAllChannels(ECR_Ignore); 
 		CollisionBox->SetCollisionResponseToChannel(ECC_Visibility, ECR_Block);
@@ -231,12 +394,31 @@ void AItem::SetItemProperties(EItemState State)
 		CollisionBox->SetCollisionResponseToAllChannels(ECR_Ignore); 
 		CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
 		break;
+	case EItemState::EIS_Pooled:
+		PickupWidget->SetVisibility(false);
+		// Set Mesh properties
+		ItemMesh->SetSimulatePhysics(false);
+		ItemMesh->SetEnableGravity(false);
+		ItemMesh->SetVisibility(false);
+		ItemMesh->SetCollisionResponseToAllChannels(ECR_Ignore);
+		ItemMesh->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		// Set AreaSphere properties
+		AreaSphere->SetCollisionResponseToAllChannels(ECR_Ignore);
+		AreaSphere->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		// Set CollisionBox properties
+		CollisionBox->SetCollisionResponseToAllChannels(ECR_Ignore); 
+		CollisionBox->SetCollisionEnabled(ECollisionEnabled::NoCollision);
+		break;
 	}
 }
 
 void AItem::FinishInterping()
 {
 	bInterping = false;
+	if (UItemTickSubsystem* ItemTicker = GetWorld()->GetSubsystem<UItemTickSubsystem>())
+	{
+		ItemTicker->RemoveInterpingItem(this);
+	}
 	if (Character)
 	{
 		// Subtract 1 from the ItemCount from the interp location struct
@@ -255,16 +437,18 @@ void AItem::FinishInterping()
 
 void AItem::ItemInterp(float DeltaTime)
 {
+	SHOOTER_PROFILE_SCOPE(Item_ItemInterp);
+
 	if (!bInterping)
 	{
 		return;
 	}
 	if (Character && ItemZCurve)
 	{
-		// Elapsed time since we started ItemInterp timer
-		const float ElapsedTime = GetWorldTimerManager().GetTimerElapsed(ItemInterpTimer);
+		// Elapsed time since we started interping
+		const float ElapsedTime = Clock.GetElapsed(EItemClockEvent::EICE_Interp, GetWorld()->GetTimeSeconds());
 		// Get Curve value corresponding to ElapsedTime
-		const float CurveValue = ItemZCurve->GetFloatValue(ElapsedTime);
+		const float CurveValue = UCurveBakeSubsystem::EvaluateFloat(BakedZCurve, ItemZCurve, ElapsedTime);
 
 		// Get the item's intial location when the curve started
 		FVector ItemLocation = ItemInterpStartLocation;
@@ -296,7 +480,7 @@ void AItem::ItemInterp(float DeltaTime)
 
 		if (ItemScaleCurve)
 		{
-			const float ScaleCurveValue = ItemScaleCurve->GetFloatValue(ElapsedTime);
+			const float ScaleCurveValue = UCurveBakeSubsystem::EvaluateFloat(BakedScaleCurve, ItemScaleCurve, ElapsedTime);
 			SetActorScale3D(FVector(ScaleCurveValue, ScaleCurveValue, ScaleCurveValue));
 		}
 	}
@@ -363,36 +547,11 @@ void AItem::InitializeCustomDepth()
 
 void AItem::OnConstruction(const FTransform& Transform)
 {
-	// Load the data in the ItemRarity Data table
-	// Path to the Item Rarity data table
-	FString RarityTablePath(TEXT("/Script/Engine.DataTable'/Game/_Game/DataTable/ItemRarityDataTable.ItemRarityDataTable'"));
-	UDataTable* RarityTableObject = Cast<UDataTable>(StaticLoadObject(UDataTable::StaticClass(), nullptr, *RarityTablePath) );
-	
-	if (RarityTableObject)
+	// Rarity rows are cached by enum value, no table load or row name lookup here
+	UShooterDataTableSubsystem* DataTables = UShooterDataTableSubsystem::Get();
+	if (DataTables)
 	{
-		FItemRarityTable* RarityRow = nullptr;
-		switch (ItemRarity)
-		{
-		case EItemRarity::EIR_Damaged:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName("Damaged"), TEXT(""));
-			break;
-			
-		case EItemRarity::EIR_Common:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName("Common"), TEXT(""));
-			break;
-			
-		case EItemRarity::EIR_Uncommon:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName("Uncommon"), TEXT(""));
-			break;
-			
-		case EItemRarity::EIR_Rare:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName("Rare"), TEXT(""));
-			break;
-			
-		case EItemRarity::EIR_Legendary:
-			RarityRow = RarityTableObject->FindRow<FItemRarityTable>(FName("Legendary"), TEXT(""));
-			break;
-		}
+		const FItemRarityTable* RarityRow = DataTables->GetRarityRow(ItemRarity);
 		if (RarityRow)
 		{
 			GlowColor = RarityRow->GlowColor;
@@ -425,28 +584,53 @@ void AItem::EnableGlowMaterial()
 	}
 }
 
-void AItem::UpdatePulse()
+void AItem::CacheBakedCurves()
 {
-	float ElapsedTime{};
-	FVector CurveValue{};
-	
+	BakedZCurve = UCurveBakeSubsystem::FindBakedCurve(this, ItemZCurve);
+	BakedScaleCurve = UCurveBakeSubsystem::FindBakedCurve(this, ItemScaleCurve);
+	BakedPulseCurve = UCurveBakeSubsystem::FindBakedCurve(this, PulseCurve);
+	BakedInterpPulseCurve = UCurveBakeSubsystem::FindBakedCurve(this, InterpPulseCurve);
+}
+
+void AItem::PreparePulse(double WorldTime, FBakedCurveSample& OutSample) const
+{
+	const bool bBaked{ UCurveBakeSubsystem::IsBakingEnabled() };
+
 	switch (ItemState)
 	{
 	case EItemState::EIS_Pickup:
-		if (PulseCurve)
+		if (PulseCurve && PulseCurveTime > 0.f)
 		{
-			ElapsedTime = GetWorldTimerManager().GetTimerElapsed(PulseTimer);
-			CurveValue = PulseCurve->GetVectorValue(ElapsedTime);
+			OutSample.Time = FMath::Fmod(WorldTime - PulseStartTime, static_cast<double>(PulseCurveTime));
+			OutSample.Curve = bBaked ? BakedPulseCurve : nullptr;
+			if (OutSample.Curve == nullptr)
+			{
+				OutSample.Value = FVector4f(FVector3f(PulseCurve->GetVectorValue(OutSample.Time)), 0.f);
+			}
 		}
 		break;
 	case EItemState::EIS_EquipInterping:
 		if (InterpPulseCurve)
 		{
-			ElapsedTime = GetWorldTimerManager().GetTimerElapsed(ItemInterpTimer);
-			CurveValue = InterpPulseCurve->GetVectorValue(ElapsedTime);
+			OutSample.Time = Clock.GetElapsed(EItemClockEvent::EICE_Interp, WorldTime);
+			OutSample.Curve = bBaked ? BakedInterpPulseCurve : nullptr;
+			if (OutSample.Curve == nullptr)
+			{
+				OutSample.Value = FVector4f(FVector3f(InterpPulseCurve->GetVectorValue(OutSample.Time)), 0.f);
+			}
 		}
 		break;
 	}
+}
+
+void AItem::UpdatePulse(const FVector& CurveValue)
+{
+	SHOOTER_PROFILE_SCOPE(Item_UpdatePulse);
+
+	// Skip the material writes while the curve value hasn't changed
+	if (bPulseParametersWritten && CurveValue.Equals(LastPulseCurveValue, 0.f)) return;
+	LastPulseCurveValue = CurveValue;
+	bPulseParametersWritten = true;
 
 	if (DynamicMaterialInstance)
 	{
@@ -486,22 +670,12 @@ void AItem::PlayEquipSound(bool bForcePlaySound)
 	}
 }
 
-// Called every frame
-void AItem::Tick(float DeltaTime)
-{
-	Super::Tick(DeltaTime);
-
-	// Handle Item Interping when in the EquipInterping state
-	ItemInterp(DeltaTime);
-
-	// Get curve values from PulseCurve and set Dynamic material parameters
-	UpdatePulse();
-}
-
 void AItem::SetItemState(EItemState State)
 {
 	ItemState = State;
 	SetItemProperties(State);
+	UpdateItemRegistration();
+	UpdateNetDormancy();
 }
 
 void AItem::StartItemCurve(AShooterCharacter* Char, bool bForcePlaySound)
@@ -521,9 +695,13 @@ void AItem::StartItemCurve(AShooterCharacter* Char, bool bForcePlaySound)
 	ItemInterpStartLocation = GetActorLocation();
 	bInterping = true;
 	SetItemState(EItemState::EIS_EquipInterping);
-	GetWorldTimerManager().ClearTimer(PulseTimer);
 
-	GetWorldTimerManager().SetTimer(ItemInterpTimer, this, &AItem::FinishInterping, ZCurveTime);
+	Clock.Schedule(EItemClockEvent::EICE_Interp, GetWorld()->GetTimeSeconds(), ZCurveTime);
+
+	if (UItemTickSubsystem* ItemTicker = GetWorld()->GetSubsystem<UItemTickSubsystem>())
+	{
+		ItemTicker->AddInterpingItem(this);
+	}
 
 	// Get initial Yaw of the Camera
 	const double CameraRotationYaw { Character->GetFollowCamera()->GetComponentRotation().Yaw};
@@ -535,3 +713,65 @@ void AItem::StartItemCurve(AShooterCharacter* Char, bool bForcePlaySound)
 	bCanChangeCustomDepth = false;
 }
 
+
+void AItem::OnReleasedToPool()
+{
+	Clock.Reset();
+	if (UItemTickSubsystem* ItemTicker = GetWorld()->GetSubsystem<UItemTickSubsystem>())
+	{
+		ItemTicker->RemoveItem(this);
+	}
+	DetachFromActor(FDetachmentTransformRules::KeepWorldTransform);
+
+	// Back to the values the item was spawned with
+	const AItem* Defaults = GetClass()->GetDefaultObject<AItem>();
+	ItemCount = Defaults->ItemCount;
+	bInterping = false;
+	Character = nullptr;
+	InterpLocationIndex = 0;
+	SlotIndex = 0;
+	bCharacterInventoryFull = false;
+	SetActorScale3D(FVector(1.f));
+
+	bCanChangeCustomDepth = true;
+	DisableCustomDepth();
+	bPulseParametersWritten = false;
+	EnableGlowMaterial();
+
+	SetItemState(EItemState::EIS_Pooled);
+	SetActorHiddenInGame(true);
+}
+
+void AItem::OnAcquiredFromPool()
+{
+	SetActorHiddenInGame(false);
+	SetItemState(EItemState::EIS_Pickup);
+	StartPulse();
+}
+
+void AItem::OnClockEvent(EItemClockEvent Event)
+{
+	if (Event == EItemClockEvent::EICE_Interp)
+	{
+		FinishInterping();
+	}
+}
+
+void AItem::UpdateClock(double WorldTime)
+{
+	Clock.Update(WorldTime, [this](EItemClockEvent Event) { OnClockEvent(Event); });
+}
+
+void AItem::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AItem, ItemState);
+	DOREPLIFETIME(AItem, SlotIndex);
+}
+
+void AItem::OnRep_ItemState()
+{
+	SetItemProperties(ItemState);
+	UpdateItemRegistration();
+}
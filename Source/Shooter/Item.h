@@ -3,6 +3,8 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "BakedCurve.h"
+#include "CombatClock.h"
 #include "GameFramework/Actor.h"
 #include "Engine/DataTable.h"
 #include "Item.generated.h"
@@ -27,6 +29,7 @@ enum  class EItemState : uint8
 	EIS_PickedUp UMETA(DisplayName = "PickedUp"),
 	EIS_Equipped UMETA(DisplayName = "Equipped"),
 	EIS_Falling UMETA(DisplayName = "Falling"),
+	EIS_Pooled UMETA(DisplayName = "Pooled"),
 
 	EIS_MAX UMETA(DisplayName = "DefaultMAX")
 };
@@ -40,6 +43,16 @@ enum  class EItemType : uint8
 	EIT_MAX UMETA(DisplayName = "DefaultMAX"),
 };
 
+// Events scheduled on an item's Clock
+enum class EItemClockEvent : uint8
+{
+	EICE_Interp,
+	EICE_StopFalling,
+	EICE_Slide,
+
+	EICE_MAX
+};
+
 USTRUCT(BlueprintType)
 struct FItemRarityTable : public FTableRowBase
 {
@@ -68,6 +81,12 @@ UCLASS()
 class SHOOTER_API AItem : public AActor
 {
 	GENERATED_BODY()
+
+	// Drives ItemInterp and UpdatePulse in place of Tick
+	friend class UItemTickSubsystem;
+
+	// Keeps RegistryCell and bInItemRegistry up to date
+	friend class UItemRegistrySubsystem;
 	
 public:	
 	// Sets default values for this actor's properties
@@ -77,13 +96,13 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
-	// Called when overlapping AreaSphere
-	UFUNCTION()
-	void OnSphereOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex, bool bFromSweep, const FHitResult& SweepResult);
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
 
-	// Called when end overlapping AreaSphere
-	UFUNCTION()
-	void OnSphereEndOverlap(UPrimitiveComponent* OverlappedComponent, AActor* OtherActor, UPrimitiveComponent* OtherComp, int32 OtherBodyIndex);
+	// Adds the item to the item registry while in the Pickup state, removes it otherwise
+	void UpdateItemRegistration();
+
+	// Server only. Items on the ground or in the pool are dormant and flushed once per state change, held and falling items stay awake
+	void UpdateNetDormancy();
 
 	// Sets the ActiveStars array of bools based on rarity
 	void SetActiveStars();
@@ -91,7 +110,7 @@ protected:
 	// Sets properties of the items components based on item state
 	virtual void SetItemProperties(EItemState State);
 
-	// Called when ItemInterpTimer is finished
+	// Called when the interp clock event is due
 	void FinishInterping();
 
 	// Handles item interpolation when in the EquipInterping state
@@ -108,15 +127,26 @@ protected:
 
 	void EnableGlowMaterial();
 
-	void UpdatePulse();
+	// Looks up the baked copies of the item's curves, shared by every item using the same curve
+	virtual void CacheBakedCurves();
 
-	void ResetPulseTimer();
+	// Restarts the pulse curve while in the Pickup state
+	void StartPulse();
 
-	void StartPulseTimer();
+	// Handles an event from Clock
+	virtual void OnClockEvent(EItemClockEvent Event);
+
+	// Interp and weapon timers, updated by UItemTickSubsystem or the owning actor's tick
+	TCombatClock<EItemClockEvent, EItemClockEvent::EICE_MAX> Clock;
+
+	UFUNCTION()
+	void OnRep_ItemState();
 	
 public:	
-	// Called every frame
-	virtual void Tick(float DeltaTime) override;
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Pickups are relevant by item registry cell instead of by their own distance to the viewer
+	virtual bool IsNetRelevantFor(const AActor* RealViewer, const AActor* ViewTarget, const FVector& SrcLocation) const override;
 
 	// Called in AShooterCharacter::GetPickupItem
 	void PlayEquipSound(bool bForcePlaySound = false);
@@ -134,7 +164,7 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category= "Item Properties", meta=(AllowPrivateAccess = "True"))
 	class UWidgetComponent* PickupWidget;
 
-	// Enables item tracing when overlapped
+	// Radius in which characters trace for this item. Has no collision, proximity comes from UItemRegistrySubsystem
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category= "Item Properties", meta=(AllowPrivateAccess = "True"))
 	class USphereComponent* AreaSphere;
 
@@ -154,7 +184,7 @@ private:
 	TArray<bool> ActiveStars;
 
 	// State of the Item
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= "Item Properties", meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_ItemState, Category= "Item Properties", meta=(AllowPrivateAccess = "True"))
 	EItemState ItemState;
 
 	// The curve asset to use for the item's Z location when interping
@@ -173,9 +203,6 @@ private:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= "Item Properties", meta=(AllowPrivateAccess = "True"))
 	bool bInterping;
 
-	// Plays when we start interping
-	FTimerHandle ItemInterpTimer;
-
 	// Pointer to the character
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= "Item Properties", meta=(AllowPrivateAccess = "True"))
 	class AShooterCharacter* Character;
@@ -232,9 +259,16 @@ private:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties", meta=(AllowPrivateAccess = "True"))
 	UCurveVector* InterpPulseCurve;
 
-	FTimerHandle PulseTimer;
+	// Baked copies of the curves above, owned by UCurveBakeSubsystem
+	const FBakedCurve* BakedZCurve;
+	const FBakedCurve* BakedScaleCurve;
+	const FBakedCurve* BakedPulseCurve;
+	const FBakedCurve* BakedInterpPulseCurve;
+
+	// World time the pulse curve started, the curve loops every PulseCurveTime
+	double PulseStartTime;
 
-	// Time for the PulseTimer
+	// Length of the pulse curve
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties", meta=(AllowPrivateAccess = "True"))
 	float PulseCurveTime;
 
@@ -247,6 +281,10 @@ private:
 	UPROPERTY(VisibleAnywhere, Category = "Item Properties", meta=(AllowPrivateAccess = "True"))
 	float FresnelReflectFraction;
 
+	// Pulse curve value last written to the Dynamic Material, writes are skipped while it is unchanged
+	FVector LastPulseCurveValue;
+	bool bPulseParametersWritten;
+
 	// Background for this item in the inventory
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Rarity, meta=(AllowPrivateAccess = "True"))
 	UTexture2D* IconBackground;
@@ -260,7 +298,7 @@ private:
 	UTexture2D* IconAmmo;
 
 	// Slot in the inventory array
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Inventory, meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = Inventory, meta=(AllowPrivateAccess = "True"))
 	int32 SlotIndex;
 
 	// True when the character's invemtory is full
@@ -286,6 +324,26 @@ private:
 	// Number of stars in the Pickup Widget
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Rarity, meta=(AllowPrivateAccess = "True"))
 	int32 NumberOfStars;
+
+	// Static stand-in drawn by UDormantItemSubsystem while no character is near. Items without one never go dormant
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = "Item Properties", meta=(AllowPrivateAccess = "True"))
+	class UStaticMesh* DormantMesh;
+
+	// True while the item is drawn as an instance and its components are unregistered
+	bool bDormant;
+
+	// Components unregistered by SetDormant, registered again when the item wakes up
+	UPROPERTY(Transient)
+	TArray<UPrimitiveComponent*> DormantComponents;
+
+	// Item registry cell the item is in while bInItemRegistry, so relevancy checks don't have to look it up
+	FIntPoint RegistryCell;
+	bool bInItemRegistry;
+
+	// Slot in UItemTickSubsystem's active items, INDEX_NONE while neither interping nor pulsing
+	int32 ActiveItemIndex;
+	bool bTickInterping;
+	bool bTickPulsing;
 	
 public:
 	FORCEINLINE UWidgetComponent* GetPickupWidget() const { return PickupWidget;}
@@ -299,6 +357,7 @@ public:
 	FORCEINLINE void SetPickupSound(USoundCue* Sound) { PickupSound = Sound;}
 	FORCEINLINE void SetEquipSound(USoundCue* Sound) { EquipSound = Sound;}
 	FORCEINLINE int32 GetItemCount() const { return ItemCount; }
+	FORCEINLINE void SetItemCount(int32 Count) { ItemCount = Count; }
 	FORCEINLINE int32 GetSlotIndex() const { return SlotIndex; }
 	FORCEINLINE void SetSlotIndex(int32 Index) { SlotIndex = Index; }
 	FORCEINLINE void SetCharacter(AShooterCharacter* Char) { Character = Char; }
@@ -311,7 +370,8 @@ public:
 	FORCEINLINE void SetMaterialInstance(UMaterialInstance* Instance) { MaterialInstance = Instance; }
 	FORCEINLINE UMaterialInstance* GetMaterialInstance() const { return MaterialInstance; }
 	FORCEINLINE UMaterialInstanceDynamic* GetDynamicMaterialInstance() const { return DynamicMaterialInstance; }
-	FORCEINLINE void SetDynamicMaterialInstance(UMaterialInstanceDynamic* Instance) { DynamicMaterialInstance = Instance; }
+	// A new instance has none of the pulse parameters written yet
+	FORCEINLINE void SetDynamicMaterialInstance(UMaterialInstanceDynamic* Instance) { DynamicMaterialInstance = Instance; bPulseParametersWritten = false; }
 	FORCEINLINE FLinearColor GetGlowColor() const { return GlowColor; }
 	FORCEINLINE int32 GetMaterialIndex() const { return MaterialIndex; }
 	FORCEINLINE void SetMaterialIndex(int32 Index) { MaterialIndex = Index; }
@@ -323,17 +383,37 @@ public:
 	void StartItemCurve(AShooterCharacter* Char, bool bForcePlaySound = false);
 
 	void DisableGlowMaterial();
+
+	// Called from UItemPoolSubsystem. Releasing resets the item and puts it in the Pooled state
+	virtual void OnReleasedToPool();
+	virtual void OnAcquiredFromPool();
+
+	// Fills in this frame's pulse curve and time for a batched evaluation. When baking is off the value is evaluated here instead
+	void PreparePulse(double WorldTime, FBakedCurveSample& OutSample) const;
+
+	// Writes the pulse curve value to the dynamic material
+	void UpdatePulse(const FVector& CurveValue);
+
+	FORCEINLINE bool HasDueClockEvents(double WorldTime) const { return Clock.HasDueEvents(WorldTime); }
+
+	// Dispatches the due events on Clock
+	void UpdateClock(double WorldTime);
+
+	// Mesh and world transform of the instance that stands in for the item while it is dormant
+	virtual UStaticMesh* GetDormantMesh(FTransform& OutTransform) const;
+	FORCEINLINE void SetDormantMesh(UStaticMesh* Mesh) { DormantMesh = Mesh; }
+
+	// Called from UDormantItemSubsystem. Dormant items have no registered primitive components, so no render, physics or overlap state
+	void SetDormant(bool bNewDormant);
+	FORCEINLINE bool IsDormant() const { return bDormant; }
+
+	FORCEINLINE EItemRarity GetItemRarity() const { return ItemRarity; }
 };
 
-inline void AItem::StartPulseTimer()
+inline void AItem::StartPulse()
 {
 	if (ItemState == EItemState::EIS_Pickup)
 	{
-		GetWorldTimerManager().SetTimer(PulseTimer, this, &AItem::ResetPulseTimer, PulseCurveTime);
+		PulseStartTime = GetWorld()->GetTimeSeconds();
 	}
 }
-
-inline void AItem::ResetPulseTimer()
-{
-	StartPulseTimer();
-}
@@ -0,0 +1,144 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemHighlightSubsystem.h"
+
+#include "Item.h"
+#include "Shooter.h"
+#include "ShooterProfiling.h"
+#include "Components/WidgetComponent.h"
+
+void UItemHighlightSubsystem::Deinitialize()
+{
+	Focuses.Empty();
+	DirtyItems.Empty();
+	HighlightedItems.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemHighlightSubsystem::Tick(float DeltaTime)
+{
+	// Characters that left play lose their focus
+	for (int32 i = Focuses.Num() - 1; i >= 0; i--)
+	{
+		if (!Focuses[i].Viewer.IsValid())
+		{
+			MarkDirty(Focuses[i].Item.Get());
+			Focuses.RemoveAtSwap(i);
+		}
+	}
+
+	FlushHighlights();
+}
+
+TStatId UItemHighlightSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UItemHighlightSubsystem, STATGROUP_Tickables);
+}
+
+void UItemHighlightSubsystem::SetFocusedItem(const AActor* Viewer, AItem* Item, bool bInventoryFull)
+{
+	if (Viewer == nullptr) return;
+
+	if (Item && Item->GetPickupWidget() == nullptr)
+	{
+		Item = nullptr;
+	}
+
+	FItemFocus* Focus = Focuses.FindByPredicate([Viewer](const FItemFocus& Entry) { return Entry.Viewer.Get() == Viewer; });
+	if (Focus == nullptr)
+	{
+		if (Item == nullptr) return;
+
+		Focus = &Focuses.AddDefaulted_GetRef();
+		Focus->Viewer = Viewer;
+	}
+
+	AItem* PreviousItem = Focus->Item.Get();
+	if (PreviousItem != Item)
+	{
+		Focus->Item = Item;
+		MarkDirty(PreviousItem);
+		MarkDirty(Item);
+	}
+	else if (Item == nullptr || Focus->bInventoryFull == bInventoryFull)
+	{
+		// Steady state, nothing to do
+		return;
+	}
+
+	// The pickup widget reads this to show the swap prompt
+	Focus->bInventoryFull = bInventoryFull;
+	if (Item)
+	{
+		Item->SetCharacterInventoryFull(bInventoryFull);
+	}
+}
+
+AItem* UItemHighlightSubsystem::GetFocusedItem(const AActor* Viewer) const
+{
+	const FItemFocus* Focus = Focuses.FindByPredicate([Viewer](const FItemFocus& Entry) { return Entry.Viewer.Get() == Viewer; });
+	return Focus ? Focus->Item.Get() : nullptr;
+}
+
+void UItemHighlightSubsystem::FlushHighlights()
+{
+	if (DirtyItems.Num() == 0) return;
+
+	SHOOTER_PROFILE_SCOPE(ItemHighlight_FlushHighlights);
+
+	for (const TWeakObjectPtr<AItem>& WeakItem : DirtyItems)
+	{
+		AItem* Item = WeakItem.Get();
+		if (Item == nullptr)
+		{
+			HighlightedItems.Remove(WeakItem);
+			continue;
+		}
+
+		// Focus that moved away and back within the frame leaves the item as it was
+		const bool bHighlight{ IsFocused(Item) };
+		if (HighlightedItems.Contains(WeakItem) == bHighlight) continue;
+
+		if (bHighlight)
+		{
+			HighlightedItems.Add(WeakItem);
+			Item->GetPickupWidget()->SetVisibility(true);
+			Item->EnableCustomDepth();
+		}
+		else
+		{
+			HighlightedItems.Remove(WeakItem);
+			if (Item->GetPickupWidget())
+			{
+				Item->GetPickupWidget()->SetVisibility(false);
+			}
+			Item->DisableCustomDepth();
+		}
+		INC_DWORD_STAT(STAT_ShooterHighlightChanges);
+	}
+	DirtyItems.Reset();
+}
+
+bool UItemHighlightSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+bool UItemHighlightSubsystem::IsFocused(const AItem* Item) const
+{
+	for (const FItemFocus& Focus : Focuses)
+	{
+		if (Focus.Item.Get() == Item) return true;
+	}
+	return false;
+}
+
+void UItemHighlightSubsystem::MarkDirty(AItem* Item)
+{
+	if (Item)
+	{
+		DirtyItems.AddUnique(Item);
+	}
+}
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemHighlightSubsystem.generated.h"
+
+class AItem;
+
+/**
+ * Owns the pickup widget and custom depth outline of the item under each local character's crosshair.
+ * Characters report their focused item every frame; only a change of focus marks items dirty, and
+ * the dirty items are updated together once per frame, so a steady focus issues no render state
+ * or Slate changes at all.
+ */
+UCLASS()
+class SHOOTER_API UItemHighlightSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Replaces Viewer's focused item, nullptr clears it. Items without a pickup widget are never highlighted.
+	void SetFocusedItem(const AActor* Viewer, AItem* Item, bool bInventoryFull);
+
+	AItem* GetFocusedItem(const AActor* Viewer) const;
+
+	// Applies the dirty items now instead of at the end of the frame
+	void FlushHighlights();
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	struct FItemFocus
+	{
+		TWeakObjectPtr<const AActor> Viewer;
+		TWeakObjectPtr<AItem> Item;
+		bool bInventoryFull{ false };
+	};
+
+	bool IsFocused(const AItem* Item) const;
+
+	void MarkDirty(AItem* Item);
+
+	// One entry per local character
+	TArray<FItemFocus> Focuses;
+
+	// Items whose focus changed since the last flush
+	TArray<TWeakObjectPtr<AItem>> DirtyItems;
+
+	// Items whose widget and outline are currently shown
+	TSet<TWeakObjectPtr<AItem>> HighlightedItems;
+};
@@ -0,0 +1,105 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemPoolSubsystem.h"
+
+#include "Item.h"
+#include "Shooter.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarItemsMaxDroppedItems(
+	TEXT("Shooter.Items.MaxDroppedItems"),
+	32,
+	TEXT("Dropped weapons left lying around before the oldest goes back to the item pool."),
+	ECVF_Default);
+
+void UItemPoolSubsystem::Deinitialize()
+{
+	Pools.Empty();
+	DroppedItems.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemPoolSubsystem::Prewarm(TSubclassOf<AItem> ItemClass, int32 Count)
+{
+	if (ItemClass == nullptr) return;
+
+	for (int32 i = 0; i < Count; i++)
+	{
+		if (AItem* Item = SpawnItem(ItemClass, FTransform::Identity))
+		{
+			ReleaseItem(Item);
+		}
+	}
+}
+
+AItem* UItemPoolSubsystem::AcquireItem(TSubclassOf<AItem> ItemClass, const FTransform& Transform)
+{
+	if (ItemClass == nullptr) return nullptr;
+
+	if (FItemPoolList* Pool = Pools.Find(ItemClass))
+	{
+		while (Pool->FreeItems.Num() > 0)
+		{
+			AItem* Item = Pool->FreeItems.Pop(false);
+
+			// Skip items destroyed behind our back, e.g. by a level unload
+			if (!IsValid(Item)) continue;
+
+			++PoolHits;
+			INC_DWORD_STAT(STAT_ItemPoolHits);
+			DEC_DWORD_STAT(STAT_ItemPoolDormant);
+
+			Item->SetActorTransform(Transform, false, nullptr, ETeleportType::ResetPhysics);
+			Item->OnAcquiredFromPool();
+			return Item;
+		}
+	}
+
+	++PoolMisses;
+	INC_DWORD_STAT(STAT_ItemPoolMisses);
+	return SpawnItem(ItemClass, Transform);
+}
+
+void UItemPoolSubsystem::ReleaseItem(AItem* Item)
+{
+	if (!IsValid(Item)) return;
+
+	Item->OnReleasedToPool();
+	Pools.FindOrAdd(Item->GetClass()).FreeItems.Add(Item);
+	INC_DWORD_STAT(STAT_ItemPoolDormant);
+}
+
+void UItemPoolSubsystem::AddDroppedItem(AItem* Item)
+{
+	if (!IsValid(Item)) return;
+
+	// Forget drops that were picked up again or went away
+	DroppedItems.RemoveAll([](const AItem* Dropped)
+	{
+		return !IsValid(Dropped) || (Dropped->GetItemState() != EItemState::EIS_Falling && Dropped->GetItemState() != EItemState::EIS_Pickup);
+	});
+	DroppedItems.AddUnique(Item);
+
+	const int32 MaxDroppedItems{ FMath::Max(CVarItemsMaxDroppedItems.GetValueOnGameThread(), 0) };
+	while (DroppedItems.Num() > MaxDroppedItems)
+	{
+		AItem* Oldest = DroppedItems[0];
+		DroppedItems.RemoveAt(0, 1, false);
+		ReleaseItem(Oldest);
+	}
+}
+
+bool UItemPoolSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+AItem* UItemPoolSubsystem::SpawnItem(TSubclassOf<AItem> ItemClass, const FTransform& Transform) const
+{
+	FActorSpawnParameters SpawnParameters;
+	SpawnParameters.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	return GetWorld()->SpawnActor<AItem>(ItemClass, Transform, SpawnParameters);
+}
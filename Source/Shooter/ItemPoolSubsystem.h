@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemPoolSubsystem.generated.h"
+
+// Dormant items of one class, waiting to be reused
+USTRUCT()
+struct FItemPoolList
+{
+	GENERATED_BODY()
+
+	UPROPERTY()
+	TArray<class AItem*> FreeItems;
+};
+
+/**
+ * Reuses AWeapon / AAmmo actors instead of spawning and destroying them.
+ * Released items are put in the EIS_Pooled state, which hides them and turns off
+ * their collision, and are reset before they are handed out again. Dropped weapons
+ * are released once too many of them lie around.
+ */
+UCLASS()
+class SHOOTER_API UItemPoolSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Spawns Count items of ItemClass straight into the pool
+	void Prewarm(TSubclassOf<AItem> ItemClass, int32 Count);
+
+	// Returns a pooled item in the Pickup state at Transform, spawning one if the pool is empty
+	AItem* AcquireItem(TSubclassOf<AItem> ItemClass, const FTransform& Transform);
+
+	template<class T>
+	T* AcquireItem(TSubclassOf<T> ItemClass, const FTransform& Transform)
+	{
+		return Cast<T>(AcquireItem(TSubclassOf<AItem>(ItemClass), Transform));
+	}
+
+	// Puts the item to sleep and makes it available to AcquireItem
+	void ReleaseItem(AItem* Item);
+
+	// Called on the server when a character drops or swaps out a weapon. Past Shooter.Items.MaxDroppedItems,
+	// the oldest drop still lying on the ground goes back to the pool
+	void AddDroppedItem(AItem* Item);
+
+	FORCEINLINE int32 GetPoolHits() const { return PoolHits; }
+	FORCEINLINE int32 GetPoolMisses() const { return PoolMisses; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	AItem* SpawnItem(TSubclassOf<AItem> ItemClass, const FTransform& Transform) const;
+
+	UPROPERTY()
+	TMap<TSubclassOf<AItem>, FItemPoolList> Pools;
+
+	// Dropped items, oldest first
+	UPROPERTY()
+	TArray<AItem*> DroppedItems;
+
+	// Acquires served from the pool
+	int32 PoolHits{ 0 };
+
+	// Acquires that had to spawn a new actor
+	int32 PoolMisses{ 0 };
+};
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemRegistrySubsystem.h"
+
+#include "Item.h"
+#include "Components/SphereComponent.h"
+
+void UItemRegistrySubsystem::Deinitialize()
+{
+	Cells.Empty();
+	ItemCells.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemRegistrySubsystem::RegisterItem(AItem* Item)
+{
+	if (Item == nullptr) return;
+
+	UnregisterItem(Item);
+
+	FRegisteredItem Entry;
+	Entry.Item = Item;
+	Entry.Location = Item->GetActorLocation();
+	const float PickupRadius{ Item->GetAreaSphere() ? Item->GetAreaSphere()->GetScaledSphereRadius() : 0.f};
+	Entry.PickupRadius = PickupRadius;
+	MaxPickupRadius = FMath::Max(MaxPickupRadius, PickupRadius);
+
+	const FIntPoint Cell{ GetCell(Entry.Location)};
+	Cells.FindOrAdd(Cell).Add(Entry);
+	ItemCells.Add(Item, Cell);
+	Item->RegistryCell = Cell;
+	Item->bInItemRegistry = true;
+}
+
+void UItemRegistrySubsystem::UnregisterItem(AItem* Item)
+{
+	FIntPoint Cell;
+	if (!ItemCells.RemoveAndCopyValue(Item, Cell)) return;
+	Item->bInItemRegistry = false;
+
+	if (TArray<FRegisteredItem>* CellItems = Cells.Find(Cell))
+	{
+		CellItems->RemoveAllSwap([Item](const FRegisteredItem& Entry) { return Entry.Item == Item; }, false);
+		if (CellItems->Num() == 0)
+		{
+			Cells.Remove(Cell);
+		}
+	}
+}
+
+void UItemRegistrySubsystem::QueryItemsInPickupRange(const FVector& Location, TArray<AItem*>& OutItems) const
+{
+	QueryItemsInRange(Location, 0.f, OutItems);
+}
+
+void UItemRegistrySubsystem::QueryItemsInRange(const FVector& Location, float ExtraRadius, TArray<AItem*>& OutItems) const
+{
+	if (ItemCells.Num() == 0) return;
+
+	// Visit every cell an item in range could have been registered in
+	const FIntPoint Center{ GetCell(Location)};
+	const int32 Range{ FMath::CeilToInt((MaxPickupRadius + ExtraRadius) / CellSize)};
+
+	for (int32 X = Center.X - Range; X <= Center.X + Range; X++)
+	{
+		for (int32 Y = Center.Y - Range; Y <= Center.Y + Range; Y++)
+		{
+			const TArray<FRegisteredItem>* CellItems = Cells.Find(FIntPoint(X, Y));
+			if (CellItems == nullptr) continue;
+
+			for (const FRegisteredItem& Entry : *CellItems)
+			{
+				if (FVector::DistSquared(Entry.Location, Location) <= FMath::Square(Entry.PickupRadius + ExtraRadius))
+				{
+					OutItems.Add(Entry.Item);
+				}
+			}
+		}
+	}
+}
+
+bool UItemRegistrySubsystem::IsWithinCellRange(const AItem* Item, const FVector& Location, float RangeSquared, bool& bOutInRange) const
+{
+	if (!Item->bInItemRegistry) return false;
+
+	if (Location != CachedViewLocation)
+	{
+		CachedViewLocation = Location;
+		CachedViewCell = GetCell(Location);
+	}
+	if (RangeSquared != CachedRangeSquared)
+	{
+		CachedRangeSquared = RangeSquared;
+		CachedCellRange = FMath::CeilToInt(FMath::Sqrt(RangeSquared) / CellSize);
+	}
+
+	const FIntPoint& ItemCell = Item->RegistryCell;
+	bOutInRange = FMath::Abs(CachedViewCell.X - ItemCell.X) <= CachedCellRange && FMath::Abs(CachedViewCell.Y - ItemCell.Y) <= CachedCellRange;
+	return true;
+}
+
+bool UItemRegistrySubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+FIntPoint UItemRegistrySubsystem::GetCell(const FVector& Location) const
+{
+	return FIntPoint(FMath::FloorToInt(Location.X / CellSize), FMath::FloorToInt(Location.Y / CellSize));
+}
@@ -0,0 +1,75 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemRegistrySubsystem.generated.h"
+
+// Entry for an item in the spatial hash
+struct FRegisteredItem
+{
+	class AItem* Item;
+
+	// Location the item was registered at
+	FVector Location;
+
+	// Pickup radius, taken from the item's AreaSphere
+	float PickupRadius;
+};
+
+/**
+ * Keeps every item in the Pickup state in a uniform 2D grid, so characters only
+ * look at items in the cells around them instead of relying on overlap spheres.
+ */
+UCLASS()
+class SHOOTER_API UItemRegistrySubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Adds the item at its current location, or moves it if it is already registered
+	void RegisterItem(AItem* Item);
+
+	void UnregisterItem(AItem* Item);
+
+	// Gathers the items whose pickup radius contains Location
+	void QueryItemsInPickupRange(const FVector& Location, TArray<AItem*>& OutItems) const;
+
+	// Gathers the items whose pickup radius grown by ExtraRadius contains Location
+	void QueryItemsInRange(const FVector& Location, float ExtraRadius, TArray<AItem*>& OutItems) const;
+
+	// Compares the cells of the item and Location instead of their distance, range rounded up to whole cells.
+	// Every item in a cell becomes relevant at the same time. Returns false if the item isn't registered.
+	// The net driver asks about every item for one viewer in a row, so the viewer's cell and range are reused until they change
+	bool IsWithinCellRange(const AItem* Item, const FVector& Location, float RangeSquared, bool& bOutInRange) const;
+
+	FORCEINLINE int32 GetNumRegisteredItems() const { return ItemCells.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	FIntPoint GetCell(const FVector& Location) const;
+
+	// Size of a grid cell in world units
+	float CellSize{ 500.f };
+
+	// Largest pickup radius registered so far, decides how many cells a query visits
+	float MaxPickupRadius{ 0.f };
+
+	TMap<FIntPoint, TArray<FRegisteredItem>> Cells;
+
+	// Cell each registered item lives in
+	TMap<AItem*, FIntPoint> ItemCells;
+
+	// Last viewer passed to IsWithinCellRange, and its cell
+	mutable FVector CachedViewLocation{ TNumericLimits<float>::Max() };
+	mutable FIntPoint CachedViewCell{ FIntPoint::ZeroValue };
+
+	// Last range passed to IsWithinCellRange, and the same range in cells
+	mutable float CachedRangeSquared{ -1.f };
+	mutable int32 CachedCellRange{ 0 };
+};
@@ -0,0 +1,126 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ItemTickSubsystem.h"
+
+#include "Item.h"
+#include "Shooter.h"
+
+void UItemTickSubsystem::Deinitialize()
+{
+	ActiveItems.Empty();
+	DueClockItems.Empty();
+	PulseSamples.Empty();
+
+	Super::Deinitialize();
+}
+
+void UItemTickSubsystem::Tick(float DeltaTime)
+{
+	// Interp clocks first. Finishing an interp changes the item lists, so gather the due items before dispatching
+	const double WorldTime{ GetWorld()->GetTimeSeconds() };
+	DueClockItems.Reset();
+	for (AItem* Item : ActiveItems)
+	{
+		if (Item->bTickInterping && Item->HasDueClockEvents(WorldTime))
+		{
+			DueClockItems.Add(Item);
+		}
+	}
+	for (AItem* Item : DueClockItems)
+	{
+		if (IsValid(Item))
+		{
+			Item->UpdateClock(WorldTime);
+		}
+	}
+
+	SET_DWORD_STAT(STAT_ShooterItemsTicking, ActiveItems.Num());
+
+	for (AItem* Item : ActiveItems)
+	{
+		// Handle Item Interping when in the EquipInterping state
+		Item->ItemInterp(DeltaTime);
+	}
+
+	// Pulse curves for every active item in one pass over the baked tables, then the material writes
+	PulseSamples.Reset();
+	PulseSamples.SetNum(ActiveItems.Num());
+	for (int32 i = 0; i < ActiveItems.Num(); i++)
+	{
+		ActiveItems[i]->PreparePulse(WorldTime, PulseSamples[i]);
+	}
+	EvaluateBakedCurves(PulseSamples);
+	for (int32 i = 0; i < ActiveItems.Num(); i++)
+	{
+		const FVector4f& Value = PulseSamples[i].Value;
+		ActiveItems[i]->UpdatePulse(FVector(Value.X, Value.Y, Value.Z));
+	}
+}
+
+void UItemTickSubsystem::ActivateItem(AItem* Item)
+{
+	if (Item->ActiveItemIndex == INDEX_NONE)
+	{
+		Item->ActiveItemIndex = ActiveItems.Add(Item);
+	}
+}
+
+void UItemTickSubsystem::DeactivateItem(AItem* Item)
+{
+	const int32 Index{ Item->ActiveItemIndex };
+	if (Item->bTickInterping || Item->bTickPulsing || Index == INDEX_NONE) return;
+
+	// Fill the hole with the last item, so only that one item's index changes
+	AItem* LastItem = ActiveItems.Last();
+	ActiveItems[Index] = LastItem;
+	LastItem->ActiveItemIndex = Index;
+	ActiveItems.Pop(false);
+	Item->ActiveItemIndex = INDEX_NONE;
+}
+
+void UItemTickSubsystem::AddInterpingItem(AItem* Item)
+{
+	// Interping replaces the pickup pulse
+	Item->bTickPulsing = false;
+	Item->bTickInterping = true;
+	ActivateItem(Item);
+}
+
+void UItemTickSubsystem::RemoveInterpingItem(AItem* Item)
+{
+	Item->bTickInterping = false;
+	DeactivateItem(Item);
+}
+
+void UItemTickSubsystem::AddPulsingItem(AItem* Item)
+{
+	// The pulse is only a material parameter, a dedicated server has nothing to draw it on
+	if (GetWorld()->GetNetMode() == NM_DedicatedServer) return;
+
+	Item->bTickPulsing = true;
+	ActivateItem(Item);
+}
+
+void UItemTickSubsystem::RemovePulsingItem(AItem* Item)
+{
+	Item->bTickPulsing = false;
+	DeactivateItem(Item);
+}
+
+void UItemTickSubsystem::RemoveItem(AItem* Item)
+{
+	Item->bTickInterping = false;
+	Item->bTickPulsing = false;
+	DeactivateItem(Item);
+}
+
+TStatId UItemTickSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UItemTickSubsystem, STATGROUP_Tickables);
+}
+
+bool UItemTickSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
@@ -0,0 +1,59 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "BakedCurve.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ItemTickSubsystem.generated.h"
+
+/**
+ * Updates item interpolation and material pulsing for all items in one loop.
+ * Items are only in the list while interping, or while pulsing in the Pickup state
+ * and awake. Pickups no character is near are dormant, drawn by UDormantItemSubsystem
+ * without the pulse, so placed pickups only cost anything once they can be seen up close.
+ * Items join and leave on those state changes, each keeping its slot for an O(1) removal.
+ * AItem itself never ticks.
+ */
+UCLASS()
+class SHOOTER_API UItemTickSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Called from AItem::StartItemCurve / FinishInterping
+	void AddInterpingItem(class AItem* Item);
+	void RemoveInterpingItem(AItem* Item);
+
+	// Called when an item enters / leaves the Pickup state
+	void AddPulsingItem(AItem* Item);
+	void RemovePulsingItem(AItem* Item);
+
+	// Drops the item from every list, called when the item leaves play
+	void RemoveItem(AItem* Item);
+
+	FORCEINLINE int32 GetNumActiveItems() const { return ActiveItems.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Adds the item to ActiveItems if it isn't in it yet
+	void ActivateItem(AItem* Item);
+
+	// Removes the item from ActiveItems once it is neither interping nor pulsing
+	void DeactivateItem(AItem* Item);
+
+	// Items updated every tick, each knows its index through AItem::ActiveItemIndex
+	TArray<AItem*> ActiveItems;
+
+	// Scratch array of interping items with due clock events
+	TArray<AItem*> DueClockItems;
+
+	// Scratch array of pulse curve lookups, one per active item
+	TArray<FBakedCurveSample> PulseSamples;
+};
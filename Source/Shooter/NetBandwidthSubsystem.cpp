@@ -0,0 +1,326 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "NetBandwidthSubsystem.h"
+
+#include "Ammo.h"
+#include "AmmoPickupRecord.h"
+#include "EngineUtils.h"
+#include "ItemPoolSubsystem.h"
+#include "Shooter.h"
+#include "Dom/JsonObject.h"
+#include "Engine/NetConnection.h"
+#include "Engine/NetDriver.h"
+#include "Engine/World.h"
+#include "GameFramework/Pawn.h"
+#include "GameFramework/PlayerController.h"
+#include "HAL/IConsoleManager.h"
+#include "Misc/CommandLine.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Parse.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+
+// Distance between neighbouring soak pickups
+static constexpr float SoakItemSpacing{ 200.f };
+
+void UNetBandwidthSubsystem::Deinitialize()
+{
+	LastOutTotalBytes.Empty();
+	SoakItems.Empty();
+	bSoaking = false;
+
+	Super::Deinitialize();
+}
+
+void UNetBandwidthSubsystem::Tick(float DeltaTime)
+{
+	const ENetMode NetMode{ GetWorld()->GetNetMode() };
+	if (NetMode != NM_DedicatedServer && NetMode != NM_ListenServer) return;
+
+	TimeSinceSample += DeltaTime;
+	if (TimeSinceSample < 1.f) return;
+
+	SampleConnections(TimeSinceSample);
+	TimeSinceSample = 0.f;
+
+	if (bSoaking)
+	{
+		UpdateSoak();
+	}
+}
+
+TStatId UNetBandwidthSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UNetBandwidthSubsystem, STATGROUP_Tickables);
+}
+
+void UNetBandwidthSubsystem::SampleConnections(float ElapsedSeconds)
+{
+	NumConnections = 0;
+	AverageBytesPerSecond = 0.f;
+	MaxBytesPerSecond = 0.f;
+
+	const UNetDriver* NetDriver = GetWorld()->GetNetDriver();
+	if (NetDriver == nullptr) return;
+
+	float TotalBytesPerSecond{ 0.f };
+	for (UNetConnection* Connection : NetDriver->ClientConnections)
+	{
+		if (Connection == nullptr) continue;
+
+		const int64 OutTotalBytes{ static_cast<int64>(Connection->OutTotalBytes) };
+		int64& LastBytes = LastOutTotalBytes.FindOrAdd(Connection, OutTotalBytes);
+		const float BytesPerSecond{ static_cast<float>(OutTotalBytes - LastBytes) / ElapsedSeconds };
+		LastBytes = OutTotalBytes;
+
+		++NumConnections;
+		TotalBytesPerSecond += BytesPerSecond;
+		MaxBytesPerSecond = FMath::Max(MaxBytesPerSecond, BytesPerSecond);
+	}
+
+	// Forget closed connections
+	for (auto It = LastOutTotalBytes.CreateIterator(); It; ++It)
+	{
+		if (!It.Key().IsValid())
+		{
+			It.RemoveCurrent();
+		}
+	}
+
+	AverageBytesPerSecond = NumConnections > 0 ? TotalBytesPerSecond / NumConnections : 0.f;
+
+	SET_DWORD_STAT(STAT_NetClientConnections, NumConnections);
+	SET_DWORD_STAT(STAT_NetOutBytesPerConnection, FMath::RoundToInt(AverageBytesPerSecond));
+	SET_DWORD_STAT(STAT_NetOutBytesPerConnectionMax, FMath::RoundToInt(MaxBytesPerSecond));
+}
+
+void UNetBandwidthSubsystem::StartPickupSoak(TSubclassOf<AItem> ItemClass, int32 MinConnections, int32 MaxItems, int32 NumSteps, int32 SecondsPerStep, int32 ChurnPerSecond)
+{
+	if (bSoaking || ItemClass == nullptr) return;
+
+	bSoaking = true;
+	SoakItemClass = ItemClass;
+	SoakMinConnections = FMath::Max(MinConnections, 1);
+	SoakMaxItems = FMath::Max(MaxItems, 1);
+	SoakNumSteps = FMath::Clamp(NumSteps, 1, SoakMaxItems);
+	// The first second of every step is the burst, so a step needs at least one more for the steady rate
+	SoakSecondsPerStep = FMath::Max(SecondsPerStep, 2);
+	SoakChurnPerSecond = FMath::Max(ChurnPerSecond, 0);
+	SoakRandom.Initialize(1337);
+	SoakStep = INDEX_NONE;
+	SoakStepSamples = 0;
+	SoakResults.Reset();
+
+	UE_LOG(LogShooter, Display, TEXT("PickupSoak: waiting for %d clients, then %d %s pickups in %d steps of %d s, %d moved per second"),
+		SoakMinConnections, SoakMaxItems, *GetNameSafe(SoakItemClass), SoakNumSteps, SoakSecondsPerStep, SoakChurnPerSecond);
+}
+
+void UNetBandwidthSubsystem::UpdateSoak()
+{
+	if (SoakStep == INDEX_NONE)
+	{
+		if (NumConnections < SoakMinConnections) return;
+
+		// Lay the field out around the first player, so some of it is out of relevancy range
+		SoakCenter = FVector::ZeroVector;
+		for (FConstPlayerControllerIterator It = GetWorld()->GetPlayerControllerIterator(); It; ++It)
+		{
+			const APlayerController* PlayerController = It->Get();
+			if (const APawn* Pawn = PlayerController ? PlayerController->GetPawn() : nullptr)
+			{
+				SoakCenter = Pawn->GetActorLocation();
+				break;
+			}
+		}
+
+		SoakStep = 0;
+		SoakStepSamples = 0;
+		SoakResults.AddDefaulted();
+		SpawnSoakItems(SoakMaxItems / SoakNumSteps);
+		return;
+	}
+
+	FPickupSoakStep& Step = SoakResults[SoakStep];
+	Step.NumItems = SoakItems.Num();
+	Step.NumConnections = NumConnections;
+	Step.MaxBytesPerSecond = FMath::Max(Step.MaxBytesPerSecond, MaxBytesPerSecond);
+	if (SoakStepSamples == 0)
+	{
+		Step.BurstBytesPerSecond = AverageBytesPerSecond;
+	}
+	else
+	{
+		// Running mean of the steady samples
+		Step.SteadyBytesPerSecond += (AverageBytesPerSecond - Step.SteadyBytesPerSecond) / SoakStepSamples;
+	}
+	++SoakStepSamples;
+
+	if (SoakStepSamples < SoakSecondsPerStep)
+	{
+		ChurnSoakItems(SoakChurnPerSecond);
+		return;
+	}
+
+	UE_LOG(LogShooter, Display, TEXT("PickupSoak: %6d pickups, %d clients: burst %9.0f B/s, steady %9.0f B/s, max %9.0f B/s per connection"),
+		Step.NumItems, Step.NumConnections, Step.BurstBytesPerSecond, Step.SteadyBytesPerSecond, Step.MaxBytesPerSecond);
+
+	if (++SoakStep >= SoakNumSteps)
+	{
+		FinishSoak();
+		return;
+	}
+
+	SoakStepSamples = 0;
+	SoakResults.AddDefaulted();
+	SpawnSoakItems(static_cast<int32>(static_cast<int64>(SoakMaxItems) * (SoakStep + 1) / SoakNumSteps));
+}
+
+void UNetBandwidthSubsystem::SpawnSoakItems(int32 NumItems)
+{
+	UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>();
+	if (ItemPool == nullptr) return;
+
+	while (SoakItems.Num() < NumItems)
+	{
+		const FTransform Transform{ FRotator(0.f, SoakRandom.FRandRange(0.f, 360.f), 0.f), GetSoakSlotLocation(SoakItems.Num()) };
+		AItem* Item = ItemPool->AcquireItem(SoakItemClass, Transform);
+		if (Item == nullptr) break;
+
+		SoakItems.Add(Item);
+	}
+}
+
+void UNetBandwidthSubsystem::ChurnSoakItems(int32 Count)
+{
+	UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>();
+	if (ItemPool == nullptr || SoakItems.Num() == 0) return;
+
+	for (int32 i = 0; i < Count; i++)
+	{
+		const int32 Index{ SoakRandom.RandHelper(SoakItems.Num()) };
+
+		// Acquire before releasing, otherwise the pool hands back the actor just released and only moves it
+		const FTransform Transform{ FRotator(0.f, SoakRandom.FRandRange(0.f, 360.f), 0.f), GetSoakSlotLocation(SoakRandom.RandHelper(SoakMaxItems)) };
+		AItem* Replacement = ItemPool->AcquireItem(SoakItemClass, Transform);
+		ItemPool->ReleaseItem(SoakItems[Index]);
+		SoakItems[Index] = Replacement;
+	}
+	SoakItems.RemoveAllSwap([](const AItem* Item) { return Item == nullptr; }, false);
+}
+
+void UNetBandwidthSubsystem::FinishSoak()
+{
+	bSoaking = false;
+
+	// Record size for a typical stack, to compare against the steady rates
+	FAmmoPickupRecord Record;
+	Record.Count = 30;
+	Record.Location = SoakCenter + FVector(SoakItemSpacing * 10.f, SoakItemSpacing * 10.f, 0.f);
+	Record.Rotation = FRotator(0.f, 90.f, 0.f);
+	UE_LOG(LogShooter, Display, TEXT("PickupSoak: done, an ammo pickup record is %d bits"), Record.GetSerializedBits());
+
+	FString OutputPath;
+	if (!FParse::Value(FCommandLine::Get(), TEXT("PickupSoakOutput="), OutputPath))
+	{
+		OutputPath = FPaths::Combine(FPaths::ProfilingDir(), TEXT("PickupSoak.json"));
+	}
+	WriteSoakResults(OutputPath);
+
+	if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+	{
+		for (AItem* Item : SoakItems)
+		{
+			ItemPool->ReleaseItem(Item);
+		}
+	}
+	SoakItems.Reset();
+
+	if (FParse::Param(FCommandLine::Get(), TEXT("SoakExit")))
+	{
+		FPlatformMisc::RequestExit(false, TEXT("UNetBandwidthSubsystem::FinishSoak"));
+	}
+}
+
+FVector UNetBandwidthSubsystem::GetSoakSlotLocation(int32 Slot) const
+{
+	const int32 Columns{ FMath::Max(FMath::CeilToInt(FMath::Sqrt(static_cast<float>(SoakMaxItems))), 1) };
+	const float HalfWidth{ (Columns - 1) * SoakItemSpacing * 0.5f };
+	return SoakCenter + FVector((Slot % Columns) * SoakItemSpacing - HalfWidth, (Slot / Columns) * SoakItemSpacing - HalfWidth, 0.f);
+}
+
+bool UNetBandwidthSubsystem::WriteSoakResults(const FString& OutputPath) const
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetStringField(TEXT("itemClass"), GetNameSafe(SoakItemClass));
+	Root->SetNumberField(TEXT("secondsPerStep"), SoakSecondsPerStep);
+	Root->SetNumberField(TEXT("churnPerSecond"), SoakChurnPerSecond);
+
+	TArray<TSharedPtr<FJsonValue>> Steps;
+	for (const FPickupSoakStep& Step : SoakResults)
+	{
+		TSharedRef<FJsonObject> StepObject = MakeShared<FJsonObject>();
+		StepObject->SetNumberField(TEXT("items"), Step.NumItems);
+		StepObject->SetNumberField(TEXT("connections"), Step.NumConnections);
+		StepObject->SetNumberField(TEXT("burstBytesPerSecond"), Step.BurstBytesPerSecond);
+		StepObject->SetNumberField(TEXT("steadyBytesPerSecond"), Step.SteadyBytesPerSecond);
+		StepObject->SetNumberField(TEXT("maxBytesPerSecond"), Step.MaxBytesPerSecond);
+		Steps.Add(MakeShared<FJsonValueObject>(StepObject));
+	}
+	Root->SetArrayField(TEXT("steps"), Steps);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogShooter, Error, TEXT("PickupSoak: could not write %s"), *OutputPath);
+		return false;
+	}
+
+	UE_LOG(LogShooter, Display, TEXT("PickupSoak: wrote %s"), *OutputPath);
+	return true;
+}
+
+bool UNetBandwidthSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+static FAutoConsoleCommandWithWorldAndArgs PickupSoakCommand(
+	TEXT("Shooter.Net.PickupSoak"),
+	TEXT("Server only. Once enough clients are connected, grows a field of ammo pickups in steps and logs bytes per second per connection.\n")
+	TEXT("Uses the class of an ammo pickup in the level if there is one. Usage: Shooter.Net.PickupSoak [Clients] [MaxItems] [Steps] [SecondsPerStep] [ChurnPerSecond]"),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic([](const TArray<FString>& Args, UWorld* World)
+	{
+		UNetBandwidthSubsystem* NetBandwidth = World ? World->GetSubsystem<UNetBandwidthSubsystem>() : nullptr;
+		if (NetBandwidth == nullptr || World->GetNetMode() == NM_Client || World->GetNetMode() == NM_Standalone) return;
+
+		// A placed blueprint has the meshes the native class lacks
+		TSubclassOf<AItem> ItemClass{ AAmmo::StaticClass() };
+		for (TActorIterator<AAmmo> It(World); It; ++It)
+		{
+			ItemClass = It->GetClass();
+			break;
+		}
+
+		NetBandwidth->StartPickupSoak(ItemClass,
+			Args.Num() > 0 ? FCString::Atoi(*Args[0]) : 2,
+			Args.Num() > 1 ? FCString::Atoi(*Args[1]) : 8000,
+			Args.Num() > 2 ? FCString::Atoi(*Args[2]) : 8,
+			Args.Num() > 3 ? FCString::Atoi(*Args[3]) : 10,
+			Args.Num() > 4 ? FCString::Atoi(*Args[4]) : 0);
+	}));
+
+static FAutoConsoleCommandWithWorld NetBandwidthReportCommand(
+	TEXT("Shooter.Net.BandwidthReport"),
+	TEXT("Logs the client connection count and the bytes per second sent to them over the last second."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		const UNetBandwidthSubsystem* NetBandwidth = World ? World->GetSubsystem<UNetBandwidthSubsystem>() : nullptr;
+		if (NetBandwidth == nullptr) return;
+
+		UE_LOG(LogShooter, Log, TEXT("Net bandwidth: %d client connections, %.0f B/s average, %.0f B/s max per connection"),
+			NetBandwidth->GetNumConnections(), NetBandwidth->GetAverageBytesPerSecond(), NetBandwidth->GetMaxBytesPerSecond());
+	}));
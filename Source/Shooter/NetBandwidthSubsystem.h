@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Math/RandomStream.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "NetBandwidthSubsystem.generated.h"
+
+class AItem;
+class UNetConnection;
+
+// Bytes per second each client received during one step of the pickup soak
+struct FPickupSoakStep
+{
+	int32 NumItems{ 0 };
+	int32 NumConnections{ 0 };
+
+	// Average per connection over the first second after the step's pickups spawned
+	float BurstBytesPerSecond{ 0.f };
+
+	// Average per connection over the rest of the step
+	float SteadyBytesPerSecond{ 0.f };
+
+	// Busiest connection in any second of the step
+	float MaxBytesPerSecond{ 0.f };
+};
+
+/**
+ * Samples what the server sends each client connection once a second, for the bandwidth stats.
+ * Also runs the pickup soak: waits for a number of clients, then grows a field of ammo pickups
+ * in steps and reports bytes per second per connection against the pickup count.
+ *
+ * Headless run, one server and any number of clients on the same machine:
+ *   UnrealEditor Shooter.uproject <Map> -server -nullrhi -log -SoakExit [-PickupSoakOutput=<path>] -ExecCmds="Shooter.Net.PickupSoak 4 8000 8 10 20"
+ *   UnrealEditor Shooter.uproject 127.0.0.1 -game -nullrhi -nosound -unattended   (once per client)
+ */
+UCLASS()
+class SHOOTER_API UNetBandwidthSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Starts once MinConnections clients are connected. Pickups are added in NumSteps equal batches up to MaxItems,
+	// and ChurnPerSecond of them are returned to the pool and placed somewhere else every second
+	void StartPickupSoak(TSubclassOf<AItem> ItemClass, int32 MinConnections, int32 MaxItems, int32 NumSteps, int32 SecondsPerStep, int32 ChurnPerSecond);
+
+	FORCEINLINE bool IsSoaking() const { return bSoaking; }
+	FORCEINLINE int32 GetNumConnections() const { return NumConnections; }
+	FORCEINLINE float GetAverageBytesPerSecond() const { return AverageBytesPerSecond; }
+	FORCEINLINE float GetMaxBytesPerSecond() const { return MaxBytesPerSecond; }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Works out the bytes per second of every client connection since the last sample
+	void SampleConnections(float ElapsedSeconds);
+
+	// Advances the soak by one sample
+	void UpdateSoak();
+
+	// Acquires pickups from the pool until there are NumItems
+	void SpawnSoakItems(int32 NumItems);
+
+	// Replaces Count random soak pickups with other pooled actors at new slots, like pickups being taken and dropped
+	void ChurnSoakItems(int32 Count);
+
+	void FinishSoak();
+
+	// Slot on a square grid around SoakCenter, sized for SoakMaxItems
+	FVector GetSoakSlotLocation(int32 Slot) const;
+
+	bool WriteSoakResults(const FString& OutputPath) const;
+
+	// Total bytes sent per connection at the last sample
+	TMap<TWeakObjectPtr<UNetConnection>, int64> LastOutTotalBytes;
+
+	float TimeSinceSample{ 0.f };
+
+	int32 NumConnections{ 0 };
+	float AverageBytesPerSecond{ 0.f };
+	float MaxBytesPerSecond{ 0.f };
+
+	bool bSoaking{ false };
+
+	UPROPERTY()
+	TSubclassOf<AItem> SoakItemClass;
+
+	UPROPERTY()
+	TArray<AItem*> SoakItems;
+
+	FVector SoakCenter{ FVector::ZeroVector };
+	FRandomStream SoakRandom;
+	int32 SoakMinConnections{ 0 };
+	int32 SoakMaxItems{ 0 };
+	int32 SoakNumSteps{ 0 };
+	int32 SoakSecondsPerStep{ 0 };
+	int32 SoakChurnPerSecond{ 0 };
+
+	// INDEX_NONE while waiting for clients
+	int32 SoakStep{ INDEX_NONE };
+
+	// Samples taken in the current step
+	int32 SoakStepSamples{ 0 };
+
+	TArray<FPickupSoakStep> SoakResults;
+};
@@ -4,3 +4,61 @@
 #include "Modules/ModuleManager.h"
 
 IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Shooter, "Shooter" );
+
+DEFINE_LOG_CATEGORY(LogShooter);
+
+DEFINE_STAT(STAT_ShooterTraces);
+DEFINE_STAT(STAT_ShooterEmittersSpawned);
+DEFINE_STAT(STAT_ShooterItemsTicking);
+DEFINE_STAT(STAT_ShooterTimersSet);
+DEFINE_STAT(STAT_ShooterHighlightChanges);
+
+DEFINE_STAT(STAT_HitscanShotsQueued);
+DEFINE_STAT(STAT_HitscanShotsResolved);
+DEFINE_STAT(STAT_HitscanAsyncTraces);
+DEFINE_STAT(STAT_HitscanImmediateTraces);
+DEFINE_STAT(STAT_HitscanLatencyMs);
+DEFINE_STAT(STAT_HitscanLatencyFrames);
+
+DEFINE_STAT(STAT_BallisticsProjectiles);
+DEFINE_STAT(STAT_BallisticsTraces);
+DEFINE_STAT(STAT_BallisticsHits);
+
+DEFINE_STAT(STAT_DamageHitsQueued);
+DEFINE_STAT(STAT_DamageHitsProcessed);
+DEFINE_STAT(STAT_DamageEvents);
+DEFINE_STAT(STAT_DamageHeadshots);
+
+DEFINE_STAT(STAT_ItemPoolHits);
+DEFINE_STAT(STAT_ItemPoolMisses);
+DEFINE_STAT(STAT_ItemPoolDormant);
+
+DEFINE_STAT(STAT_ItemsDormant);
+DEFINE_STAT(STAT_ItemsAwake);
+DEFINE_STAT(STAT_DormantMeshBatches);
+
+DEFINE_STAT(STAT_FootstepSurfaceCacheHits);
+DEFINE_STAT(STAT_FootstepSurfaceCacheMisses);
+
+DEFINE_STAT(STAT_EmitterComponentsCreated);
+DEFINE_STAT(STAT_EmitterComponentsReused);
+
+DEFINE_STAT(STAT_NetShotsSent);
+DEFINE_STAT(STAT_NetShotsRejected);
+DEFINE_STAT(STAT_NetShotBytes);
+
+DEFINE_STAT(STAT_NetItemDormancyFlushes);
+DEFINE_STAT(STAT_NetClientConnections);
+DEFINE_STAT(STAT_NetOutBytesPerConnection);
+DEFINE_STAT(STAT_NetOutBytesPerConnectionMax);
+
+DEFINE_STAT(STAT_AnimUpdateNear);
+DEFINE_STAT(STAT_AnimUpdateMid);
+DEFINE_STAT(STAT_AnimUpdateFar);
+DEFINE_STAT(STAT_AnimUpdateOffscreen);
+DEFINE_STAT(STAT_AnimTierNear);
+DEFINE_STAT(STAT_AnimTierMid);
+DEFINE_STAT(STAT_AnimTierFar);
+DEFINE_STAT(STAT_AnimTierOffscreen);
+DEFINE_STAT(STAT_AnimBudgetDemoted);
+DEFINE_STAT(STAT_AnimBudgetEstimatedMs);
@@ -3,9 +3,84 @@
 #pragma once
 
 #include "CoreMinimal.h"
+#include "Stats/Stats.h"
 
 #define EPS_Metal EPhysicalSurface::SurfaceType1
 #define EPS_Stone EPhysicalSurface::SurfaceType2
 #define EPS_Tile EPhysicalSurface::SurfaceType3
 #define EPS_Grass EPhysicalSurface::SurfaceType4
-#define EPS_Water EPhysicalSurface::SurfaceType5
\ No newline at end of file
+#define EPS_Water EPhysicalSurface::SurfaceType5
+
+SHOOTER_API DECLARE_LOG_CATEGORY_EXTERN(LogShooter, Log, All);
+
+// Stat group for the Shooter gameplay code, view with "stat Shooter"
+DECLARE_STATS_GROUP(TEXT("Shooter"), STATGROUP_Shooter, STATCAT_Advanced);
+
+// Gameplay counters, per frame
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Traces Issued"), STAT_ShooterTraces, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Emitters Spawned"), STAT_ShooterEmittersSpawned, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Items Ticking"), STAT_ShooterItemsTicking, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Timers Set"), STAT_ShooterTimersSet, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Highlight Changes"), STAT_ShooterHighlightChanges, STATGROUP_Shooter, SHOOTER_API);
+
+// Hitscan trace counters
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hitscan Shots Queued"), STAT_HitscanShotsQueued, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hitscan Shots Resolved"), STAT_HitscanShotsResolved, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hitscan Traces (Async)"), STAT_HitscanAsyncTraces, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hitscan Traces (Immediate)"), STAT_HitscanImmediateTraces, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Hitscan Max Latency (ms)"), STAT_HitscanLatencyMs, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Hitscan Max Latency (frames)"), STAT_HitscanLatencyFrames, STATGROUP_Shooter, SHOOTER_API);
+
+// Projectile counters
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Projectiles Live"), STAT_BallisticsProjectiles, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Projectile Traces"), STAT_BallisticsTraces, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Projectile Hits"), STAT_BallisticsHits, STATGROUP_Shooter, SHOOTER_API);
+
+// Damage counters
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Hits Queued"), STAT_DamageHitsQueued, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Hits Processed"), STAT_DamageHitsProcessed, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Events Applied"), STAT_DamageEvents, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Damage Headshots"), STAT_DamageHeadshots, STATGROUP_Shooter, SHOOTER_API);
+
+// Item pool counters
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Item Pool Hits"), STAT_ItemPoolHits, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Item Pool Misses"), STAT_ItemPoolMisses, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Item Pool Dormant Items"), STAT_ItemPoolDormant, STATGROUP_Shooter, SHOOTER_API);
+
+// Instanced pickup counters
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pickups Instanced"), STAT_ItemsDormant, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pickups Awake"), STAT_ItemsAwake, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Pickup Instance Components"), STAT_DormantMeshBatches, STATGROUP_Shooter, SHOOTER_API);
+
+// Footstep surface counters
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep Surface Cache Hits"), STAT_FootstepSurfaceCacheHits, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Footstep Surface Cache Misses"), STAT_FootstepSurfaceCacheMisses, STATGROUP_Shooter, SHOOTER_API);
+
+// Emitter pool counters
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Emitter Components Created"), STAT_EmitterComponentsCreated, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Emitter Components Reused"), STAT_EmitterComponentsReused, STATGROUP_Shooter, SHOOTER_API);
+
+// Replicated combat counters
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net Shots Sent"), STAT_NetShotsSent, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net Shots Rejected"), STAT_NetShotsRejected, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net Shot Payload Bytes"), STAT_NetShotBytes, STATGROUP_Shooter, SHOOTER_API);
+
+// Pickup replication and connection bandwidth, bandwidth sampled once per second on servers
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Net Item Dormancy Flushes"), STAT_NetItemDormancyFlushes, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net Client Connections"), STAT_NetClientConnections, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net Out Bytes/s per Connection (Avg)"), STAT_NetOutBytesPerConnection, STATGROUP_Shooter, SHOOTER_API);
+DECLARE_DWORD_ACCUMULATOR_STAT_EXTERN(TEXT("Net Out Bytes/s per Connection (Max)"), STAT_NetOutBytesPerConnectionMax, STATGROUP_Shooter, SHOOTER_API);
+
+// Animation budget, view with "stat ShooterAnim"
+DECLARE_STATS_GROUP(TEXT("ShooterAnim"), STATGROUP_ShooterAnim, STATCAT_Advanced);
+
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Update (Near)"), STAT_AnimUpdateNear, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Update (Mid)"), STAT_AnimUpdateMid, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Update (Far)"), STAT_AnimUpdateFar, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_CYCLE_STAT_EXTERN(TEXT("Anim Update (Offscreen)"), STAT_AnimUpdateOffscreen, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Anim Instances (Near)"), STAT_AnimTierNear, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Anim Instances (Mid)"), STAT_AnimTierMid, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Anim Instances (Far)"), STAT_AnimTierFar, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Anim Instances (Offscreen)"), STAT_AnimTierOffscreen, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Anim Instances Demoted By Budget"), STAT_AnimBudgetDemoted, STATGROUP_ShooterAnim, SHOOTER_API);
+DECLARE_FLOAT_COUNTER_STAT_EXTERN(TEXT("Anim Budget Estimated (ms)"), STAT_AnimBudgetEstimatedMs, STATGROUP_ShooterAnim, SHOOTER_API);
@@ -3,12 +3,19 @@
 
 #include "ShooterAnimInstance.h"
 
+#include "AnimBudgetSubsystem.h"
+#include "Shooter.h"
 #include "ShooterCharacter.h"
+#include "ShooterProfiling.h"
 #include "Weapon.h"
 #include "GameFramework/CharacterMovementComponent.h"
 #include "Kismet/KismetMathLibrary.h"
 
 UShooterAnimInstance::UShooterAnimInstance() :
+AnimTier(EShooterAnimTier::ESAT_Near),
+bAllowFABRIK(true),
+AppliedUpdateRate(1),
+LastUpdateSeconds(0.0),
 Speed(0.f),
 bIsInAir(false),
 bIsAccelerating(false),
@@ -17,13 +24,13 @@ LastMovementOffsetYaw(0.f),
 bAiming(false),
 TIPCharacterYaw(0.f),
 TIPCharacterYawLastFrame(0.f),
-CharacterRotation(FRotator(0.f)),
-CharacterRotationLastFrame(FRotator(0.f)),
-YawDelta(0.f),
 RootYawOffset(0.f),
 Pitch(0.f),
 bReloading(false),
 OffsetState(EOffsetState::EOS_Hip),
+CharacterRotation(FRotator(0.f)),
+CharacterRotationLastFrame(FRotator(0.f)),
+YawDelta(0.f),
 bCrouching(false),
 RecoilWeight(1.f),
 bTurningInPlace(false),
@@ -35,101 +42,178 @@ bShouldUseFABRIK(false)
 
 void UShooterAnimInstance::UpdateAnimationProperties(float DeltaTime)
 {
+}
+
+void UShooterAnimInstance::NativeUpdateAnimation(float DeltaSeconds)
+{
+	SHOOTER_PROFILE_SCOPE(ShooterAnimInstance_NativeUpdateAnimation);
+
+	Super::NativeUpdateAnimation(DeltaSeconds);
+
 	if (ShooterCharacter == nullptr)
 	{
 		ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
 	}
-	if (ShooterCharacter)
+
+	Snapshot.bValid = ShooterCharacter != nullptr;
+	if (ShooterCharacter == nullptr) return;
+
+	const UCharacterMovementComponent* CharacterMovement = ShooterCharacter->GetCharacterMovement();
+	Snapshot.Velocity = ShooterCharacter->GetVelocity();
+	Snapshot.bIsFalling = CharacterMovement->IsFalling();
+	Snapshot.bIsAccelerating = CharacterMovement->GetCurrentAcceleration().Size() > 0.f;
+	Snapshot.bCrouching = ShooterCharacter->GetCrouching();
+	Snapshot.bAiming = ShooterCharacter->GetAiming();
+	Snapshot.AimRotation = ShooterCharacter->GetBaseAimRotation();
+	Snapshot.ActorRotation = ShooterCharacter->GetActorRotation();
+	Snapshot.CombatState = ShooterCharacter->GetCombatState();
+
+	const AWeapon* EquippedWeapon = ShooterCharacter->GetEquippedWeapon();
+	Snapshot.bHasEquippedWeapon = EquippedWeapon != nullptr;
+	if (EquippedWeapon)
 	{
-		bCrouching = ShooterCharacter->GetCrouching();
-		bReloading = ShooterCharacter->GetCombatState() == ECombatState::ECS_Reloading;
-		bEquipping = ShooterCharacter->GetCombatState() == ECombatState::ECS_Equipping;
-		bShouldUseFABRIK = ShooterCharacter->GetCombatState() == ECombatState::ECS_Unoccupied || ShooterCharacter->GetCombatState() == ECombatState::ECS_FireTimerInProgress;
-		
-		// Get the lateral speed of the character from velocity
-		FVector Velocity{ShooterCharacter->GetVelocity()};
-		Velocity.Z = 0;
-		Speed = Velocity.Size();
+		Snapshot.EquippedWeaponType = EquippedWeapon->GetWeaponType();
+	}
 
-		// Is the character in the air?
-		bIsInAir = ShooterCharacter->GetCharacterMovement()->IsFalling();
+	Snapshot.AnimTier = AnimTier;
+	Snapshot.bAllowFABRIK = bAllowFABRIK;
+}
 
-		// Is the character accelerating?
-		if (ShooterCharacter->GetCharacterMovement()->GetCurrentAcceleration().Size() > 0.f)
-		{
-			bIsAccelerating = true;
-		}
-		else
-		{
-			bIsAccelerating = false;
-		}
+void UShooterAnimInstance::NativeThreadSafeUpdateAnimation(float DeltaSeconds)
+{
+	SHOOTER_PROFILE_SCOPE(ShooterAnimInstance_NativeThreadSafeUpdateAnimation);
 
-		FRotator AimRotation = ShooterCharacter->GetBaseAimRotation();
-		// FString RotationMessage = FString::Printf(TEXT("Base Aim Rotation %f"), AimRotation.Yaw);
+	Super::NativeThreadSafeUpdateAnimation(DeltaSeconds);
 
-		FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(ShooterCharacter->GetVelocity());
-		// FString MovementRotationMessage = FString::Printf(TEXT("Base Movement Rotation %f"), MovementRotation.Yaw);
+	if (!Snapshot.bValid) return;
 
-		MovementOffsetYaw = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, AimRotation).Yaw;
+	static const TStatId TierStats[] =
+	{
+		GET_STATID(STAT_AnimUpdateNear),
+		GET_STATID(STAT_AnimUpdateMid),
+		GET_STATID(STAT_AnimUpdateFar),
+		GET_STATID(STAT_AnimUpdateOffscreen),
+	};
+	static_assert(UE_ARRAY_COUNT(TierStats) == static_cast<int32>(EShooterAnimTier::ESAT_MAX), "One stat per anim tier");
+	FScopeCycleCounter TierCycleCounter(TierStats[static_cast<int32>(Snapshot.AnimTier)]);
+	const double UpdateStartTime{ FPlatformTime::Seconds() };
 
-		/*FString OffsetMessage = FString::Printf(TEXT("Movement Offset Yaw %f"), MovementOffsetYaw);
-		
-		if (GEngine)
-		{
-			GEngine->AddOnScreenDebugMessage(1, 0, FColor::White, OffsetMessage);
-		}*/
+	bCrouching = Snapshot.bCrouching;
+	bReloading = Snapshot.CombatState == ECombatState::ECS_Reloading;
+	bEquipping = Snapshot.CombatState == ECombatState::ECS_Equipping;
+	bShouldUseFABRIK = Snapshot.bAllowFABRIK && (Snapshot.CombatState == ECombatState::ECS_Unoccupied || Snapshot.CombatState == ECombatState::ECS_FireTimerInProgress);
 
-		if (ShooterCharacter->GetVelocity().Size() > 0.f)
-		{
-			LastMovementOffsetYaw = MovementOffsetYaw;
-		}
+	// Get the lateral speed of the character from velocity
+	FVector Velocity{ Snapshot.Velocity};
+	Velocity.Z = 0;
+	Speed = Velocity.Size();
 
-		bAiming = ShooterCharacter->GetAiming();
+	// Is the character in the air?
+	bIsInAir = Snapshot.bIsFalling;
 
-		if (bReloading)
-		{
-			OffsetState = EOffsetState::EOS_Reloading;
-		}
-		else if (bIsInAir)
-		{
-			OffsetState = EOffsetState::EOS_InAir;
-		}
-		else if (ShooterCharacter->GetAiming())
-		{
-			OffsetState = EOffsetState::EOS_Aiming;
-		}
-		else
-		{
-			OffsetState = EOffsetState::EOS_Hip;
-		}
+	// Is the character accelerating?
+	bIsAccelerating = Snapshot.bIsAccelerating;
 
-		// Check if ShooterCharacter has a valid EquippedWeapon
-		if (ShooterCharacter->GetEquippedWeapon())
-		{
-			EquippedWeaponType = ShooterCharacter->GetEquippedWeapon()->GetWeaponType();
-		}
+	const FRotator MovementRotation = UKismetMathLibrary::MakeRotFromX(Snapshot.Velocity);
+	MovementOffsetYaw = UKismetMathLibrary::NormalizedDeltaRotator(MovementRotation, Snapshot.AimRotation).Yaw;
+
+	if (Snapshot.Velocity.Size() > 0.f)
+	{
+		LastMovementOffsetYaw = MovementOffsetYaw;
+	}
+
+	bAiming = Snapshot.bAiming;
+
+	if (bReloading)
+	{
+		OffsetState = EOffsetState::EOS_Reloading;
+	}
+	else if (bIsInAir)
+	{
+		OffsetState = EOffsetState::EOS_InAir;
+	}
+	else if (bAiming)
+	{
+		OffsetState = EOffsetState::EOS_Aiming;
+	}
+	else
+	{
+		OffsetState = EOffsetState::EOS_Hip;
+	}
+
+	// Check if ShooterCharacter has a valid EquippedWeapon
+	if (Snapshot.bHasEquippedWeapon)
+	{
+		EquippedWeaponType = Snapshot.EquippedWeaponType;
 	}
 
-	TurnInPlace();
-	Lean(DeltaTime);
+	// Nobody sees turn in place or leaning off screen, keep the last values
+	if (Snapshot.AnimTier != EShooterAnimTier::ESAT_Offscreen)
+	{
+		TurnInPlace();
+		Lean(DeltaSeconds);
+	}
+
+	LastUpdateSeconds = FPlatformTime::Seconds() - UpdateStartTime;
 }
 
 void UShooterAnimInstance::NativeInitializeAnimation()
 {
 	ShooterCharacter = Cast<AShooterCharacter>(TryGetPawnOwner());
+
+	if (UAnimBudgetSubsystem* AnimBudget = GetWorld() ? GetWorld()->GetSubsystem<UAnimBudgetSubsystem>() : nullptr)
+	{
+		AnimBudget->RegisterAnimInstance(this);
+	}
+}
+
+void UShooterAnimInstance::NativeUninitializeAnimation()
+{
+	if (UAnimBudgetSubsystem* AnimBudget = GetWorld() ? GetWorld()->GetSubsystem<UAnimBudgetSubsystem>() : nullptr)
+	{
+		AnimBudget->UnregisterAnimInstance(this);
+	}
+
+	Super::NativeUninitializeAnimation();
+}
+
+void UShooterAnimInstance::SetAnimTier(EShooterAnimTier NewTier, bool bNewAllowFABRIK, int32 UpdateRate)
+{
+	AnimTier = NewTier;
+	bAllowFABRIK = bNewAllowFABRIK;
+
+	if (UpdateRate == AppliedUpdateRate) return;
+	AppliedUpdateRate = UpdateRate;
+
+	// Drive the engine's update rate optimization from our tier instead of screen size:
+	// the same frame skip for every LOD, with the skipped frames interpolated
+	USkeletalMeshComponent* Mesh = GetSkelMeshComponent();
+	if (Mesh == nullptr) return;
+
+	Mesh->bEnableUpdateRateOptimizations = true;
+	if (FAnimUpdateRateParameters* UpdateRateParams = Mesh->AnimUpdateRateParams)
+	{
+		UpdateRateParams->bShouldUseLodMap = true;
+		UpdateRateParams->bInterpolateSkippedFrames = UpdateRate > 1;
+		UpdateRateParams->LODToFrameSkipMap.Reset();
+		for (int32 LODIndex = 0; LODIndex < MAX_SKELETAL_MESH_LODS; LODIndex++)
+		{
+			UpdateRateParams->LODToFrameSkipMap.Add(LODIndex, UpdateRate - 1);
+		}
+	}
 }
 
 void UShooterAnimInstance::TurnInPlace()
 {
-	if (ShooterCharacter == nullptr) return;
+	if (!Snapshot.bValid) return;
 
-	Pitch = ShooterCharacter->GetBaseAimRotation().Pitch;
+	Pitch = Snapshot.AimRotation.Pitch;
 	
 	if (Speed > 0 || bIsInAir)
 	{
 		// Don't want to turn in place, character is moving
 		RootYawOffset = 0.f;
-		TIPCharacterYaw = ShooterCharacter->GetActorRotation().Yaw;
+		TIPCharacterYaw = Snapshot.ActorRotation.Yaw;
 		TIPCharacterYawLastFrame = TIPCharacterYaw;
 		RotationCurveLastFrame = 0.f;
 		RotationCurve = 0.f;
@@ -137,7 +221,7 @@ void UShooterAnimInstance::TurnInPlace()
 	else
 	{
 		TIPCharacterYawLastFrame = TIPCharacterYaw;
-		TIPCharacterYaw = ShooterCharacter->GetActorRotation().Yaw;
+		TIPCharacterYaw = Snapshot.ActorRotation.Yaw;
 		const float TIPYawDelta{ TIPCharacterYaw - TIPCharacterYawLastFrame};
 
 		// RootYawOffset updated and clamped to [ -180, 180 ]
@@ -209,10 +293,10 @@ void UShooterAnimInstance::TurnInPlace()
 
 void UShooterAnimInstance::Lean(float DeltaTime)
 {
-	if (ShooterCharacter == nullptr) return;
+	if (!Snapshot.bValid) return;
 
 	CharacterRotationLastFrame = CharacterRotation;
-	CharacterRotation = ShooterCharacter->GetActorRotation();
+	CharacterRotation = Snapshot.ActorRotation;
 
 	const FRotator Delta{ UKismetMathLibrary::NormalizedDeltaRotator(CharacterRotation, CharacterRotationLastFrame)};
 
@@ -4,6 +4,7 @@
 
 #include "CoreMinimal.h"
 #include "Animation/AnimInstance.h"
+#include "ShooterCharacter.h"
 #include "WeaponType.h"
 #include "ShooterAnimInstance.generated.h"
 
@@ -22,6 +23,41 @@ enum class EOffsetState : uint8
 	EOS_MAX UMETA(DisplayName = "DefaultMAX")
 };
 
+// How much animation work a character gets, picked by UAnimBudgetSubsystem
+UENUM(BlueprintType)
+enum class EShooterAnimTier : uint8
+{
+	ESAT_Near UMETA(DisplayName = "Near"),
+	ESAT_Mid UMETA(DisplayName = "Mid"),
+	ESAT_Far UMETA(DisplayName = "Far"),
+	ESAT_Offscreen UMETA(DisplayName = "Offscreen"),
+
+	ESAT_MAX UMETA(DisplayName = "DefaultMAX")
+};
+
+// Everything the anim update reads from the character, copied once per frame on the game thread
+struct FShooterAnimSnapshot
+{
+	bool bValid{ false };
+
+	FVector Velocity{ FVector::ZeroVector };
+	bool bIsFalling{ false };
+	bool bIsAccelerating{ false };
+	bool bCrouching{ false };
+	bool bAiming{ false };
+
+	FRotator AimRotation{ FRotator::ZeroRotator };
+	FRotator ActorRotation{ FRotator::ZeroRotator };
+
+	ECombatState CombatState{ ECombatState::ECS_Unoccupied };
+
+	bool bHasEquippedWeapon{ false };
+	EWeaponType EquippedWeaponType{ EWeaponType::EWT_MAX };
+
+	EShooterAnimTier AnimTier{ EShooterAnimTier::ESAT_Near };
+	bool bAllowFABRIK{ true };
+};
+
 UCLASS()
 class SHOOTER_API UShooterAnimInstance : public UAnimInstance
 {
@@ -31,11 +67,21 @@ public:
 
 	UShooterAnimInstance();
 
-	UFUNCTION(BlueprintCallable)
+	// Kept so existing AnimBP event graphs still compile. The update now happens in
+	// NativeUpdateAnimation / NativeThreadSafeUpdateAnimation, so this does nothing
+	UFUNCTION(BlueprintCallable, meta=(DeprecatedFunction, DeprecationMessage="Animation properties are updated natively, remove this call from the event graph"))
 	void UpdateAnimationProperties(float DeltaTime);
 	
 	virtual void NativeInitializeAnimation() override;
 
+	virtual void NativeUninitializeAnimation() override;
+
+	// Game thread, copies the character state into Snapshot
+	virtual void NativeUpdateAnimation(float DeltaSeconds) override;
+
+	// Worker thread, computes the anim properties from Snapshot
+	virtual void NativeThreadSafeUpdateAnimation(float DeltaSeconds) override;
+
 protected:
 	
 	// Handle Turning in place variables
@@ -44,11 +90,38 @@ protected:
 	// Handle calculations for leaning while running
 	void Lean(float DeltaTime);
 
+public:
+	/**
+	 * Called by UAnimBudgetSubsystem on the game thread.
+	 * @param UpdateRate Update the anim graph every UpdateRate frames, interpolating in between
+	 */
+	void SetAnimTier(EShooterAnimTier NewTier, bool bNewAllowFABRIK, int32 UpdateRate);
+
+	FORCEINLINE EShooterAnimTier GetAnimTier() const { return AnimTier; }
+
+	// Cost of the last native update, written on the anim worker thread
+	FORCEINLINE double GetLastUpdateSeconds() const { return LastUpdateSeconds; }
+
 private:
 
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= Movement, meta=(AllowPrivateAccess = "True"))
 	class AShooterCharacter* ShooterCharacter;
 
+	// Character state for this frame, the only thing the worker thread update reads
+	FShooterAnimSnapshot Snapshot;
+
+	// Current animation budget tier
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= "Anim Budget", meta=(AllowPrivateAccess = "True"))
+	EShooterAnimTier AnimTier;
+
+	// False when the character is past Shooter.AnimBudget.FABRIKDistance
+	bool bAllowFABRIK;
+
+	// Graph update rate last applied to the mesh
+	int32 AppliedUpdateRate;
+
+	double LastUpdateSeconds;
+
 	// Speed of the character
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= Movement, meta=(AllowPrivateAccess= "True"))
 	float Speed;
@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+// Micro-benchmarks for the gameplay code, run from the console with Shooter.Bench.*
+
+#include "Shooter.h"
+#include "AmmoType.h"
+#include "BallisticsSubsystem.h"
+#include "EnumIndexedArray.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+#include "Math/RandomStream.h"
+
+namespace ShooterBenchmarks
+{
+	// Same work as AShooterCharacter::ReloadWeapon: read carried ammo, fill the magazine, write it back
+	template<typename ReadFunc, typename WriteFunc>
+	FORCEINLINE int32 ReloadStep(EAmmoType AmmoType, int32& Magazine, ReadFunc Read, WriteFunc Write)
+	{
+		constexpr int32 MagazineCapacity{ 30 };
+		int32 CarriedAmmo = Read(AmmoType);
+		const int32 MagEmptySpace = MagazineCapacity - Magazine;
+		const int32 Loaded = FMath::Min(MagEmptySpace, CarriedAmmo);
+		Magazine = (Magazine + Loaded) % MagazineCapacity;
+		Write(AmmoType, CarriedAmmo - Loaded + MagazineCapacity);
+		return Loaded;
+	}
+
+	static void BenchmarkAmmoStorage(const TArray<FString>& Args)
+	{
+		const int32 Iterations = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 1000000;
+
+		// Random ammo types so neither loop can be folded to a constant key
+		FRandomStream Random(1337);
+		TArray<EAmmoType> AmmoTypes;
+		AmmoTypes.SetNumUninitialized(1024);
+		for (EAmmoType& AmmoType : AmmoTypes)
+		{
+			AmmoType = static_cast<EAmmoType>(Random.RandHelper(static_cast<int32>(EAmmoType::EAT_MAX)));
+		}
+
+		// Old storage, same calls the reload path used to make
+		TMap<EAmmoType, int32> AmmoMap;
+		AmmoMap.Add(EAmmoType::EAT_9mm, 85);
+		AmmoMap.Add(EAmmoType::EAT_AR, 120);
+
+		int32 MapMagazine{ 0 };
+		int64 MapLoaded{ 0 };
+		const double MapStart = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; i++)
+		{
+			MapLoaded += ReloadStep(AmmoTypes[i & 1023], MapMagazine,
+				[&AmmoMap](EAmmoType AmmoType) { return AmmoMap.Contains(AmmoType) ? AmmoMap[AmmoType] : 0; },
+				[&AmmoMap](EAmmoType AmmoType, int32 Count) { AmmoMap.Add(AmmoType, Count); });
+		}
+		const double MapSeconds = FPlatformTime::Seconds() - MapStart;
+
+		TEnumIndexedArray<EAmmoType, int32, EAmmoType::EAT_MAX> AmmoCounts;
+		AmmoCounts[EAmmoType::EAT_9mm] = 85;
+		AmmoCounts[EAmmoType::EAT_AR] = 120;
+
+		int32 ArrayMagazine{ 0 };
+		int64 ArrayLoaded{ 0 };
+		const double ArrayStart = FPlatformTime::Seconds();
+		for (int32 i = 0; i < Iterations; i++)
+		{
+			ArrayLoaded += ReloadStep(AmmoTypes[i & 1023], ArrayMagazine,
+				[&AmmoCounts](EAmmoType AmmoType) { return AmmoCounts.FindRef(AmmoType); },
+				[&AmmoCounts](EAmmoType AmmoType, int32 Count) { if (int32* AmmoCount = AmmoCounts.Find(AmmoType)) *AmmoCount = Count; });
+		}
+		const double ArraySeconds = FPlatformTime::Seconds() - ArrayStart;
+
+		// Both loops do the same work, so the totals must match
+		ensure(MapLoaded == ArrayLoaded);
+
+		UE_LOG(LogShooter, Display, TEXT("Ammo storage, %d reloads: TMap %.3f ms (%.2f ns/reload), TEnumIndexedArray %.3f ms (%.2f ns/reload), %.2fx"),
+			Iterations,
+			MapSeconds * 1000.0, MapSeconds * 1e9 / Iterations,
+			ArraySeconds * 1000.0, ArraySeconds * 1e9 / Iterations,
+			ArraySeconds > 0.0 ? MapSeconds / ArraySeconds : 0.0);
+	}
+
+	static FAutoConsoleCommand BenchmarkAmmoStorageCommand(
+		TEXT("Shooter.Bench.AmmoStorage"),
+		TEXT("Times the reload path against TMap and TEnumIndexedArray ammo storage. Usage: Shooter.Bench.AmmoStorage [Iterations]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkAmmoStorage));
+
+	static void FillProjectiles(FProjectileArrays& Projectiles, int32 NumRounds)
+	{
+		FRandomStream Random(1337);
+		Projectiles.Reset();
+		for (int32 i = 0; i < NumRounds; i++)
+		{
+			const FVector Location{ Random.FRandRange(-1e5f, 1e5f), Random.FRandRange(-1e5f, 1e5f), Random.FRandRange(0.f, 1e4f) };
+			Projectiles.Add(Location, Random.GetUnitVector() * Random.FRandRange(30000.f, 90000.f), Random.FRandRange(0.f, 2e-5f), -980.f);
+		}
+	}
+
+	static void BenchmarkBallistics(const TArray<FString>& Args)
+	{
+		const int32 NumRounds = Args.Num() > 0 ? FMath::Max(1, FCString::Atoi(*Args[0])) : 10000;
+		const int32 NumSteps = Args.Num() > 1 ? FMath::Max(1, FCString::Atoi(*Args[1])) : 1000;
+		constexpr float Substep{ 1.f / 120.f };
+
+		FProjectileArrays ScalarRounds;
+		FillProjectiles(ScalarRounds, NumRounds);
+		const double ScalarStart = FPlatformTime::Seconds();
+		for (int32 Step = 0; Step < NumSteps; Step++)
+		{
+			ScalarRounds.IntegrateScalar(Substep);
+		}
+		const double ScalarSeconds = FPlatformTime::Seconds() - ScalarStart;
+
+		FProjectileArrays VectorRounds;
+		FillProjectiles(VectorRounds, NumRounds);
+		const double VectorStart = FPlatformTime::Seconds();
+		for (int32 Step = 0; Step < NumSteps; Step++)
+		{
+			VectorRounds.Integrate(Substep);
+		}
+		const double VectorSeconds = FPlatformTime::Seconds() - VectorStart;
+
+		// Fused multiply-adds round differently, so the two paths only agree closely
+		float MaxError{ 0.f };
+		for (int32 i = 0; i < NumRounds; i++)
+		{
+			MaxError = FMath::Max(MaxError, FVector::Dist(ScalarRounds.GetPosition(i), VectorRounds.GetPosition(i)));
+		}
+
+		const double RoundSteps = static_cast<double>(NumRounds) * NumSteps;
+		UE_LOG(LogShooter, Display, TEXT("Ballistics, %d rounds x %d substeps: scalar %.3f ms (%.1f M round steps/s), vector %.3f ms (%.1f M round steps/s), %.2fx, max position difference %.4f"),
+			NumRounds, NumSteps,
+			ScalarSeconds * 1000.0, ScalarSeconds > 0.0 ? RoundSteps / ScalarSeconds * 1e-6 : 0.0,
+			VectorSeconds * 1000.0, VectorSeconds > 0.0 ? RoundSteps / VectorSeconds * 1e-6 : 0.0,
+			VectorSeconds > 0.0 ? ScalarSeconds / VectorSeconds : 0.0,
+			MaxError);
+	}
+
+	static FAutoConsoleCommand BenchmarkBallisticsCommand(
+		TEXT("Shooter.Bench.Ballistics"),
+		TEXT("Times the projectile integrator one round at a time and four at a time. Usage: Shooter.Bench.Ballistics [Rounds] [Substeps]"),
+		FConsoleCommandWithArgsDelegate::CreateStatic(&BenchmarkBallistics));
+}
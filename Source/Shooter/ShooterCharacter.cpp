@@ -3,19 +3,34 @@
 
 #include "ShooterCharacter.h"
 #include "Shooter.h"
+#include "ShooterProfiling.h"
 #include "Ammo.h"
+#include "BallisticsSubsystem.h"
+#include "DamageSubsystem.h"
+#include "EmitterPoolSubsystem.h"
+#include "FootstepSurfaceSubsystem.h"
+#include "HitscanSubsystem.h"
 #include "Item.h"
+#include "ItemHighlightSubsystem.h"
+#include "ItemPoolSubsystem.h"
+#include "ItemRegistrySubsystem.h"
 #include "NavigationSystemTypes.h"
 #include "ParticleHelper.h"
+#include "ShooterCharacterBatchSubsystem.h"
+#include "ShooterInventoryComponent.h"
+#include "ShotValidationSubsystem.h"
 #include "Weapon.h"
 #include "Camera/CameraComponent.h"
 #include "Components/CapsuleComponent.h"
 #include "Components/WidgetComponent.h"
 #include "Engine/SkeletalMeshSocket.h"
 #include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/GameStateBase.h"
 #include "GameFramework\SpringArmComponent.h"
 #include "Kismet/GameplayStatics.h"
+#include "Net/UnrealNetwork.h"
 #include "Particles/ParticleSystemComponent.h"
+#include "Serialization/BitWriter.h"
 #include "Sound/SoundCue.h"
 
 // Sets default values
@@ -53,6 +68,8 @@ bShouldFire(true),
 bFireButtonPressed(false),
 // Item trace variables
 bShouldTraceForItems(false),
+OverlappedItemCount(0),
+ItemTraceConeHalfAngle(15.f),
 // Camera Interp location variables
 CameraInterpDistance(250.f),
 CameraInterpElevation(65.f),
@@ -61,6 +78,14 @@ Starting9mmAmmo(85),
 StartingARAmmo(120),
 // Combat variables
 CombatState(ECombatState::ECS_Unoccupied),
+NextShotSeed(0),
+ServerShotTokens(2.f),
+ServerShotTokensTime(0.f),
+Health(100.f),
+MaxHealth(100.f),
+HeadDamageMultiplier(2.f),
+TorsoDamageMultiplier(1.f),
+LimbDamageMultiplier(0.75f),
 // Movement variables
 bCrouching(false),
 BaseMovementSpeed(650.f),
@@ -105,6 +130,17 @@ HighlightedSlot(-1)
 	GetCharacterMovement()->JumpZVelocity = 600.f;
 	GetCharacterMovement()->AirControl = 0.2f;
 
+	// Update rate params are only created on register when this is set, UAnimBudgetSubsystem drives them
+	GetMesh()->bEnableUpdateRateOptimizations = true;
+
+	// Hit zones of the UE mannequin skeleton
+	HitZoneBones.Add(TEXT("neck_01"), EHitZone::EHZ_Head);
+	HitZoneBones.Add(TEXT("head"), EHitZone::EHZ_Head);
+	HitZoneBones.Add(TEXT("clavicle_l"), EHitZone::EHZ_Limb);
+	HitZoneBones.Add(TEXT("clavicle_r"), EHitZone::EHZ_Limb);
+	HitZoneBones.Add(TEXT("thigh_l"), EHitZone::EHZ_Limb);
+	HitZoneBones.Add(TEXT("thigh_r"), EHitZone::EHZ_Limb);
+
 	// Create HandScene Component
 	HandSceneComponent = CreateDefaultSubobject<USceneComponent>(TEXT("HandSceneComp"));
 
@@ -129,6 +165,8 @@ HighlightedSlot(-1)
 
 	InterpComp6 = CreateDefaultSubobject<USceneComponent>(TEXT("Interpolation Component 6"));
 	InterpComp6->SetupAttachment(GetFollowCamera());
+
+	InventoryComponent = CreateDefaultSubobject<UShooterInventoryComponent>(TEXT("InventoryComponent"));
 }
 
 // Called when the game starts or when spawned
@@ -142,13 +180,32 @@ void AShooterCharacter::BeginPlay()
 		CameraCurrentFOV = CameraDefaultFOV;
 	}
 
-	// Spawn the default weapon and equip it
-	EquipWeapon(SpawnDefaultWeapon());
-	Inventory.Add(EquippedWeapon);
-	EquippedWeapon->SetSlotIndex(0);
-	EquippedWeapon->DisableCustomDepth();
-	EquippedWeapon->DisableGlowMaterial();
-	EquippedWeapon->SetCharacter(this);
+	InventoryComponent->OnSlotsChanged.AddUObject(this, &AShooterCharacter::OnInventorySlotsChanged);
+
+	if (UShooterCharacterBatchSubsystem* CharacterBatch = GetWorld()->GetSubsystem<UShooterCharacterBatchSubsystem>())
+	{
+		CharacterBatch->RegisterCharacter(this);
+	}
+
+	// The server spawns the default weapon, clients get it through OnRep_EquippedWeapon
+	if (HasAuthority())
+	{
+		// Blueprints may change MaxHealth, start full
+		Health = MaxHealth;
+
+		// Spawn the default weapon and equip it
+		EquipWeapon(SpawnDefaultWeapon());
+		InventoryComponent->SetSlot(0, EquippedWeapon);
+		EquippedWeapon->SetSlotIndex(0);
+		EquippedWeapon->DisableCustomDepth();
+		EquippedWeapon->DisableGlowMaterial();
+		EquippedWeapon->SetCharacter(this);
+
+		if (UShotValidationSubsystem* ShotValidation = GetWorld()->GetSubsystem<UShotValidationSubsystem>())
+		{
+			ShotValidation->RegisterCharacter(this);
+		}
+	}
 
 	InitializeAmmoMap();
 
@@ -226,6 +283,20 @@ void AShooterCharacter::LookUp(float Value)
 	AddControllerPitchInput(Value * LookUpScaleFactor);
 }
 
+void AShooterCharacter::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (UShotValidationSubsystem* ShotValidation = GetWorld()->GetSubsystem<UShotValidationSubsystem>())
+	{
+		ShotValidation->UnregisterCharacter(this);
+	}
+	if (UShooterCharacterBatchSubsystem* CharacterBatch = GetWorld()->GetSubsystem<UShooterCharacterBatchSubsystem>())
+	{
+		CharacterBatch->UnregisterCharacter(this);
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 void AShooterCharacter::FireWeapon()
 {
 	if (EquippedWeapon == nullptr) return;
@@ -236,6 +307,28 @@ void AShooterCharacter::FireWeapon()
 		PlayFireSound();
 		// Send bullet
 		SendBullet();
+		// Clients fire on the server too, the effects above were predicted
+		if (!HasAuthority())
+		{
+			FShotPacket Packet;
+			if (MakeShotPacket(Packet))
+			{
+				ServerFire(Packet);
+				if (UShotValidationSubsystem* ShotValidation = GetWorld()->GetSubsystem<UShotValidationSubsystem>())
+				{
+					ShotValidation->RecordShotSent(Packet.GetSerializedBits());
+				}
+			}
+		}
+		// A listen server's own shots don't go through ServerFire, show them to the clients from here, hit or miss
+		else if (IsLocallyControlled() && GetNetMode() != NM_Standalone)
+		{
+			// SendBullet already traced the crosshair this frame, use its result rather than tracing again
+			const bool bTraced{ IsCrosshairCacheValid() && CrosshairCache.bTraced };
+			const bool bHit{ bTraced && CrosshairCache.HitResult.bBlockingHit };
+			const FVector ImpactPoint{ bHit ? CrosshairCache.HitResult.Location : (bTraced ? CrosshairCache.TraceEnd : GetActorLocation()) };
+			MulticastShotCosmetics(ImpactPoint, bHit);
+		}
 		// Play Hip Fire Montage
 		PlayGunFireMontage();
 		// Subtract 1 from the weapon's ammo
@@ -246,13 +339,17 @@ void AShooterCharacter::FireWeapon()
 		if (EquippedWeapon->GetWeaponType() == EWeaponType::EWT_Pistol)
 		{
 			// Start moving slide timer
-			EquippedWeapon->StartSlideTimer();
+			EquippedWeapon->StartSlideTimer(GetCombatTime());
 		}
 	}
 }
 
-bool AShooterCharacter::GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation)
+bool AShooterCharacter::GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation, FHitResult* OutWeaponTraceHit)
 {
+	// Nothing to aim from, OutBeamLocation would be left unset
+	FVector CrosshairTraceStart;
+	FVector CrosshairTraceEnd;
+	if (!GetCrosshairTraceSegment(CrosshairTraceStart, CrosshairTraceEnd)) return false;
 
 	// Check for crosshair trace hit
 	FHitResult CrosshairHitResult;
@@ -276,6 +373,12 @@ bool AShooterCharacter::GetBeamEndLocation(const FVector& MuzzleSocketLocation,
 
 	// Trace outward from gun barrel world location
 	GetWorld()->LineTraceSingleByChannel(WeaponTraceHit, WeaponTraceStart, WeaponTraceEnd, ECC_Visibility);
+	INC_DWORD_STAT(STAT_ShooterTraces);
+	INC_DWORD_STAT(STAT_HitscanImmediateTraces);
+	if (OutWeaponTraceHit)
+	{
+		*OutWeaponTraceHit = WeaponTraceHit;
+	}
 	if (WeaponTraceHit.bBlockingHit) // Object between barrel and beam end point.
 	{
 		OutBeamLocation = WeaponTraceHit.Location;
@@ -305,22 +408,17 @@ void AShooterCharacter::AimingButtonReleased()
 
 void AShooterCharacter::SetCameraFOV(float DeltaTime)
 {
-	// Set current camera field of view
-	if (bAiming)
-	{
-		// Interp to zoomed FOV
-		CameraCurrentFOV = FMath::FInterpTo(CameraCurrentFOV, CameraZoomedFOV, DeltaTime, ZoomInterpSpeed);\
-	}
-	else
-	{
-		// Interp to Default FOV
-		CameraCurrentFOV = FMath::FInterpTo(CameraCurrentFOV, CameraDefaultFOV, DeltaTime, ZoomInterpSpeed);
-	}
+	SHOOTER_PROFILE_SCOPE(ShooterCharacter_SetCameraFOV);
+
+	// Interp to the zoomed FOV while aiming, back to the default FOV otherwise
+	CameraCurrentFOV = ShooterCharacterMath::InterpCameraFOV(CameraCurrentFOV, bAiming ? CameraZoomedFOV : CameraDefaultFOV, DeltaTime, ZoomInterpSpeed);
 	GetFollowCamera()->SetFieldOfView(CameraCurrentFOV);
 }
 
 void AShooterCharacter::SetLookRates()
 {
+	SHOOTER_PROFILE_SCOPE(ShooterCharacter_SetLookRates);
+
 	if (bAiming)
 	{
 		BaseTurnRate = AimingTurnRate;
@@ -335,56 +433,25 @@ void AShooterCharacter::SetLookRates()
 
 void AShooterCharacter::CalculateCrosshairSpread(float DeltaTime)
 {
-	FVector2D WalkSpeedRange{0.f, 600.f};
-	FVector2D VelocityMultiplierRange{0.f, 1.f};
+	SHOOTER_PROFILE_SCOPE(ShooterCharacter_CalculateCrosshairSpread);
+
 	FVector Velocity{ GetVelocity()};
 	Velocity.Z = 0;
 
-	// Calculate crosshair velocity factor
-	CrosshairVelocityFactor = FMath::GetMappedRangeValueClamped(WalkSpeedRange, VelocityMultiplierRange, Velocity.Size());
-
-	// Calculate crosshair in air factor
-	if (GetCharacterMovement()->IsFalling()) // Is character in air?
-	{
-		// Spread the crosshairs slowly while in air
-		CrosshairInAirFactor = FMath::FInterpTo(CrosshairInAirFactor, 2.25f, DeltaTime, 2.25f);
-	}
-	else // Character is on the ground
-	{
-		// Shrink the crosshairs rapidly while on the ground
-		CrosshairInAirFactor = FMath::FInterpTo(CrosshairInAirFactor, 0.f, DeltaTime, 30.f);
-	}
-
-	// Calculate Crosshair aim factor
-	if (bAiming) // Are we aiming?
-	{
-		// Shrink crosshairs a small amount very quickly 
-		CrosshairAimFactor = FMath::FInterpTo(CrosshairAimFactor,0.6f, DeltaTime, 30.f);
-	}
-	else // Not aiming
-	{
-		// Spread crosshairs a small amount very quickly
-		CrosshairAimFactor = FMath::FInterpTo(0.f, CrosshairAimFactor, DeltaTime, 30.f);
-	}
+	// Calculate crosshair velocity, in air, aim and shooting factors. bFiringBullet is true 0.05 seconds after firing
+	CrosshairVelocityFactor = ShooterCharacterMath::CrosshairVelocityFactor(Velocity.Size());
+	CrosshairInAirFactor = ShooterCharacterMath::InterpCrosshairInAirFactor(CrosshairInAirFactor, GetCharacterMovement()->IsFalling(), DeltaTime);
+	CrosshairAimFactor = ShooterCharacterMath::InterpCrosshairAimFactor(CrosshairAimFactor, bAiming, DeltaTime);
+	CrosshairShootingFactor = ShooterCharacterMath::InterpCrosshairShootingFactor(CrosshairShootingFactor, bFiringBullet, DeltaTime);
 
-	// True 0.05 seconds after firing
-	if (bFiringBullet)
-	{
-		CrosshairShootingFactor = FMath::FInterpTo(CrosshairShootingFactor, 0.3f, DeltaTime, 60.f);
-	}
-	else
-	{
-		CrosshairShootingFactor = FMath::FInterpTo(CrosshairShootingFactor, 0, DeltaTime, 60.f);
-	}
-	
-	CrosshairSpreadMultiplier = 0.5f + CrosshairVelocityFactor + CrosshairInAirFactor - CrosshairAimFactor + CrosshairShootingFactor;
+	CrosshairSpreadMultiplier = ShooterCharacterMath::CrosshairSpreadMultiplier(CrosshairVelocityFactor, CrosshairInAirFactor, CrosshairAimFactor, CrosshairShootingFactor);
 }
 
 void AShooterCharacter::StartCrosshairBulletFire()
 {
 	bFiringBullet = true;
 
-	GetWorldTimerManager().SetTimer(CrosshairShootTimer, this, &AShooterCharacter::FinishCrosshairBulletFire, ShootTimeDuration);
+	CombatClock.Schedule(ECombatClockEvent::ECCE_CrosshairShoot, GetCombatTime(), ShootTimeDuration);
 }
 
 void AShooterCharacter::FinishCrosshairBulletFire()
@@ -408,8 +475,9 @@ void AShooterCharacter::StartFireTimer()
 {
 	if (EquippedWeapon == nullptr ) return;
 	CombatState = ECombatState::ECS_FireTimerInProgress;
-	
-	GetWorldTimerManager().SetTimer(AutoFireTimer, this, &AShooterCharacter::AutoFireReset, EquippedWeapon->GetAutoFireRate());
+
+	// From the previous shot's due time when re-arming from AutoFireReset, so the cadence doesn't depend on the frame rate
+	CombatClock.Schedule(ECombatClockEvent::ECCE_AutoFire, GetCombatTime(), EquippedWeapon->GetAutoFireRate());
 }
 
 void AShooterCharacter::AutoFireReset()
@@ -423,37 +491,93 @@ void AShooterCharacter::AutoFireReset()
 			FireWeapon();
 		}
 	}
-	else
+	else if (IsLocallyControlled())
 	{
-		// Reload weapon
+		// Reload weapon, the server waits for the client to ask
 		ReloadWeapon();
 	}
 }
 
-bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector& OutHitLocation)
+bool AShooterCharacter::IsCrosshairCacheValid() const
+{
+	if (CrosshairCache.FrameNumber != GFrameCounter) return false;
+
+	// Camera moved or controller rotated since the cache was filled
+	const FVector CameraLocation{ FollowCamera ? FollowCamera->GetComponentLocation() : FVector::ZeroVector};
+	const FRotator ControlRotation{ Controller ? Controller->GetControlRotation() : FRotator::ZeroRotator};
+	return CrosshairCache.CameraLocation.Equals(CameraLocation) && CrosshairCache.ControlRotation.Equals(ControlRotation);
+}
+
+bool AShooterCharacter::GetCrosshairTraceSegment(FVector& OutStart, FVector& OutEnd)
 {
-	// Get viewport size
-	FVector2D ViewportSize;
-	if (GEngine && GEngine->GameViewport)
+	if (!IsCrosshairCacheValid())
 	{
-		GEngine->GameViewport->GetViewportSize(ViewportSize);
-	}
+		CrosshairCache.FrameNumber = GFrameCounter;
+		CrosshairCache.CameraLocation = FollowCamera ? FollowCamera->GetComponentLocation() : FVector::ZeroVector;
+		CrosshairCache.ControlRotation = Controller ? Controller->GetControlRotation() : FRotator::ZeroRotator;
+		CrosshairCache.bTraced = false;
+
+		// Get viewport size
+		FVector2D ViewportSize{ FVector2D::ZeroVector };
+		if (GEngine && GEngine->GameViewport)
+		{
+			GEngine->GameViewport->GetViewportSize(ViewportSize);
+		}
+		else if (Controller && IsLocallyControlled())
+		{
+			// Headless, e.g. the simulation commandlet, aim from the eyes along the control rotation instead
+			CrosshairCache.bHasSegment = true;
+			CrosshairCache.TraceStart = GetPawnViewLocation();
+			CrosshairCache.TraceEnd = CrosshairCache.TraceStart + CrosshairCache.ControlRotation.Vector() * 50'000.f;
+			OutStart = CrosshairCache.TraceStart;
+			OutEnd = CrosshairCache.TraceEnd;
+			return true;
+		}
+		else
+		{
+			// No viewport and no one to aim for, there is no crosshair
+			CrosshairCache.bHasSegment = false;
+			return false;
+		}
 
-	FVector2D CrosshairLocation(ViewportSize.X / 2.f, ViewportSize.Y / 2.f);
+		FVector2D CrosshairLocation(ViewportSize.X / 2.f, ViewportSize.Y / 2.f);
 
-	FVector CrosshairWorldPosition;
-	FVector CrosshairWorldDirection;
-	
-	// Get world position and direction of Crosshair.
-	bool bScreenToWorld = UGameplayStatics::DeprojectScreenToWorld(UGameplayStatics::GetPlayerController(this, 0), CrosshairLocation,
-		CrosshairWorldPosition, CrosshairWorldDirection);
+		FVector CrosshairWorldPosition;
+		FVector CrosshairWorldDirection;
+		
+		// Get world position and direction of Crosshair.
+		CrosshairCache.bHasSegment = UGameplayStatics::DeprojectScreenToWorld(UGameplayStatics::GetPlayerController(this, 0), CrosshairLocation,
+			CrosshairWorldPosition, CrosshairWorldDirection);
+
+		if (CrosshairCache.bHasSegment)
+		{
+			// Trace from crosshair world location outward
+			CrosshairCache.TraceStart = CrosshairWorldPosition;
+			CrosshairCache.TraceEnd = CrosshairWorldPosition + CrosshairWorldDirection * 50'000.f;
+		}
+	}
 
-	if (bScreenToWorld)
+	OutStart = CrosshairCache.TraceStart;
+	OutEnd = CrosshairCache.TraceEnd;
+	return CrosshairCache.bHasSegment;
+}
+
+bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector& OutHitLocation)
+{
+	FVector Start;
+	FVector End;
+	if (GetCrosshairTraceSegment(Start, End))
 	{
-		// Trace from crosshair world location outward
-		const FVector Start{ CrosshairWorldPosition};
-		const FVector End{ Start + CrosshairWorldDirection * 50'000.f};
-		GetWorld()->LineTraceSingleByChannel(OutHitResult, Start, End, ECC_Visibility);
+		// Only the first query this frame hits the scene, the rest reuse its result
+		if (!CrosshairCache.bTraced)
+		{
+			GetWorld()->LineTraceSingleByChannel(CrosshairCache.HitResult, Start, End, ECC_Visibility);
+			INC_DWORD_STAT(STAT_ShooterTraces);
+			INC_DWORD_STAT(STAT_HitscanImmediateTraces);
+			CrosshairCache.bTraced = true;
+		}
+
+		OutHitResult = CrosshairCache.HitResult;
 		OutHitLocation = End;
 		
 		if (OutHitResult.bBlockingHit)
@@ -466,8 +590,67 @@ bool AShooterCharacter::TraceUnderCrosshairs(FHitResult& OutHitResult, FVector&
 	return false;
 }
 
+void AShooterCharacter::UpdateNearbyItems()
+{
+	SHOOTER_PROFILE_SCOPE(ShooterCharacter_UpdateNearbyItems);
+
+	UItemRegistrySubsystem* ItemRegistry = GetWorld()->GetSubsystem<UItemRegistrySubsystem>();
+	if (ItemRegistry == nullptr) return;
+
+	NearbyItems.Reset();
+	ItemRegistry->QueryItemsInPickupRange(GetActorLocation(), NearbyItems);
+
+	// Stream in the sounds, icons and crosshairs of weapons we could pick up
+	for (AItem* Item : NearbyItems)
+	{
+		if (AWeapon* Weapon = Cast<AWeapon>(Item))
+		{
+			Weapon->PrefetchEquipAssets();
+		}
+	}
+
+	const int8 NearbyItemCount = static_cast<int8>(FMath::Min(NearbyItems.Num(), static_cast<int32>(MAX_int8)));
+	if (NearbyItemCount > OverlappedItemCount)
+	{
+		// Entered the pickup range of another item
+		UnHighlightInventorySlot();
+	}
+	OverlappedItemCount = NearbyItemCount;
+
+	// Only trace when an item in range is inside a cone around the crosshair ray
+	bShouldTraceForItems = false;
+	FVector RayStart;
+	FVector RayEnd;
+	if (NearbyItems.Num() == 0 || !GetCrosshairTraceSegment(RayStart, RayEnd)) return;
+
+	const FVector RayDirection{ (RayEnd - RayStart).GetSafeNormal()};
+	const float ConeSlope{ FMath::Tan(FMath::DegreesToRadians(ItemTraceConeHalfAngle))};
+
+	for (const AItem* Item : NearbyItems)
+	{
+		FVector ItemOrigin;
+		FVector ItemExtent;
+		Item->GetActorBounds(true, ItemOrigin, ItemExtent);
+
+		const FVector RayToItem{ ItemOrigin - RayStart};
+		const float DistanceAlongRay{ static_cast<float>(FVector::DotProduct(RayToItem, RayDirection))};
+		if (DistanceAlongRay < 0.f) continue;
+
+		// Cone widens with distance, padded by the item's bounds
+		const float AllowedRadius{ static_cast<float>(ItemExtent.Size()) + DistanceAlongRay * ConeSlope};
+		const float DistanceFromRaySquared{ static_cast<float>(RayToItem.SizeSquared()) - FMath::Square(DistanceAlongRay)};
+		if (DistanceFromRaySquared <= FMath::Square(AllowedRadius))
+		{
+			bShouldTraceForItems = true;
+			return;
+		}
+	}
+}
+
 void AShooterCharacter::TraceForItems()
 {
+	SHOOTER_PROFILE_SCOPE(ShooterCharacter_TraceForItems);
+
 	if (bShouldTraceForItems)
 	{
 		FHitResult ItemTraceResult;
@@ -500,44 +683,16 @@ void AShooterCharacter::TraceForItems()
 			{
 				TraceHitItem = nullptr;
 			}
-			
-			if (TraceHitItem && TraceHitItem->GetPickupWidget())
-			{
-				// Show Item's Pickup Widget
-				TraceHitItem->GetPickupWidget()->SetVisibility(true);
-				TraceHitItem->EnableCustomDepth();
 
-				if (Inventory.Num() >= INVENTORY_CAPACITY)
-				{
-					// Inventory is full
-					TraceHitItem->SetCharacterInventoryFull(true);
-				}
-				else
-				{
-					// Inventory has room
-					TraceHitItem->SetCharacterInventoryFull(false);
-				}
-			}
-
-			// We hit an AItem last frame
-			if (TraceHitItemLastFrame)
-			{
-				if (TraceHitItem != TraceHitItemLastFrame)
-				{
-					// We are hitting a different AItem this frame from last frame OR AItem is null
-					TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
-					TraceHitItemLastFrame->DisableCustomDepth();
-				}
-			}
-			// Store a reference to HitItem for next frame
-			TraceHitItemLastFrame = TraceHitItem;
+			// Shows the pickup widget and outline, the highlight subsystem only acts when the item changes
+			SetHighlightedItem(TraceHitItem);
 		}
 	}
 	else if (TraceHitItemLastFrame)
 	{
-		// No longer overlapping any items, Item last frame should not show widget
-		TraceHitItemLastFrame->GetPickupWidget()->SetVisibility(false);
-		TraceHitItemLastFrame->DisableCustomDepth();
+		// No longer near or looking at any items, Item last frame should not show widget
+		SetHighlightedItem(nullptr);
+		TraceHitItem = nullptr;
 	}
 }
 
@@ -546,6 +701,11 @@ AWeapon* AShooterCharacter::SpawnDefaultWeapon()
 	// Check the TSubClassOf variable
 	if (DefaultWeaponClass)
 	{
+		// Take the weapon from the pool, which spawns one if it's empty
+		if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+		{
+			return ItemPool->AcquireItem<AWeapon>(DefaultWeaponClass, GetActorTransform());
+		}
 		// Spawn the weapon
 		return GetWorld()->SpawnActor<AWeapon>(DefaultWeaponClass);
 	}
@@ -563,15 +723,17 @@ void AShooterCharacter::EquipWeapon(AWeapon* WeaponToEquip, bool bSwapping)
 			// Attach the weapon to the right hand socket
 			HandSocket->AttachActor(WeaponToEquip, GetMesh());
 		}
+		// The owner predicts the weapon's ammo, so it isn't replicated to it
+		WeaponToEquip->SetOwner(this);
 
 		if (EquippedWeapon == nullptr)
 		{
 			// -1 == no EquippedWeapon yet. No need to reverse Icon information
-			EquipItemDelegate.Broadcast(-1, WeaponToEquip->GetSlotIndex() );
+			InventoryComponent->QueueEquipEvent(-1, WeaponToEquip->GetSlotIndex());
 		}
 		else if (!bSwapping)
 		{
-			EquipItemDelegate.Broadcast(EquippedWeapon->GetSlotIndex(), WeaponToEquip->GetSlotIndex() );
+			InventoryComponent->QueueEquipEvent(EquippedWeapon->GetSlotIndex(), WeaponToEquip->GetSlotIndex());
 		}
 		// Set equipped weapon to the newly spawned weapon
 		EquippedWeapon = WeaponToEquip;
@@ -587,6 +749,16 @@ void AShooterCharacter::DropWeapon()
 		EquippedWeapon->GetItemMesh()->DetachFromComponent(DetachmentTransformRules);
 		EquippedWeapon->SetItemState(EItemState::EIS_Falling);
 		EquippedWeapon->ThrowWeapon();
+		EquippedWeapon->SetOwner(nullptr);
+
+		// Keeps the number of weapons lying around bounded, the oldest go back to the pool for SpawnDefaultWeapon
+		if (HasAuthority())
+		{
+			if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+			{
+				ItemPool->AddDroppedItem(EquippedWeapon);
+			}
+		}
 	}
 }
 
@@ -595,6 +767,10 @@ void AShooterCharacter::SelectButtonPressed()
 	if (CombatState != ECombatState::ECS_Unoccupied) return;
 	if (TraceHitItem)
 	{
+		if (!HasAuthority())
+		{
+			ServerSelectItem(TraceHitItem);
+		}
 		TraceHitItem->StartItemCurve(this, true);
 		TraceHitItem = nullptr;
 	}
@@ -606,22 +782,57 @@ void AShooterCharacter::SelectButtonReleased()
 
 void AShooterCharacter::SwapWeapon(AWeapon* WeaponToSwap)
 {
-	if ( Inventory.Num() - 1 >= EquippedWeapon->GetSlotIndex() )
+	if (InventoryComponent->IsSlotOccupied(EquippedWeapon->GetSlotIndex()))
 	{
-		Inventory[EquippedWeapon->GetSlotIndex()] = WeaponToSwap;
+		InventoryComponent->SetSlot(EquippedWeapon->GetSlotIndex(), WeaponToSwap);
 		WeaponToSwap->SetSlotIndex(EquippedWeapon->GetSlotIndex());
 	}
 	
 	DropWeapon();
 	EquipWeapon(WeaponToSwap, true);
 	TraceHitItem = nullptr;
-	TraceHitItemLastFrame = nullptr;
+	SetHighlightedItem(nullptr);
+}
+
+void AShooterCharacter::SetHighlightedItem(AItem* Item)
+{
+	TraceHitItemLastFrame = Item;
+
+	if (UItemHighlightSubsystem* Highlights = GetWorld()->GetSubsystem<UItemHighlightSubsystem>())
+	{
+		Highlights->SetFocusedItem(this, Item, InventoryComponent->IsFull());
+	}
 }
 
 void AShooterCharacter::InitializeAmmoMap()
 {
-	AmmoMap.Add(EAmmoType::EAT_9mm, Starting9mmAmmo);
-	AmmoMap.Add(EAmmoType::EAT_AR, StartingARAmmo);
+	InventoryComponent->SetAmmoCount(EAmmoType::EAT_9mm, Starting9mmAmmo);
+	InventoryComponent->SetAmmoCount(EAmmoType::EAT_AR, StartingARAmmo);
+}
+
+TArray<AItem*> AShooterCharacter::GetInventoryItems() const
+{
+	// Occupied slots in slot order, like the old array
+	TArray<AItem*> Items;
+	for (int32 SlotIndex = 0; SlotIndex < UShooterInventoryComponent::Capacity; SlotIndex++)
+	{
+		if (AItem* Item = InventoryComponent->GetItemInSlot(SlotIndex))
+		{
+			Items.Add(Item);
+		}
+	}
+	return Items;
+}
+
+TMap<EAmmoType, int32> AShooterCharacter::GetAmmoMap() const
+{
+	TMap<EAmmoType, int32> AmmoMap;
+	for (int32 Index = 0; Index < static_cast<int32>(EAmmoType::EAT_MAX); Index++)
+	{
+		const EAmmoType AmmoType{ static_cast<EAmmoType>(Index) };
+		AmmoMap.Add(AmmoType, InventoryComponent->GetAmmoCount(AmmoType));
+	}
+	return AmmoMap;
 }
 
 bool AShooterCharacter::WeaponHasAmmo()
@@ -640,6 +851,8 @@ void AShooterCharacter::PlayFireSound()
 
 void AShooterCharacter::SendBullet()
 {
+	SHOOTER_PROFILE_SCOPE(ShooterCharacter_SendBullet);
+
 	const USkeletalMeshSocket* BarrelSocket = EquippedWeapon->GetItemMesh()->GetSocketByName("BarrelSocket");
 	
 	if(BarrelSocket)
@@ -648,32 +861,116 @@ void AShooterCharacter::SendBullet()
 
 		if(EquippedWeapon->GetMuzzleFlash())
 		{
-			UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), EquippedWeapon->GetMuzzleFlash(), SocketTransform);
+			UEmitterPoolSubsystem::SpawnEmitterAtLocation(this, EquippedWeapon->GetMuzzleFlash(), SocketTransform);
 		}
-		
-		FVector BeamEnd;
-		bool bBeamEnd = GetBeamEndLocation(SocketTransform.GetLocation(), BeamEnd);
 
-		if (bBeamEnd)
+		// Projectile weapons, the round is aimed at the crosshair target and impacts are spawned when it hits
+		UBallisticsSubsystem* Ballistics = GetWorld()->GetSubsystem<UBallisticsSubsystem>();
+		if (Ballistics && EquippedWeapon->IsProjectileWeapon())
 		{
-			// Spawn impact particles after updating beam end point.
-			if (ImpactParticles)
+			FVector CrosshairTraceStart;
+			FVector CrosshairTraceEnd;
+			if (GetCrosshairTraceSegment(CrosshairTraceStart, CrosshairTraceEnd))
 			{
-				UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), ImpactParticles, BeamEnd);
+				// Reuse this frame's crosshair query if there is one, otherwise aim at the far end of the crosshair ray
+				const FHitResult& CrosshairHit{ CrosshairCache.HitResult};
+				const FVector AimTarget{ CrosshairCache.bTraced && CrosshairHit.bBlockingHit ? CrosshairHit.Location : CrosshairTraceEnd};
+				const FVector Direction{ (AimTarget - SocketTransform.GetLocation()).GetSafeNormal()};
+				Ballistics->FireProjectile(this, SocketTransform, Direction * EquippedWeapon->GetMuzzleVelocity(),
+					EquippedWeapon->GetProjectileDrag(), EquippedWeapon->GetProjectileGravityScale());
+				return;
 			}
-			
-			if (BeamParticles)
+		}
+
+		// Batched path, impacts are spawned by the hitscan subsystem once the traces come back
+		UHitscanSubsystem* Hitscan = GetWorld()->GetSubsystem<UHitscanSubsystem>();
+		if (Hitscan && UHitscanSubsystem::IsBatchingEnabled())
+		{
+			FVector CrosshairTraceStart;
+			FVector CrosshairTraceEnd;
+			if (GetCrosshairTraceSegment(CrosshairTraceStart, CrosshairTraceEnd))
 			{
-				UParticleSystemComponent* Beam = UGameplayStatics::SpawnEmitterAtLocation(GetWorld(), BeamParticles, SocketTransform);
-				if (Beam)
+				if (CrosshairCache.bTraced)
 				{
-					Beam->SetVectorParameter(FName("Target"), BeamEnd);
+					// Crosshair was already traced this frame, only the barrel trace is needed
+					const FHitResult& CrosshairHit{ CrosshairCache.HitResult};
+					Hitscan->QueueShotAtTarget(this, SocketTransform, CrosshairHit.bBlockingHit ? CrosshairHit.Location : CrosshairTraceEnd);
 				}
+				else
+				{
+					Hitscan->QueueShot(this, SocketTransform, CrosshairTraceStart, CrosshairTraceEnd);
+				}
+				return;
 			}
 		}
+		
+		FVector BeamEnd;
+		FHitResult WeaponTraceHit;
+		bool bBeamEnd = GetBeamEndLocation(SocketTransform.GetLocation(), BeamEnd, &WeaponTraceHit);
+
+		if (bBeamEnd)
+		{
+			QueueBulletDamage(WeaponTraceHit);
+
+			FHitResult BeamHit;
+			BeamHit.bBlockingHit = true;
+			BeamHit.Location = BeamEnd;
+			BeamHit.ImpactPoint = BeamEnd;
+			ResolveBullet(SocketTransform, BeamHit);
+		}
+	}
+}
+
+void AShooterCharacter::ResolveBullet(const FTransform& SocketTransform, const FHitResult& BeamHit)
+{
+	// Nothing to see on a dedicated server
+	if (GetNetMode() == NM_DedicatedServer) return;
+
+	const FVector BeamEnd{ BeamHit.Location};
+
+	// Spawn impact particles after updating beam end point.
+	if (ImpactParticles)
+	{
+		UEmitterPoolSubsystem::SpawnEmitterAtLocation(this, ImpactParticles, FTransform(BeamEnd));
+	}
+	
+	if (BeamParticles)
+	{
+		UParticleSystemComponent* Beam = UEmitterPoolSubsystem::SpawnEmitterAtLocation(this, BeamParticles, SocketTransform);
+		if (Beam)
+		{
+			Beam->SetVectorParameter(FName("Target"), BeamEnd);
+		}
 	}
 }
 
+void AShooterCharacter::QueueBulletDamage(const FHitResult& Hit)
+{
+	if (!HasAuthority() || EquippedWeapon == nullptr || !Hit.bBlockingHit) return;
+
+	if (UDamageSubsystem* Damage = GetWorld()->GetSubsystem<UDamageSubsystem>())
+	{
+		Damage->QueueHit(this, Hit, EquippedWeapon->GetDamage());
+	}
+}
+
+float AShooterCharacter::GetHitZoneMultiplier(EHitZone Zone) const
+{
+	switch (Zone)
+	{
+	case EHitZone::EHZ_Head: return HeadDamageMultiplier;
+	case EHitZone::EHZ_Limb: return LimbDamageMultiplier;
+	default: return TorsoDamageMultiplier;
+	}
+}
+
+float AShooterCharacter::TakeDamage(float DamageAmount, FDamageEvent const& DamageEvent, AController* EventInstigator, AActor* DamageCauser)
+{
+	const float Damage{ Super::TakeDamage(DamageAmount, DamageEvent, EventInstigator, DamageCauser) };
+	Health = FMath::Clamp(Health - Damage, 0.f, MaxHealth);
+	return Damage;
+}
+
 void AShooterCharacter::PlayGunFireMontage()
 {
 		UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
@@ -710,6 +1007,11 @@ void AShooterCharacter::ReloadWeapon()
 			AnimInstance->Montage_Play(ReloadMontage);
 			AnimInstance->Montage_JumpToSection(EquippedWeapon->GetReloadMontageSection());
 		}
+
+		if (!HasAuthority())
+		{
+			ServerReloadWeapon();
+		}
 	}
 }
 
@@ -727,30 +1029,25 @@ void AShooterCharacter::FinishReloading()
 
 	const auto AmmoType{ EquippedWeapon->GetAmmoType()};
 	
-	// Update the Ammo Map
-	if (AmmoMap.Contains(AmmoType))
-	{
-		// Amount of ammo the Character is carrying of the EquippedWeapon type
-		int32 CarriedAmmo = AmmoMap[AmmoType];
+	// Amount of ammo the Character is carrying of the EquippedWeapon type
+	int32 CarriedAmmo = InventoryComponent->GetAmmoCount(AmmoType);
 
-		// Space left in the Magazine of the Equipped Weapon
-		const int32 MagEmptySpace = EquippedWeapon->GetMagazineCapacity() - EquippedWeapon->GetAmmo();
+	// Space left in the Magazine of the Equipped Weapon
+	const int32 MagEmptySpace = EquippedWeapon->GetMagazineCapacity() - EquippedWeapon->GetAmmo();
 
-		if (MagEmptySpace > CarriedAmmo)
-		{
-			// Reload the magazine with all the ammo we are carrying
-			EquippedWeapon->ReloadAmmo(CarriedAmmo);
-			CarriedAmmo = 0;
-			AmmoMap.Add(AmmoType, CarriedAmmo);
-		}
-		else
-		{
-			// Fill the magazine
-			EquippedWeapon->ReloadAmmo(MagEmptySpace);
-			CarriedAmmo -= MagEmptySpace;
-			AmmoMap.Add(AmmoType, CarriedAmmo);
-		}
+	if (MagEmptySpace > CarriedAmmo)
+	{
+		// Reload the magazine with all the ammo we are carrying
+		EquippedWeapon->ReloadAmmo(CarriedAmmo);
+		CarriedAmmo = 0;
 	}
+	else
+	{
+		// Fill the magazine
+		EquippedWeapon->ReloadAmmo(MagEmptySpace);
+		CarriedAmmo -= MagEmptySpace;
+	}
+	InventoryComponent->SetAmmoCount(AmmoType, CarriedAmmo);
 }
 
 void AShooterCharacter::FinishEquipping()
@@ -766,14 +1063,7 @@ bool AShooterCharacter::CarryingAmmo()
 {
 	if (EquippedWeapon == nullptr) return false;
 
-	auto AmmoType = EquippedWeapon->GetAmmoType();
-
-	if (AmmoMap.Contains(AmmoType))
-	{
-		return AmmoMap[AmmoType] > 0;
-	}
-	
-	return false;
+	return InventoryComponent->GetAmmoCount(EquippedWeapon->GetAmmoType()) > 0;
 }
 
 void AShooterCharacter::GrabClip()
@@ -833,6 +1123,8 @@ void AShooterCharacter::Jump()
 
 void AShooterCharacter::InterpCapsuleHalfHeight(float DeltaTime)
 {
+	SHOOTER_PROFILE_SCOPE(ShooterCharacter_InterpCapsuleHalfHeight);
+
 	float TargetCapsuleHalfHeight { };
 	if (bCrouching)
 	{
@@ -843,7 +1135,7 @@ void AShooterCharacter::InterpCapsuleHalfHeight(float DeltaTime)
 		TargetCapsuleHalfHeight = StandingCapsuleHalfHeight;
 	}
 
-	const float InterpHalfHeight { FMath::FInterpTo(GetCapsuleComponent()->GetScaledCapsuleHalfHeight(), TargetCapsuleHalfHeight, DeltaTime, 20.f)};
+	const float InterpHalfHeight { ShooterCharacterMath::InterpCapsuleHalfHeight(GetCapsuleComponent()->GetScaledCapsuleHalfHeight(), TargetCapsuleHalfHeight, DeltaTime)};
 
 	// Negative value if crouching, positive value if standing
 	const float DeltaCapsuleHalfHeight{InterpHalfHeight - GetCapsuleComponent()->GetScaledCapsuleHalfHeight()};
@@ -872,15 +1164,8 @@ void AShooterCharacter::StopAiming()
 
 void AShooterCharacter::PickupAmmo(AAmmo* Ammo)
 {
-	// Check to see if AmmoMap contains Ammo's AmmoType
-	if (AmmoMap.Find(Ammo->GetAmmoType()))
-	{
-		// Get ammount of Ammo in our AmmoMap for Ammo's type
-		int32 AmmoCount{ AmmoMap[Ammo->GetAmmoType()]};
-		AmmoCount += Ammo->GetItemCount();
-		// Set the amount of Ammo in the Map for this type
-		AmmoMap[Ammo->GetAmmoType()] = AmmoCount;
-	}
+	// Add the Ammo's count to the carried ammo of its type
+	InventoryComponent->AddAmmo(Ammo->GetAmmoType(), Ammo->GetItemCount());
 
 	if (EquippedWeapon->GetAmmoType() == Ammo->GetAmmoType())
 	{
@@ -891,7 +1176,20 @@ void AShooterCharacter::PickupAmmo(AAmmo* Ammo)
 		}
 	}
 
-	Ammo->Destroy();
+	if (!HasAuthority())
+	{
+		// Predicted pickup, the server releases the actor and replicates its state
+		Ammo->SetItemState(EItemState::EIS_Pooled);
+	}
+	// Return the ammo actor to the pool so the next drop can reuse it
+	else if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+	{
+		ItemPool->ReleaseItem(Ammo);
+	}
+	else
+	{
+		Ammo->Destroy();
+	}
 }
 
 void AShooterCharacter::InitializeInterpLocations()
@@ -957,7 +1255,7 @@ void AShooterCharacter::FiveKeyPressed()
 
 void AShooterCharacter::ExchangeInventoryItems(int32 CurrentItemIndex, int32 NewItemIndex)
 {
-	bool bCanExchangeItems = (CurrentItemIndex != NewItemIndex) && (NewItemIndex < Inventory.Num()) && (CombatState == ECombatState::ECS_Unoccupied || CombatState == ECombatState::ECS_Equipping);
+	bool bCanExchangeItems = (CurrentItemIndex != NewItemIndex) && InventoryComponent->GetSlotType(NewItemIndex) == EItemType::EIT_Weapon && (CombatState == ECombatState::ECS_Unoccupied || CombatState == ECombatState::ECS_Equipping);
 	if ( bCanExchangeItems )
 	{
 		if (bAiming)
@@ -966,7 +1264,7 @@ void AShooterCharacter::ExchangeInventoryItems(int32 CurrentItemIndex, int32 New
 		}
 		
 		auto OldEquippedWeapon = EquippedWeapon;
-		auto NewWeapon = Cast<AWeapon>(Inventory[NewItemIndex]);
+		auto NewWeapon = InventoryComponent->GetWeaponInSlot(NewItemIndex);
 		EquipWeapon(NewWeapon);
 
 		OldEquippedWeapon->SetItemState(EItemState::EIS_PickedUp);
@@ -980,48 +1278,49 @@ void AShooterCharacter::ExchangeInventoryItems(int32 CurrentItemIndex, int32 New
 			AnimInstance->Montage_JumpToSection(FName("Equip"));
 		}
 		NewWeapon->PlayEquipSound(true);
+
+		if (!HasAuthority())
+		{
+			ServerExchangeInventoryItems(CurrentItemIndex, NewItemIndex);
+		}
 	}
 }
 
 int32 AShooterCharacter::GetEmptyInventorySlot()
 {
-	for (int32 i = 0; i < Inventory.Num(); i++)
-	{
-		if (Inventory[i] == nullptr)
-		{
-			return i;
-		}
-	}
-	if (Inventory.Num() < INVENTORY_CAPACITY)
-	{
-		return Inventory.Num();
-	}
-	return -1; // Inventory is full
+	return InventoryComponent->GetEmptySlot(); // -1 if Inventory is full
 }
 
 void AShooterCharacter::HighlightInventorySlot()
 {
 	const int32 EmptySlot{ GetEmptyInventorySlot() };
-	HighlightIconDelegate.Broadcast(EmptySlot, true);
+	InventoryComponent->QueueHighlightEvent(EmptySlot, true);
 	HighlightedSlot = EmptySlot;
 }
 
 EPhysicalSurface AShooterCharacter::GetSurfaceType()
 {
-	FHitResult HitResult;
-	const FVector Start{GetActorLocation()};
-	const FVector End{ Start + FVector(0.f,0.f, -400.f)};
-	FCollisionQueryParams QueryParams;
-	QueryParams.bReturnPhysicalMaterial = true;
-
-	GetWorld()->LineTraceSingleByChannel(HitResult, Start, End, ECC_Visibility, QueryParams);
+	return UFootstepSurfaceSubsystem::GetFloorSurface(this);
+}
 
-	return UPhysicalMaterial::DetermineSurfaceType(HitResult.PhysMaterial.Get());
+void AShooterCharacter::OnInventorySlotsChanged(TArrayView<const FInventorySlotEvent> SlotEvents)
+{
+	for (const FInventorySlotEvent& SlotEvent : SlotEvents)
+	{
+		if (SlotEvent.Type == EInventorySlotEventType::EISE_Equip)
+		{
+			EquipItemDelegate.Broadcast(SlotEvent.PreviousSlotIndex, SlotEvent.SlotIndex);
+		}
+		else
+		{
+			HighlightIconDelegate.Broadcast(SlotEvent.SlotIndex, SlotEvent.bHighlight);
+		}
+	}
 }
 
 void AShooterCharacter::UnHighlightInventorySlot()
 {
-	HighlightIconDelegate.Broadcast(HighlightedSlot, false);
+	InventoryComponent->QueueHighlightEvent(HighlightedSlot, false);
 	HighlightedSlot = -1;
 }
 
@@ -1055,34 +1354,79 @@ void AShooterCharacter::IncrementInterpLocationItemCount(int32 Index, int32 Amou
 void AShooterCharacter::StartPickupSoundTimer()
 {
 	bShouldPlayPickupSound = false;
-	GetWorldTimerManager().SetTimer(PickupSoundTimer, this, &AShooterCharacter::ResetPickupSoundTimer, PickupSoundResetTime);
+	CombatClock.Schedule(ECombatClockEvent::ECCE_PickupSound, GetCombatTime(), PickupSoundResetTime);
 }
 
 void AShooterCharacter::StartEquipSoundTimer()
 {
 	bShouldPlayEquipSound = false;
-	GetWorldTimerManager().SetTimer(EquipSoundTimer, this, &AShooterCharacter::ResetEquipSoundTimer, EquipSoundResetTime);
+	CombatClock.Schedule(ECombatClockEvent::ECCE_EquipSound, GetCombatTime(), EquipSoundResetTime);
+}
+
+void AShooterCharacter::OnCombatClockEvent(ECombatClockEvent Event)
+{
+	switch (Event)
+	{
+	case ECombatClockEvent::ECCE_CrosshairShoot:
+		FinishCrosshairBulletFire();
+		break;
+	case ECombatClockEvent::ECCE_AutoFire:
+		AutoFireReset();
+		break;
+	case ECombatClockEvent::ECCE_PickupSound:
+		ResetPickupSoundTimer();
+		break;
+	case ECombatClockEvent::ECCE_EquipSound:
+		ResetEquipSoundTimer();
+		break;
+	default:
+		break;
+	}
+}
+
+double AShooterCharacter::GetCombatTime() const
+{
+	return CombatClock.GetTime(GetWorld()->GetTimeSeconds());
 }
 
 // Called every frame
 void AShooterCharacter::Tick(float DeltaTime)
 {
+	SHOOTER_PROFILE_SCOPE(ShooterCharacter_Tick);
+
 	Super::Tick(DeltaTime);
 
-	// Handle interpolation for aiming
-	SetCameraFOV(DeltaTime);
+	// Fire cadence, crosshair and sound timers
+	CombatClock.Update(GetWorld()->GetTimeSeconds(), [this](ECombatClockEvent Event) { OnCombatClockEvent(Event); });
+
+	// UShooterCharacterBatchSubsystem does the camera, crosshair and capsule updates for every character at once
+	const bool bBatchedUpdate{ UShooterCharacterBatchSubsystem::IsBatchingEnabled() };
 
-	// Change look sensitivity based on aiming
-	SetLookRates();
+	if (!bBatchedUpdate)
+	{
+		// Handle interpolation for aiming
+		SetCameraFOV(DeltaTime);
 
-	// Calculate crosshair spread multiplier
-	CalculateCrosshairSpread(DeltaTime);
+		// Change look sensitivity based on aiming
+		SetLookRates();
 
-	// Check OverlappedItemCount then trace for items
-	TraceForItems();
+		// Calculate crosshair spread multiplier
+		CalculateCrosshairSpread(DeltaTime);
+	}
 
-	//Interpolate the capsule half height based on standing / crouching
-	InterpCapsuleHalfHeight(DeltaTime);
+	// Find items in pickup range, then trace for items if one is under the crosshairs.
+	// Only a local player sees the highlight, AI and remote characters skip both
+	if (Controller && Controller->IsLocalPlayerController())
+	{
+		UpdateNearbyItems();
+		TraceForItems();
+	}
+
+	if (!bBatchedUpdate)
+	{
+		//Interpolate the capsule half height based on standing / crouching
+		InterpCapsuleHalfHeight(DeltaTime);
+	}
 }
 
 // Called to bind functionality to input
@@ -1139,20 +1483,6 @@ float AShooterCharacter::GetCrosshairSpreadMultiplier() const
 	return CrosshairSpreadMultiplier;
 }
 
-void AShooterCharacter::IncrememntOverlappedItemCount(int8 Amount)
-{
-	if (OverlappedItemCount + Amount <= 0)
-	{
-		OverlappedItemCount = 0;
-		bShouldTraceForItems = false;
-	}
-	else
-	{
-		OverlappedItemCount += Amount;
-		bShouldTraceForItems = true;
-	}
-}
-
 //No longer needed; AItem has GetInterpLocation
 /*FVector AShooterCharacter::GetCameraInterpLocation()
 {
@@ -1169,11 +1499,12 @@ void AShooterCharacter::GetPickupItem(AItem* Item)
 	auto Weapon = Cast<AWeapon>(Item);
 	if (Weapon)
 	{
-		if (Inventory.Num() < INVENTORY_CAPACITY)
+		const int32 EmptySlot{ InventoryComponent->AddItem(Weapon) };
+		if (EmptySlot != -1)
 		{
-			Weapon->SetSlotIndex( Inventory.Num() );
-			Inventory.Add(Weapon);
+			Weapon->SetSlotIndex(EmptySlot);
 			Weapon->SetItemState(EItemState::EIS_PickedUp);
+			Weapon->SetOwner(this);
 		}
 		else // Inventory is full, swap with equipped weapon
 		{
@@ -1196,3 +1527,321 @@ FInterpLocation AShooterCharacter::GetInterpLocation(int32 Index)
 	}
 	return FInterpLocation();
 }
+
+void AShooterCharacter::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME(AShooterCharacter, EquippedWeapon);
+	DOREPLIFETIME(AShooterCharacter, Health);
+	// The owning client predicts its own combat state
+	DOREPLIFETIME_CONDITION(AShooterCharacter, CombatState, COND_SkipOwner);
+}
+
+bool AShooterCharacter::MakeShotPacket(FShotPacket& OutPacket)
+{
+	FVector CrosshairTraceStart;
+	FVector CrosshairTraceEnd;
+	if (!GetCrosshairTraceSegment(CrosshairTraceStart, CrosshairTraceEnd)) return false;
+
+	OutPacket.Origin = CrosshairTraceStart;
+	OutPacket.Direction = (CrosshairTraceEnd - CrosshairTraceStart).GetSafeNormal();
+	OutPacket.Seed = NextShotSeed++;
+
+	// Server time, so the server knows how far back to rewind the other characters
+	// Shots fired from the combat clock are stamped with their due time, not the frame they were handled in
+	const double ShotAge{ GetWorld()->GetTimeSeconds() - GetCombatTime() };
+	const AGameStateBase* GameState = GetWorld()->GetGameState();
+	OutPacket.Timestamp = static_cast<float>((GameState ? GameState->GetServerWorldTimeSeconds() : GetWorld()->GetTimeSeconds()) - ShotAge);
+	return true;
+}
+
+bool AShooterCharacter::CanServerFire(const FShotPacket& Packet) const
+{
+	if (EquippedWeapon == nullptr || EquippedWeapon->GetAmmo() <= 0) return false;
+
+	// The server's fire timer runs a little behind the client's, so FireTimerInProgress is fine here,
+	// the fire rate itself is held by the shot tokens
+	if (CombatState != ECombatState::ECS_Unoccupied && CombatState != ECombatState::ECS_FireTimerInProgress) return false;
+
+	const UShotValidationSubsystem* ShotValidation = GetWorld()->GetSubsystem<UShotValidationSubsystem>();
+	return ShotValidation == nullptr || ShotValidation->IsShotPlausible(this, Packet);
+}
+
+bool AShooterCharacter::ConsumeServerShotToken()
+{
+	// A little burst allowance, so shots bunched up by network jitter aren't rejected
+	constexpr float MaxShotTokens{ 2.f };
+
+	// Refilled in server time, the client's timestamps only pick the rewind
+	const float Now{ GetWorld()->GetTimeSeconds() };
+	const float AutoFireRate{ FMath::Max(EquippedWeapon->GetAutoFireRate(), KINDA_SMALL_NUMBER) };
+	ServerShotTokens = FMath::Min(ServerShotTokens + (Now - ServerShotTokensTime) / AutoFireRate, MaxShotTokens);
+	ServerShotTokensTime = Now;
+
+	if (ServerShotTokens < 1.f) return false;
+	ServerShotTokens -= 1.f;
+	return true;
+}
+
+bool AShooterCharacter::ServerFire_Validate(const FShotPacket& Packet)
+{
+	// Only packets no client could have built, a shot that merely doesn't add up is rejected in CanServerFire
+	return !Packet.Origin.ContainsNaN() && !Packet.Direction.ContainsNaN() && FMath::IsFinite(Packet.Timestamp);
+}
+
+void AShooterCharacter::ServerFire_Implementation(const FShotPacket& Packet)
+{
+	UShotValidationSubsystem* ShotValidation = GetWorld()->GetSubsystem<UShotValidationSubsystem>();
+	if (!CanServerFire(Packet) || !ConsumeServerShotToken())
+	{
+		if (ShotValidation)
+		{
+			ShotValidation->RecordShotRejected();
+		}
+		ClientCorrectCombat(EquippedWeapon ? EquippedWeapon->GetAmmo() : 0, CombatState);
+		return;
+	}
+
+	EquippedWeapon->DecrementAmmo();
+	StartFireTimer();
+
+	// Trace from the server's muzzle, with everyone else where the client saw them
+	const USkeletalMeshSocket* BarrelSocket = EquippedWeapon->GetItemMesh()->GetSocketByName("BarrelSocket");
+	const FTransform MuzzleTransform{ BarrelSocket ? BarrelSocket->GetSocketTransform(EquippedWeapon->GetItemMesh()) : FTransform(FVector(Packet.Origin)) };
+	const FVector MuzzleLocation{ MuzzleTransform.GetLocation() };
+
+	// Projectile weapons, the server's own round flies at what the client aimed at and its hit queues the damage
+	UBallisticsSubsystem* Ballistics = GetWorld()->GetSubsystem<UBallisticsSubsystem>();
+	if (Ballistics && EquippedWeapon->IsProjectileWeapon())
+	{
+		const FVector AimTarget{ ShotValidation ? ShotValidation->TraceAimTarget(this, Packet) : FVector(Packet.Origin + Packet.Direction * 50'000.f) };
+		const FVector Direction{ (AimTarget - MuzzleLocation).GetSafeNormal() };
+		Ballistics->FireProjectile(this, MuzzleTransform, Direction * EquippedWeapon->GetMuzzleVelocity(),
+			EquippedWeapon->GetProjectileDrag(), EquippedWeapon->GetProjectileGravityScale());
+
+		// Everyone else fires a cosmetic round at the same target
+		MulticastShotCosmetics(AimTarget, false);
+		return;
+	}
+
+	FHitResult ShotHit;
+	const bool bHit{ ShotValidation && ShotValidation->TraceShot(this, Packet, MuzzleLocation, ShotHit) };
+	if (bHit)
+	{
+		QueueBulletDamage(ShotHit);
+	}
+
+	const FVector_NetQuantize ImpactPoint{ bHit ? ShotHit.ImpactPoint : ShotHit.TraceEnd };
+	MulticastShotCosmetics(ImpactPoint, bHit);
+	if (ShotValidation)
+	{
+		// Impact point plus the hit flag
+		FBitWriter Writer(0, true);
+		bool bSuccess{ true };
+		FVector_NetQuantize(ImpactPoint).NetSerialize(Writer, nullptr, bSuccess);
+		Writer.WriteBit(bHit);
+		ShotValidation->RecordCosmeticsSent(static_cast<int32>(Writer.GetNumBits()));
+	}
+}
+
+void AShooterCharacter::ServerReloadWeapon_Implementation()
+{
+	// Client's fire timer may have run out before ours
+	if (CombatState == ECombatState::ECS_FireTimerInProgress)
+	{
+		CombatClock.Cancel(ECombatClockEvent::ECCE_AutoFire);
+		CombatState = ECombatState::ECS_Unoccupied;
+	}
+
+	ReloadWeapon();
+	if (CombatState != ECombatState::ECS_Reloading)
+	{
+		ClientCorrectCombat(EquippedWeapon ? EquippedWeapon->GetAmmo() : 0, CombatState);
+	}
+}
+
+void AShooterCharacter::ServerExchangeInventoryItems_Implementation(int32 CurrentItemIndex, int32 NewItemIndex)
+{
+	if (EquippedWeapon == nullptr) return;
+
+	if (CombatState == ECombatState::ECS_FireTimerInProgress)
+	{
+		CombatClock.Cancel(ECombatClockEvent::ECCE_AutoFire);
+		CombatState = ECombatState::ECS_Unoccupied;
+	}
+
+	// Our idea of the equipped slot wins over the client's
+	ExchangeInventoryItems(EquippedWeapon->GetSlotIndex(), NewItemIndex);
+	if (CombatState != ECombatState::ECS_Equipping)
+	{
+		ClientCorrectCombat(EquippedWeapon->GetAmmo(), CombatState);
+	}
+}
+
+void AShooterCharacter::ServerSelectItem_Implementation(AItem* Item)
+{
+	if (Item == nullptr || CombatState != ECombatState::ECS_Unoccupied) return;
+	if (Item->GetItemState() != EItemState::EIS_Pickup) return;
+
+	// Only items the server also has in pickup range
+	if (UItemRegistrySubsystem* ItemRegistry = GetWorld()->GetSubsystem<UItemRegistrySubsystem>())
+	{
+		TArray<AItem*> ItemsInRange;
+		ItemRegistry->QueryItemsInPickupRange(GetActorLocation(), ItemsInRange);
+		if (!ItemsInRange.Contains(Item)) return;
+	}
+
+	Item->StartItemCurve(this, true);
+}
+
+void AShooterCharacter::ClientCorrectCombat_Implementation(int32 ServerAmmo, ECombatState ServerCombatState)
+{
+	// Drop the predicted auto fire, it would fire again right after the correction, and the crosshair spread from the rejected shot
+	CombatClock.Cancel(ECombatClockEvent::ECCE_AutoFire);
+	CombatClock.Cancel(ECombatClockEvent::ECCE_CrosshairShoot);
+	FinishCrosshairBulletFire();
+	if (CombatState == ECombatState::ECS_FireTimerInProgress)
+	{
+		CombatState = ECombatState::ECS_Unoccupied;
+	}
+
+	if (EquippedWeapon)
+	{
+		EquippedWeapon->SetAmmo(ServerAmmo);
+	}
+
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	switch (ServerCombatState)
+	{
+	case ECombatState::ECS_Reloading:
+		if (CombatState != ECombatState::ECS_Reloading && EquippedWeapon)
+		{
+			CombatState = ECombatState::ECS_Reloading;
+			if (ReloadMontage && AnimInstance)
+			{
+				AnimInstance->Montage_Play(ReloadMontage);
+				AnimInstance->Montage_JumpToSection(EquippedWeapon->GetReloadMontageSection());
+			}
+		}
+		break;
+	case ECombatState::ECS_Equipping:
+		if (CombatState != ECombatState::ECS_Equipping)
+		{
+			CombatState = ECombatState::ECS_Equipping;
+			if (EquipMontage && AnimInstance)
+			{
+				AnimInstance->Montage_Play(EquipMontage, 1.0f);
+				AnimInstance->Montage_JumpToSection(FName("Equip"));
+			}
+		}
+		break;
+	default:
+		// Server isn't reloading or equipping, cancel our prediction if we are
+		if (CombatState == ECombatState::ECS_Reloading || CombatState == ECombatState::ECS_Equipping)
+		{
+			if (AnimInstance)
+			{
+				AnimInstance->Montage_Stop(0.1f, CombatState == ECombatState::ECS_Reloading ? ReloadMontage : EquipMontage);
+			}
+			CombatState = ECombatState::ECS_Unoccupied;
+		}
+		break;
+	}
+}
+
+void AShooterCharacter::MulticastShotCosmetics_Implementation(FVector_NetQuantize ImpactPoint, bool bHit)
+{
+	// The shooter already played these when firing, and a dedicated server has nothing to show
+	if (IsLocallyControlled() || GetNetMode() == NM_DedicatedServer || EquippedWeapon == nullptr) return;
+
+	if (EquippedWeapon->GetFireSound())
+	{
+		UGameplayStatics::PlaySoundAtLocation(this, EquippedWeapon->GetFireSound(), GetActorLocation());
+	}
+	PlayGunFireMontage();
+
+	const USkeletalMeshSocket* BarrelSocket = EquippedWeapon->GetItemMesh()->GetSocketByName("BarrelSocket");
+	if (BarrelSocket == nullptr) return;
+
+	const FTransform SocketTransform = BarrelSocket->GetSocketTransform(EquippedWeapon->GetItemMesh());
+	if (EquippedWeapon->GetMuzzleFlash())
+	{
+		UEmitterPoolSubsystem::SpawnEmitterAtLocation(this, EquippedWeapon->GetMuzzleFlash(), SocketTransform);
+	}
+
+	// Projectile weapons, ImpactPoint is the aim target. The round is only cosmetic here, damage comes from the server's
+	UBallisticsSubsystem* Ballistics = GetWorld()->GetSubsystem<UBallisticsSubsystem>();
+	if (Ballistics && EquippedWeapon->IsProjectileWeapon())
+	{
+		const FVector Direction{ (FVector(ImpactPoint) - SocketTransform.GetLocation()).GetSafeNormal() };
+		Ballistics->FireProjectile(this, SocketTransform, Direction * EquippedWeapon->GetMuzzleVelocity(),
+			EquippedWeapon->GetProjectileDrag(), EquippedWeapon->GetProjectileGravityScale());
+		return;
+	}
+
+	if (bHit)
+	{
+		FHitResult BeamHit;
+		BeamHit.bBlockingHit = true;
+		BeamHit.Location = ImpactPoint;
+		BeamHit.ImpactPoint = ImpactPoint;
+		ResolveBullet(SocketTransform, BeamHit);
+	}
+	else if (BeamParticles)
+	{
+		// Missed, the beam still goes out to the end of the shot
+		UParticleSystemComponent* Beam = UEmitterPoolSubsystem::SpawnEmitterAtLocation(this, BeamParticles, SocketTransform);
+		if (Beam)
+		{
+			Beam->SetVectorParameter(FName("Target"), ImpactPoint);
+		}
+	}
+}
+
+void AShooterCharacter::OnRep_CombatState(ECombatState PreviousCombatState)
+{
+	// Other players' characters, play the montage the owner started
+	UAnimInstance* AnimInstance = GetMesh()->GetAnimInstance();
+	if (AnimInstance == nullptr || CombatState == PreviousCombatState) return;
+
+	if (CombatState == ECombatState::ECS_Reloading && ReloadMontage && EquippedWeapon)
+	{
+		AnimInstance->Montage_Play(ReloadMontage);
+		AnimInstance->Montage_JumpToSection(EquippedWeapon->GetReloadMontageSection());
+	}
+	else if (CombatState == ECombatState::ECS_Equipping && EquipMontage)
+	{
+		AnimInstance->Montage_Play(EquipMontage, 1.0f);
+		AnimInstance->Montage_JumpToSection(FName("Equip"));
+	}
+}
+
+void AShooterCharacter::OnRep_EquippedWeapon(AWeapon* PreviousWeapon)
+{
+	if (EquippedWeapon == nullptr) return;
+
+	AttachWeaponToHand(EquippedWeapon);
+	EquippedWeapon->SetCharacter(this);
+
+	if (PreviousWeapon == nullptr)
+	{
+		// Default weapon the server spawned in BeginPlay
+		EquippedWeapon->DisableCustomDepth();
+		EquippedWeapon->DisableGlowMaterial();
+		if (IsLocallyControlled())
+		{
+			InventoryComponent->QueueEquipEvent(-1, EquippedWeapon->GetSlotIndex());
+		}
+	}
+}
+
+void AShooterCharacter::AttachWeaponToHand(AWeapon* Weapon)
+{
+	const USkeletalMeshSocket* HandSocket = GetMesh()->GetSocketByName(FName("RightHandSocket"));
+	if (HandSocket)
+	{
+		HandSocket->AttachActor(Weapon, GetMesh());
+	}
+	Weapon->SetItemState(EItemState::EIS_Equipped);
+}
@@ -5,6 +5,9 @@
 #include "CoreMinimal.h"
 #include "GameFramework/Character.h"
 #include "AmmoType.h"
+#include "CombatClock.h"
+#include "HitZone.h"
+#include "ShotPacket.h"
 #include "ShooterCharacter.generated.h"
 
 UENUM(BlueprintType)
@@ -18,6 +21,17 @@ enum class ECombatState: uint8
 	ECS_MAX UMETA(DisplayName = "DefaultMAX")
 };
 
+// Events scheduled on a character's CombatClock
+enum class ECombatClockEvent : uint8
+{
+	ECCE_CrosshairShoot,
+	ECCE_AutoFire,
+	ECCE_PickupSound,
+	ECCE_EquipSound,
+
+	ECCE_MAX
+};
+
 USTRUCT(BlueprintType)
 struct FInterpLocation
 {
@@ -32,6 +46,26 @@ struct FInterpLocation
 	int32 ItemCount;
 };
 
+// Crosshair deprojection and trace result, shared by every crosshair query in a frame
+struct FCrosshairQueryCache
+{
+	// Frame the cache was filled on
+	uint64 FrameNumber{ MAX_uint64 };
+
+	// Camera location and control rotation the cache was filled with
+	FVector CameraLocation{ FVector::ZeroVector };
+	FRotator ControlRotation{ FRotator::ZeroRotator };
+
+	// Deprojected crosshair trace segment
+	bool bHasSegment{ false };
+	FVector TraceStart{ FVector::ZeroVector };
+	FVector TraceEnd{ FVector::ZeroVector };
+
+	// True once the crosshair trace has been run for this segment
+	bool bTraced{ false };
+	FHitResult HitResult;
+};
+
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FEquipItemDelegate, int32, CurrentSlotIndex, int32, NewSlotIndex);
 DECLARE_DYNAMIC_MULTICAST_DELEGATE_TwoParams(FHighlightIconDelegate, int32, SlotIndex, bool, bStartAnimation);
 
@@ -40,6 +74,12 @@ class SHOOTER_API AShooterCharacter : public ACharacter
 {
 	GENERATED_BODY()
 
+	// Drives the input handlers with scripted input
+	friend class UShooterSimulationCommandlet;
+
+	// Gathers and writes back the per-frame crosshair, camera and capsule state
+	friend class UShooterCharacterBatchSubsystem;
+
 public:
 	// Sets default values for this character's properties
 	AShooterCharacter();
@@ -48,6 +88,8 @@ protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Called for forward/backward input
 	void MoveForward( float Value);
 
@@ -79,7 +121,8 @@ protected:
 	// Called when the fire button is pressed.
 	void FireWeapon();
 
-	bool GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation);
+	// OutWeaponTraceHit, if set, receives the barrel trace result
+	bool GetBeamEndLocation(const FVector& MuzzleSocketLocation, FVector& OutBeamLocation, FHitResult* OutWeaponTraceHit = nullptr);
 
 	void AimingButtonPressed();
 
@@ -106,12 +149,25 @@ protected:
 	UFUNCTION()
 	void AutoFireReset();
 
+	// Deprojects the viewport center and returns the crosshair trace segment.
+	// Without a viewport, locally controlled characters aim from their eyes along the control rotation
+	bool GetCrosshairTraceSegment(FVector& OutStart, FVector& OutEnd);
+
+	// True if CrosshairCache was filled this frame from the current camera and control rotation
+	bool IsCrosshairCacheValid() const;
+
 	// Line trace for items under the crosshairs
 	bool TraceUnderCrosshairs(FHitResult& OutHitResult, FVector& OutHitLocation);
 
+	// Gathers items in pickup range from the item registry and decides if TraceForItems needs to trace
+	void UpdateNearbyItems();
+
 	// Trace for items if OverlappedItemCount > 0
 	void TraceForItems();
 
+	// Hands the item under the crosshairs to UItemHighlightSubsystem, nullptr clears it
+	void SetHighlightedItem(class AItem* Item);
+
 	// Spawns a default weapon
 	class AWeapon* SpawnDefaultWeapon();
 
@@ -128,7 +184,7 @@ protected:
 	// Drops currently equipped weapon and equips TraceHitItem
 	void SwapWeapon(AWeapon* WeaponToSwap);
 
-	// Initialize the ammo map with ammo values
+	// Give the inventory the starting ammo for each ammo type
 	void InitializeAmmoMap();
 
 	// Check to make sure our weapon has ammo
@@ -192,9 +248,53 @@ protected:
 
 	void HighlightInventorySlot();
 
+	// Forwards the inventory's batched slot events to EquipItemDelegate / HighlightIconDelegate
+	void OnInventorySlotsChanged(TArrayView<const struct FInventorySlotEvent> SlotEvents);
+
+	// Surface under the character's feet for footstep notifies, see UFootstepSurfaceSubsystem
 	UFUNCTION(BlueprintCallable)
 	EPhysicalSurface GetSurfaceType();
-	
+
+	// Fills a shot packet from the crosshair, returns false if there is no viewport to deproject
+	bool MakeShotPacket(FShotPacket& OutPacket);
+
+	// Server side checks for a client's shot: combat state, ammo and packet plausibility
+	bool CanServerFire(const FShotPacket& Packet) const;
+
+	// Server side fire rate limit, takes one of ServerShotTokens if there is one
+	bool ConsumeServerShotToken();
+
+	// Client fired, the server checks the shot and traces it with the other characters rewound
+	UFUNCTION(Server, Reliable, WithValidation)
+	void ServerFire(const FShotPacket& Packet);
+
+	UFUNCTION(Server, Reliable)
+	void ServerReloadWeapon();
+
+	UFUNCTION(Server, Reliable)
+	void ServerExchangeInventoryItems(int32 CurrentItemIndex, int32 NewItemIndex);
+
+	// Client started picking up Item
+	UFUNCTION(Server, Reliable)
+	void ServerSelectItem(AItem* Item);
+
+	// Server disagreed with the owning client's prediction, snap to the server's ammo and combat state
+	UFUNCTION(Client, Reliable)
+	void ClientCorrectCombat(int32 ServerAmmo, ECombatState ServerCombatState);
+
+	// Fire effects for everyone but the shooter, who already played them
+	UFUNCTION(NetMulticast, Unreliable)
+	void MulticastShotCosmetics(FVector_NetQuantize ImpactPoint, bool bHit);
+
+	UFUNCTION()
+	void OnRep_CombatState(ECombatState PreviousCombatState);
+
+	UFUNCTION()
+	void OnRep_EquippedWeapon(AWeapon* PreviousWeapon);
+
+	// Attaches the weapon to the right hand socket and puts it in the Equipped state
+	void AttachWeaponToHand(AWeapon* Weapon);
+
 public:	
 	// Called every frame
 	virtual void Tick(float DeltaTime) override;
@@ -202,6 +302,11 @@ public:
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* PlayerInputComponent) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Takes the damage UDamageSubsystem applies off Health
+	virtual float TakeDamage(float DamageAmount, struct FDamageEvent const& DamageEvent, class AController* EventInstigator, AActor* DamageCauser) override;
+
 private:
 	// Camera boom positioning the camera behind the character
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Camera, meta = (AllowPrivateAccess = "true"))
@@ -307,29 +412,42 @@ private:
 
 	bool bFiringBullet;
 
-	FTimerHandle CrosshairShootTimer;
-
 	// Left mouse button / Right console trigger pressed
 	bool bFireButtonPressed;
 
 	// True when we can fire, false when waiting for timer
 	bool bShouldFire;
 
-	// Sets a timer between gunshots
-	FTimerHandle AutoFireTimer;
+	// Fire cadence, crosshair and sound timers, evaluated at the start of Tick
+	TCombatClock<ECombatClockEvent, ECombatClockEvent::ECCE_MAX> CombatClock;
+
+	void OnCombatClockEvent(ECombatClockEvent Event);
+
+	// World time, or the due time of the clock event being handled. Use it to schedule and timestamp shots
+	double GetCombatTime() const;
 
 	// True if we should trace every frame for items
 	bool bShouldTraceForItems;
 
-	// Number of overlapped AItems
+	// Number of AItems in pickup range
 	int8 OverlappedItemCount;
 
+	// Items in pickup range this frame, filled by UpdateNearbyItems
+	TArray<AItem*> NearbyItems;
+
+	// Half angle of the cone around the crosshair ray an item must be in before we trace for it
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Items, meta=(AllowPrivateAccess = "True"))
+	float ItemTraceConeHalfAngle;
+
+	// Crosshair query shared by TraceForItems and firing
+	FCrosshairQueryCache CrosshairCache;
+
 	// The AItem we hit last frame
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Items, meta=(AllowPrivateAccess = "True") )
 	class AItem* TraceHitItemLastFrame;
 
 	// Currently equipped weapon
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= Combat, meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_EquippedWeapon, Category= Combat, meta=(AllowPrivateAccess = "True"))
 	AWeapon* EquippedWeapon;
 
 	// Set this in Blueprints for the default weapon class
@@ -348,10 +466,6 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category= Item, meta=(AllowPrivateAccess = "True"))
 	float CameraInterpElevation;
 
-	// Map to keep track of ammo of different ammo types
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= Item, meta=(AllowPrivateAccess = "True"))
-	TMap<EAmmoType, int32> AmmoMap;
-
 	// Starting Amount of 9mm ammo
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category= Item, meta=(AllowPrivateAccess = "True"))
 	int32 Starting9mmAmmo;
@@ -360,10 +474,40 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category= Item, meta=(AllowPrivateAccess = "True"))
 	int32 StartingARAmmo;
 
-	// Combat State, can only fire or reload if Unoccupied
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = Combat, meta=(AllowPrivateAccess = "True"))
+	// Combat State, can only fire or reload if Unoccupied. Predicted by the owning client, replicated to everyone else
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, ReplicatedUsing = OnRep_CombatState, Category = Combat, meta=(AllowPrivateAccess = "True"))
 	ECombatState CombatState;
 
+	// Seed of the next shot packet this client sends
+	uint16 NextShotSeed;
+
+	// Shots the server will accept from this character right now, refilled at the weapon's AutoFireRate
+	float ServerShotTokens;
+
+	// Server time ServerShotTokens was last refilled at
+	float ServerShotTokensTime;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Replicated, Category = Combat, meta=(AllowPrivateAccess = "True"))
+	float Health;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Combat, meta=(AllowPrivateAccess = "True"))
+	float MaxHealth;
+
+	// Damage multipliers per hit zone
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Combat, meta=(AllowPrivateAccess = "True"))
+	float HeadDamageMultiplier;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Combat, meta=(AllowPrivateAccess = "True"))
+	float TorsoDamageMultiplier;
+
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = Combat, meta=(AllowPrivateAccess = "True"))
+	float LimbDamageMultiplier;
+
+	// Bones that start a hit zone, their children are in the same zone unless listed themselves.
+	// Read once per skeletal mesh by UDamageSubsystem
+	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, Category = Combat, meta=(AllowPrivateAccess = "True"))
+	TMap<FName, EHitZone> HitZoneBones;
+
 	// Montage for reload animations
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Combat, meta=(AllowPrivateAccess = "True"))
 	UAnimMontage* ReloadMontage;
@@ -439,9 +583,6 @@ private:
 	UPROPERTY(EditDefaultsOnly, BlueprintReadOnly, meta=(AllowPrivateAccess = "True"))
 	TArray<FInterpLocation> InterpLocations;
 
-	FTimerHandle PickupSoundTimer;
-	FTimerHandle EquipSoundTimer;
-
 	bool bShouldPlayPickupSound;
 	bool bShouldPlayEquipSound;
 
@@ -456,11 +597,9 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category= Items, meta=(AllowPrivateAccess = "True"))
 	float EquipSoundResetTime;
 
-	// Array of AItems for inventory
+	// Inventory slots and carried ammo. Blueprints that read the old Inventory array use GetInventoryItems
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= Inventory, meta=(AllowPrivateAccess = "True"))
-	TArray<AItem*> Inventory;
-
-	const int32 INVENTORY_CAPACITY{6};
+	class UShooterInventoryComponent* InventoryComponent;
 
 	// Delegate for sending slot information to inventory bar when equipping
 	UPROPERTY(BlueprintAssignable, Category= Delegates, meta=(AllowPrivateAccess = "True"))
@@ -487,9 +626,6 @@ public:
 
 	FORCEINLINE int8 GetOverlappedItemCount() const { return OverlappedItemCount; }
 
-	// Adds / Subtracts to / from OverlappedItemCount and updates bShouldTraceForItems
-	void IncrememntOverlappedItemCount(int8 Amount);
-
 	// No longer needed; AItem has GetInterpLocation
 	//FVector GetCameraInterpLocation();
 
@@ -515,4 +651,27 @@ public:
 	void UnHighlightInventorySlot();
 
 	FORCEINLINE AWeapon* GetEquippedWeapon() const { return EquippedWeapon; }
+
+	FORCEINLINE UShooterInventoryComponent* GetInventory() const { return InventoryComponent; }
+
+	// Blueprint access to what the character's Inventory array and AmmoMap used to hold, kept for HUD and widget blueprints
+	UFUNCTION(BlueprintPure, Category = Inventory)
+	TArray<AItem*> GetInventoryItems() const;
+
+	UFUNCTION(BlueprintPure, Category = Item)
+	TMap<EAmmoType, int32> GetAmmoMap() const;
+
+	// Spawns impact and beam particles for a bullet that hit something, nothing on a dedicated server. Called from SendBullet or UHitscanSubsystem
+	void ResolveBullet(const FTransform& SocketTransform, const FHitResult& BeamHit);
+
+	// Queues the equipped weapon's damage for a bullet this character fired on the server. Clients' shots are ignored,
+	// the server queues them from ServerFire
+	void QueueBulletDamage(const FHitResult& Hit);
+
+	FORCEINLINE float GetHealth() const { return Health; }
+	FORCEINLINE float GetMaxHealth() const { return MaxHealth; }
+
+	float GetHitZoneMultiplier(EHitZone Zone) const;
+
+	FORCEINLINE const TMap<FName, EHitZone>& GetHitZoneBones() const { return HitZoneBones; }
 };
@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterCharacterBatchSubsystem.h"
+
+#include "ShooterCharacter.h"
+#include "ShooterProfiling.h"
+#include "Async/ParallelFor.h"
+#include "Camera/CameraComponent.h"
+#include "Components/CapsuleComponent.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<int32> CVarCharacterBatchUpdate(
+	TEXT("Shooter.Character.BatchUpdate"),
+	0,
+	TEXT("1 computes crosshair spread, camera FOV, look rates and capsule height for all characters in one parallel pass.\n")
+	TEXT("0 computes them in each character's Tick."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarCharacterBatchMinSize(
+	TEXT("Shooter.Character.BatchMinSize"),
+	64,
+	TEXT("Minimum number of characters per ParallelFor task of the batched character update."),
+	ECVF_Default);
+
+namespace ShooterCharacterBatch
+{
+	enum EStateFlags : uint8
+	{
+		Falling = 1 << 0,
+		Aiming = 1 << 1,
+		FiringBullet = 1 << 2,
+	};
+}
+
+void UShooterCharacterBatchSubsystem::Deinitialize()
+{
+	Characters.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShooterCharacterBatchSubsystem::Tick(float DeltaTime)
+{
+	if (!IsBatchingEnabled() || Characters.Num() == 0) return;
+
+	SHOOTER_PROFILE_SCOPE(CharacterBatch_Update);
+
+	Gather(DeltaTime);
+	Compute();
+	WriteBack();
+}
+
+TStatId UShooterCharacterBatchSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShooterCharacterBatchSubsystem, STATGROUP_Tickables);
+}
+
+void UShooterCharacterBatchSubsystem::RegisterCharacter(AShooterCharacter* Character)
+{
+	if (Character)
+	{
+		Characters.AddUnique(Character);
+	}
+}
+
+void UShooterCharacterBatchSubsystem::UnregisterCharacter(AShooterCharacter* Character)
+{
+	Characters.RemoveSingleSwap(Character, false);
+}
+
+bool UShooterCharacterBatchSubsystem::IsBatchingEnabled()
+{
+	return CVarCharacterBatchUpdate.GetValueOnGameThread() != 0;
+}
+
+bool UShooterCharacterBatchSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+void UShooterCharacterBatchSubsystem::Gather(float DeltaTime)
+{
+	SHOOTER_PROFILE_SCOPE(CharacterBatch_Gather);
+
+	const int32 Num{ Characters.Num() };
+	DeltaTimes.SetNumUninitialized(Num, false);
+	GroundSpeeds.SetNumUninitialized(Num, false);
+	StateFlags.SetNumUninitialized(Num, false);
+	TargetFOVs.SetNumUninitialized(Num, false);
+	ZoomInterpSpeeds.SetNumUninitialized(Num, false);
+	HalfHeights.SetNumUninitialized(Num, false);
+	TargetHalfHeights.SetNumUninitialized(Num, false);
+	InAirFactors.SetNumUninitialized(Num, false);
+	AimFactors.SetNumUninitialized(Num, false);
+	ShootingFactors.SetNumUninitialized(Num, false);
+	CameraFOVs.SetNumUninitialized(Num, false);
+	VelocityFactors.SetNumUninitialized(Num, false);
+	SpreadMultipliers.SetNumUninitialized(Num, false);
+	NewHalfHeights.SetNumUninitialized(Num, false);
+
+	for (int32 i = 0; i < Num; i++)
+	{
+		const AShooterCharacter* Character = Characters[i];
+
+		// Same delta the character's own Tick would have seen
+		DeltaTimes[i] = DeltaTime * Character->CustomTimeDilation;
+
+		FVector Velocity{ Character->GetVelocity()};
+		Velocity.Z = 0;
+		GroundSpeeds[i] = Velocity.Size();
+
+		uint8 Flags{ 0 };
+		if (Character->GetCharacterMovement()->IsFalling()) Flags |= ShooterCharacterBatch::Falling;
+		if (Character->bAiming) Flags |= ShooterCharacterBatch::Aiming;
+		if (Character->bFiringBullet) Flags |= ShooterCharacterBatch::FiringBullet;
+		StateFlags[i] = Flags;
+
+		TargetFOVs[i] = Character->bAiming ? Character->CameraZoomedFOV : Character->CameraDefaultFOV;
+		ZoomInterpSpeeds[i] = Character->ZoomInterpSpeed;
+		CameraFOVs[i] = Character->CameraCurrentFOV;
+
+		HalfHeights[i] = Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight();
+		TargetHalfHeights[i] = Character->bCrouching ? Character->CrouchingCapsuleHalfHeight : Character->StandingCapsuleHalfHeight;
+
+		InAirFactors[i] = Character->CrosshairInAirFactor;
+		AimFactors[i] = Character->CrosshairAimFactor;
+		ShootingFactors[i] = Character->CrosshairShootingFactor;
+	}
+}
+
+void UShooterCharacterBatchSubsystem::Compute()
+{
+	SHOOTER_PROFILE_SCOPE(CharacterBatch_Compute);
+
+	ParallelFor(TEXT("ShooterCharacterBatch"), Characters.Num(), FMath::Max(CVarCharacterBatchMinSize.GetValueOnGameThread(), 1), [this](int32 i)
+	{
+		const float DeltaTime{ DeltaTimes[i] };
+		const uint8 Flags{ StateFlags[i] };
+
+		VelocityFactors[i] = ShooterCharacterMath::CrosshairVelocityFactor(GroundSpeeds[i]);
+		InAirFactors[i] = ShooterCharacterMath::InterpCrosshairInAirFactor(InAirFactors[i], (Flags & ShooterCharacterBatch::Falling) != 0, DeltaTime);
+		AimFactors[i] = ShooterCharacterMath::InterpCrosshairAimFactor(AimFactors[i], (Flags & ShooterCharacterBatch::Aiming) != 0, DeltaTime);
+		ShootingFactors[i] = ShooterCharacterMath::InterpCrosshairShootingFactor(ShootingFactors[i], (Flags & ShooterCharacterBatch::FiringBullet) != 0, DeltaTime);
+		SpreadMultipliers[i] = ShooterCharacterMath::CrosshairSpreadMultiplier(VelocityFactors[i], InAirFactors[i], AimFactors[i], ShootingFactors[i]);
+
+		CameraFOVs[i] = ShooterCharacterMath::InterpCameraFOV(CameraFOVs[i], TargetFOVs[i], DeltaTime, ZoomInterpSpeeds[i]);
+		NewHalfHeights[i] = ShooterCharacterMath::InterpCapsuleHalfHeight(HalfHeights[i], TargetHalfHeights[i], DeltaTime);
+	});
+}
+
+void UShooterCharacterBatchSubsystem::WriteBack()
+{
+	SHOOTER_PROFILE_SCOPE(CharacterBatch_WriteBack);
+
+	for (int32 i = 0; i < Characters.Num(); i++)
+	{
+		AShooterCharacter* Character = Characters[i];
+
+		Character->CrosshairVelocityFactor = VelocityFactors[i];
+		Character->CrosshairInAirFactor = InAirFactors[i];
+		Character->CrosshairAimFactor = AimFactors[i];
+		Character->CrosshairShootingFactor = ShootingFactors[i];
+		Character->CrosshairSpreadMultiplier = SpreadMultipliers[i];
+
+		Character->CameraCurrentFOV = CameraFOVs[i];
+		Character->GetFollowCamera()->SetFieldOfView(CameraFOVs[i]);
+
+		// A select on bAiming, cheaper to do here than to gather
+		Character->BaseTurnRate = Character->bAiming ? Character->AimingTurnRate : Character->HipTurnRate;
+		Character->BaseLookUpRate = Character->bAiming ? Character->AimingLookUpRate : Character->HipLookUpRate;
+
+		// Moving the capsule and mesh dirties their transforms, skip it once the height has settled
+		const float DeltaCapsuleHalfHeight{ NewHalfHeights[i] - HalfHeights[i] };
+		if (DeltaCapsuleHalfHeight != 0.f)
+		{
+			Character->GetMesh()->AddLocalOffset(FVector(0.f, 0.f, -DeltaCapsuleHalfHeight));
+			Character->GetCapsuleComponent()->SetCapsuleHalfHeight(NewHalfHeights[i]);
+		}
+	}
+}
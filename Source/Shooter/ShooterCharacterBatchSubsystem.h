@@ -0,0 +1,107 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShooterCharacterBatchSubsystem.generated.h"
+
+class AShooterCharacter;
+
+// Per-character math shared by AShooterCharacter::Tick and the batched update, so both paths give the same results
+namespace ShooterCharacterMath
+{
+	FORCEINLINE float CrosshairVelocityFactor(float GroundSpeed)
+	{
+		return FMath::GetMappedRangeValueClamped(FVector2D(0.f, 600.f), FVector2D(0.f, 1.f), GroundSpeed);
+	}
+
+	// Spreads slowly while in air, shrinks rapidly on the ground
+	FORCEINLINE float InterpCrosshairInAirFactor(float Current, bool bFalling, float DeltaTime)
+	{
+		return bFalling ? FMath::FInterpTo(Current, 2.25f, DeltaTime, 2.25f) : FMath::FInterpTo(Current, 0.f, DeltaTime, 30.f);
+	}
+
+	// Shrinks a small amount very quickly while aiming
+	FORCEINLINE float InterpCrosshairAimFactor(float Current, bool bAiming, float DeltaTime)
+	{
+		return bAiming ? FMath::FInterpTo(Current, 0.6f, DeltaTime, 30.f) : FMath::FInterpTo(0.f, Current, DeltaTime, 30.f);
+	}
+
+	// Spreads for ShootTimeDuration after firing
+	FORCEINLINE float InterpCrosshairShootingFactor(float Current, bool bFiringBullet, float DeltaTime)
+	{
+		return FMath::FInterpTo(Current, bFiringBullet ? 0.3f : 0.f, DeltaTime, 60.f);
+	}
+
+	FORCEINLINE float CrosshairSpreadMultiplier(float VelocityFactor, float InAirFactor, float AimFactor, float ShootingFactor)
+	{
+		return 0.5f + VelocityFactor + InAirFactor - AimFactor + ShootingFactor;
+	}
+
+	FORCEINLINE float InterpCameraFOV(float Current, float Target, float DeltaTime, float InterpSpeed)
+	{
+		return FMath::FInterpTo(Current, Target, DeltaTime, InterpSpeed);
+	}
+
+	FORCEINLINE float InterpCapsuleHalfHeight(float Current, float Target, float DeltaTime)
+	{
+		return FMath::FInterpTo(Current, Target, DeltaTime, 20.f);
+	}
+}
+
+/**
+ * Data-oriented replacement for the crosshair spread, camera FOV, look rate and capsule
+ * updates in AShooterCharacter::Tick. With Shooter.Character.BatchUpdate set, the inputs of every
+ * registered character are gathered into one array per field, computed with ParallelFor and
+ * written back in one game thread pass, after the characters have ticked.
+ */
+UCLASS()
+class SHOOTER_API UShooterCharacterBatchSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Called from AShooterCharacter::BeginPlay / EndPlay
+	void RegisterCharacter(AShooterCharacter* Character);
+	void UnregisterCharacter(AShooterCharacter* Character);
+
+	// True when characters leave these updates to the batch instead of doing them in Tick
+	static bool IsBatchingEnabled();
+
+	FORCEINLINE int32 GetNumCharacters() const { return Characters.Num(); }
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	void Gather(float DeltaTime);
+	void Compute();
+	void WriteBack();
+
+	TArray<AShooterCharacter*> Characters;
+
+	// Inputs, one entry per character
+	TArray<float> DeltaTimes;
+	TArray<float> GroundSpeeds;
+	TArray<uint8> StateFlags;
+	TArray<float> TargetFOVs;
+	TArray<float> ZoomInterpSpeeds;
+	TArray<float> HalfHeights;
+	TArray<float> TargetHalfHeights;
+
+	// Updated in place
+	TArray<float> InAirFactors;
+	TArray<float> AimFactors;
+	TArray<float> ShootingFactors;
+	TArray<float> CameraFOVs;
+
+	// Outputs
+	TArray<float> VelocityFactors;
+	TArray<float> SpreadMultipliers;
+	TArray<float> NewHalfHeights;
+};
@@ -0,0 +1,106 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterDataTableSubsystem.h"
+
+#include "Weapon.h"
+#include "Engine/Engine.h"
+
+// Path to the Item Rarity data table
+static const TCHAR* RarityTablePath{ TEXT("/Script/Engine.DataTable'/Game/_Game/DataTable/ItemRarityDataTable.ItemRarityDataTable'")};
+
+// Path to the Weapon data table
+static const TCHAR* WeaponTablePath{ TEXT("/Script/Engine.DataTable'/Game/_Game/DataTable/WeaponDataTable.WeaponDataTable'")};
+
+void UShooterDataTableSubsystem::Deinitialize()
+{
+#if WITH_EDITOR
+	if (RarityTable)
+	{
+		RarityTable->OnDataTableChanged().RemoveAll(this);
+	}
+	if (WeaponTable)
+	{
+		WeaponTable->OnDataTableChanged().RemoveAll(this);
+	}
+#endif
+
+	RarityTable = nullptr;
+	WeaponTable = nullptr;
+	bTablesLoaded = false;
+
+	Super::Deinitialize();
+}
+
+UShooterDataTableSubsystem* UShooterDataTableSubsystem::Get()
+{
+	return GEngine ? GEngine->GetEngineSubsystem<UShooterDataTableSubsystem>() : nullptr;
+}
+
+const FItemRarityTable* UShooterDataTableSubsystem::GetRarityRow(EItemRarity Rarity)
+{
+	LoadTables();
+
+	return RarityRows.FindRef(Rarity, nullptr);
+}
+
+const FWeaponDataTable* UShooterDataTableSubsystem::GetWeaponRow(EWeaponType WeaponType)
+{
+	LoadTables();
+
+	return WeaponRows.FindRef(WeaponType, nullptr);
+}
+
+void UShooterDataTableSubsystem::LoadTables()
+{
+	if (bTablesLoaded) return;
+	bTablesLoaded = true;
+
+	RarityTable = Cast<UDataTable>(StaticLoadObject(UDataTable::StaticClass(), nullptr, RarityTablePath));
+	WeaponTable = Cast<UDataTable>(StaticLoadObject(UDataTable::StaticClass(), nullptr, WeaponTablePath));
+
+#if WITH_EDITOR
+	// Rows are reallocated when the table is edited, so resolve them again
+	if (RarityTable)
+	{
+		RarityTable->OnDataTableChanged().AddUObject(this, &UShooterDataTableSubsystem::CacheRarityRows);
+	}
+	if (WeaponTable)
+	{
+		WeaponTable->OnDataTableChanged().AddUObject(this, &UShooterDataTableSubsystem::CacheWeaponRows);
+	}
+#endif
+
+	CacheRarityRows();
+	CacheWeaponRows();
+}
+
+void UShooterDataTableSubsystem::CacheRarityRows()
+{
+	RarityRows.Fill(nullptr);
+	if (RarityTable == nullptr) return;
+
+	auto CacheRow = [this](EItemRarity Rarity, const TCHAR* RowName)
+	{
+		RarityRows[Rarity] = RarityTable->FindRow<FItemRarityTable>(FName(RowName), TEXT(""));
+	};
+	CacheRow(EItemRarity::EIR_Damaged, TEXT("Damaged"));
+	CacheRow(EItemRarity::EIR_Common, TEXT("Common"));
+	CacheRow(EItemRarity::EIR_Uncommon, TEXT("Uncommon"));
+	CacheRow(EItemRarity::EIR_Rare, TEXT("Rare"));
+	CacheRow(EItemRarity::EIR_Legendary, TEXT("Legendary"));
+}
+
+void UShooterDataTableSubsystem::CacheWeaponRows()
+{
+	WeaponRows.Fill(nullptr);
+	if (WeaponTable == nullptr) return;
+
+	auto CacheRow = [this](EWeaponType WeaponType, const TCHAR* RowName)
+	{
+		WeaponRows[WeaponType] = WeaponTable->FindRow<FWeaponDataTable>(FName(RowName), TEXT(""));
+	};
+	CacheRow(EWeaponType::EWT_SubmachineGun, TEXT("SubmachineGun"));
+	CacheRow(EWeaponType::EWT_AssaultRifle, TEXT("AssaultRifle"));
+	CacheRow(EWeaponType::EWT_Pistol, TEXT("Pistol"));
+}
@@ -0,0 +1,55 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/EngineSubsystem.h"
+#include "EnumIndexedArray.h"
+#include "Item.h"
+#include "WeaponType.h"
+#include "ShooterDataTableSubsystem.generated.h"
+
+/**
+ * Process-wide cache of the item rarity and weapon data table rows, indexed by enum value.
+ * The tables are loaded and their rows resolved on the first Get*Row call, not when the engine
+ * starts, since engine subsystems can come up before the game content is mounted.
+ * AItem / AWeapon::OnConstruction read rows from here instead of loading the table and hashing
+ * a row name every time.
+ */
+UCLASS()
+class SHOOTER_API UShooterDataTableSubsystem : public UEngineSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+
+	// Returns the engine's instance of this subsystem
+	static UShooterDataTableSubsystem* Get();
+
+	// Row for the given rarity, or nullptr if it isn't in the table
+	const FItemRarityTable* GetRarityRow(EItemRarity Rarity);
+
+	// Row for the given weapon type, or nullptr if it isn't in the table
+	const struct FWeaponDataTable* GetWeaponRow(EWeaponType WeaponType);
+
+private:
+	// Loads both tables and resolves every row on first use
+	void LoadTables();
+
+	// Looks up each row once and stores it at its enum index
+	void CacheRarityRows();
+	void CacheWeaponRows();
+
+	UPROPERTY()
+	UDataTable* RarityTable;
+
+	UPROPERTY()
+	UDataTable* WeaponTable;
+
+	TEnumIndexedArray<EItemRarity, const FItemRarityTable*, EItemRarity::EIR_MAX> RarityRows{ nullptr };
+
+	TEnumIndexedArray<EWeaponType, const FWeaponDataTable*, EWeaponType::EWT_MAX> WeaponRows{ nullptr };
+
+	bool bTablesLoaded{ false };
+};
@@ -2,4 +2,18 @@
 
 
 #include "ShooterGameModeBase.h"
+#include "Item.h"
+#include "ItemPoolSubsystem.h"
 
+void AShooterGameModeBase::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (UItemPoolSubsystem* ItemPool = GetWorld()->GetSubsystem<UItemPoolSubsystem>())
+	{
+		for (const TPair<TSubclassOf<AItem>, int32>& Prewarm : ItemPoolPrewarmCounts)
+		{
+			ItemPool->Prewarm(Prewarm.Key, Prewarm.Value);
+		}
+	}
+}
@@ -13,5 +13,12 @@ UCLASS()
 class SHOOTER_API AShooterGameModeBase : public AGameModeBase
 {
 	GENERATED_BODY()
-	
+
+protected:
+	virtual void BeginPlay() override;
+
+private:
+	/** Number of dormant actors to spawn into the item pool for each class when the match starts */
+	UPROPERTY(EditDefaultsOnly, Category = "Item Pool", meta = (AllowPrivateAccess = "true"))
+	TMap<TSubclassOf<class AItem>, int32> ItemPoolPrewarmCounts;
 };
@@ -0,0 +1,196 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterInventoryComponent.h"
+
+#include "Ammo.h"
+#include "Weapon.h"
+#include "Net/UnrealNetwork.h"
+
+static_assert(UShooterInventoryComponent::Capacity <= 8, "FreeSlotMask only has room for 8 slots");
+
+UShooterInventoryComponent::UShooterInventoryComponent() :
+	FreeSlotMask((1 << Capacity) - 1)
+{
+	// Only ticks while there are slot events to send
+	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+	PrimaryComponentTick.TickGroup = TG_PostUpdateWork;
+
+	// Only the owning client needs its inventory, see GetLifetimeReplicatedProps
+	SetIsReplicatedByDefault(true);
+
+	for (int32 i = 0; i < Capacity; i++)
+	{
+		Slots[i] = nullptr;
+		SlotTypes[i] = EItemType::EIT_MAX;
+	}
+}
+
+void UShooterInventoryComponent::TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction)
+{
+	Super::TickComponent(DeltaTime, TickType, ThisTickFunction);
+
+	BroadcastSlotEvents();
+	if (PendingSlotEvents.Num() == 0)
+	{
+		SetComponentTickEnabled(false);
+	}
+}
+
+void UShooterInventoryComponent::Serialize(FArchive& Ar)
+{
+	Super::Serialize(Ar);
+
+	// Only save games, assets are never saved with carried ammo
+	if (Ar.IsSaveGame())
+	{
+		Ar << AmmoCounts.Counts;
+	}
+}
+
+void UShooterInventoryComponent::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	DOREPLIFETIME_CONDITION(UShooterInventoryComponent, Slots, COND_OwnerOnly);
+	DOREPLIFETIME_CONDITION(UShooterInventoryComponent, AmmoCounts, COND_OwnerOnly);
+}
+
+int32 UShooterInventoryComponent::AddItem(AItem* Item)
+{
+	const int32 SlotIndex{ GetEmptySlot() };
+	if (SlotIndex != -1)
+	{
+		SetSlot(SlotIndex, Item);
+	}
+	return SlotIndex;
+}
+
+void UShooterInventoryComponent::SetSlot(int32 SlotIndex, AItem* Item)
+{
+	if (!IsValidSlot(SlotIndex)) return;
+
+	Slots[SlotIndex] = Item;
+	if (Item)
+	{
+		FreeSlotMask &= ~(1 << SlotIndex);
+		SlotTypes[SlotIndex] = Item->IsA<AWeapon>() ? EItemType::EIT_Weapon
+			: Item->IsA<AAmmo>() ? EItemType::EIT_Ammo
+			: EItemType::EIT_MAX;
+	}
+	else
+	{
+		FreeSlotMask |= 1 << SlotIndex;
+		SlotTypes[SlotIndex] = EItemType::EIT_MAX;
+	}
+}
+
+void UShooterInventoryComponent::OnRep_Slots()
+{
+	// SetSlot works out the mask bit and type tag for each slot
+	for (int32 i = 0; i < Capacity; i++)
+	{
+		SetSlot(i, Slots[i]);
+	}
+}
+
+AItem* UShooterInventoryComponent::GetItemInSlot(int32 SlotIndex) const
+{
+	return IsValidSlot(SlotIndex) ? Slots[SlotIndex] : nullptr;
+}
+
+AWeapon* UShooterInventoryComponent::GetWeaponInSlot(int32 SlotIndex) const
+{
+	if (GetSlotType(SlotIndex) != EItemType::EIT_Weapon) return nullptr;
+
+	// The slot type was set from IsA<AWeapon> when the item was added
+	return static_cast<AWeapon*>(Slots[SlotIndex]);
+}
+
+EItemType UShooterInventoryComponent::GetSlotType(int32 SlotIndex) const
+{
+	return IsValidSlot(SlotIndex) ? SlotTypes[SlotIndex] : EItemType::EIT_MAX;
+}
+
+int32 UShooterInventoryComponent::GetNumItems() const
+{
+	return Capacity - FMath::CountBits(FreeSlotMask);
+}
+
+int32 UShooterInventoryComponent::GetAmmoCount(EAmmoType AmmoType) const
+{
+	return AmmoCounts.Counts.FindRef(AmmoType);
+}
+
+void UShooterInventoryComponent::SetAmmoCount(EAmmoType AmmoType, int32 Count)
+{
+	if (int32* AmmoCount = AmmoCounts.Counts.Find(AmmoType))
+	{
+		*AmmoCount = Count;
+	}
+}
+
+void UShooterInventoryComponent::AddAmmo(EAmmoType AmmoType, int32 Count)
+{
+	if (int32* AmmoCount = AmmoCounts.Counts.Find(AmmoType))
+	{
+		*AmmoCount += Count;
+	}
+}
+
+void UShooterInventoryComponent::QueueEquipEvent(int32 PreviousSlotIndex, int32 SlotIndex)
+{
+	// Equipping A -> B then B -> C in one frame is the same as A -> C
+	for (int32 i = 0; i < PendingSlotEvents.Num(); i++)
+	{
+		FInventorySlotEvent& Pending = PendingSlotEvents[i];
+		if (Pending.Type == EInventorySlotEventType::EISE_Equip && Pending.SlotIndex == PreviousSlotIndex)
+		{
+			Pending.SlotIndex = SlotIndex;
+			if (Pending.PreviousSlotIndex == SlotIndex)
+			{
+				// Ended up back where it started
+				PendingSlotEvents.RemoveAt(i);
+			}
+			return;
+		}
+	}
+
+	FInventorySlotEvent& Event = PendingSlotEvents.AddDefaulted_GetRef();
+	Event.Type = EInventorySlotEventType::EISE_Equip;
+	Event.PreviousSlotIndex = PreviousSlotIndex;
+	Event.SlotIndex = SlotIndex;
+	SetComponentTickEnabled(true);
+}
+
+void UShooterInventoryComponent::QueueHighlightEvent(int32 SlotIndex, bool bHighlight)
+{
+	// Only the last highlight change of a slot matters
+	for (FInventorySlotEvent& Pending : PendingSlotEvents)
+	{
+		if (Pending.Type == EInventorySlotEventType::EISE_Highlight && Pending.SlotIndex == SlotIndex)
+		{
+			Pending.bHighlight = bHighlight;
+			return;
+		}
+	}
+
+	FInventorySlotEvent& Event = PendingSlotEvents.AddDefaulted_GetRef();
+	Event.Type = EInventorySlotEventType::EISE_Highlight;
+	Event.SlotIndex = SlotIndex;
+	Event.bHighlight = bHighlight;
+	SetComponentTickEnabled(true);
+}
+
+void UShooterInventoryComponent::BroadcastSlotEvents()
+{
+	if (PendingSlotEvents.Num() == 0) return;
+
+	// Listeners may queue more events, those go out next frame
+	Swap(PendingSlotEvents, BroadcastingSlotEvents);
+
+	OnSlotsChanged.Broadcast(BroadcastingSlotEvents);
+	SlotsChangedDelegate.Broadcast(BroadcastingSlotEvents);
+	BroadcastingSlotEvents.Reset();
+}
@@ -0,0 +1,185 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Components/ActorComponent.h"
+#include "AmmoType.h"
+#include "EnumIndexedArray.h"
+#include "Item.h"
+#include "ShooterInventoryComponent.generated.h"
+
+UENUM(BlueprintType)
+enum class EInventorySlotEventType : uint8
+{
+	EISE_Equip UMETA(DisplayName = "Equip"),
+	EISE_Highlight UMETA(DisplayName = "Highlight"),
+
+	EISE_MAX UMETA(DisplayName = "DefaultMAX"),
+};
+
+// One change to the inventory bar, what EquipItemDelegate / HighlightIconDelegate used to carry
+USTRUCT(BlueprintType)
+struct FInventorySlotEvent
+{
+	GENERATED_BODY()
+
+	UPROPERTY(BlueprintReadOnly)
+	EInventorySlotEventType Type{ EInventorySlotEventType::EISE_Equip };
+
+	// Equip: slot equipped before, -1 if nothing was equipped
+	UPROPERTY(BlueprintReadOnly)
+	int32 PreviousSlotIndex{ -1 };
+
+	// Equip: newly equipped slot. Highlight: highlighted slot
+	UPROPERTY(BlueprintReadOnly)
+	int32 SlotIndex{ -1 };
+
+	// Highlight: true to start the icon animation, false to stop it
+	UPROPERTY(BlueprintReadOnly)
+	bool bHighlight{ false };
+};
+
+// Carried ammo per EAmmoType, replicated as one packed array
+USTRUCT()
+struct FInventoryAmmoCounts
+{
+	GENERATED_BODY()
+
+	TEnumIndexedArray<EAmmoType, int32, EAmmoType::EAT_MAX> Counts{ 0 };
+
+	// Both ends have the same ammo types, so only the counts are sent, 7 bits per byte
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess)
+	{
+		for (int32& Count : Counts)
+		{
+			uint32 PackedCount{ static_cast<uint32>(FMath::Max(Count, 0)) };
+			Ar.SerializeIntPacked(PackedCount);
+			if (Ar.IsLoading())
+			{
+				Count = static_cast<int32>(PackedCount);
+			}
+		}
+		bOutSuccess = !Ar.IsError();
+		return true;
+	}
+
+	bool Identical(const FInventoryAmmoCounts* Other, uint32 PortFlags) const
+	{
+		return Counts == Other->Counts;
+	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FInventoryAmmoCounts> : public TStructOpsTypeTraitsBase2<FInventoryAmmoCounts>
+{
+	enum
+	{
+		WithNetSerializer = true,
+		WithIdentical = true,
+	};
+};
+
+DECLARE_DYNAMIC_MULTICAST_DELEGATE_OneParam(FInventorySlotsChangedDelegate, const TArray<FInventorySlotEvent>&, SlotEvents);
+DECLARE_MULTICAST_DELEGATE_OneParam(FOnInventorySlotsChanged, TArrayView<const FInventorySlotEvent>);
+
+/**
+ * Fixed size inventory for AShooterCharacter.
+ * Slots live inline with a bitmask of the free ones, and each slot remembers whether it holds
+ * a weapon or ammo so callers don't have to Cast. Slot events raised during a frame are
+ * coalesced and broadcast once at the end of the frame. Also holds the carried ammo per EAmmoType.
+ */
+UCLASS(ClassGroup=(Shooter), meta=(BlueprintSpawnableComponent))
+class SHOOTER_API UShooterInventoryComponent : public UActorComponent
+{
+	GENERATED_BODY()
+
+public:
+	UShooterInventoryComponent();
+
+	virtual void TickComponent(float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction) override;
+
+	// Carried ammo goes into save games
+	virtual void Serialize(FArchive& Ar) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	static constexpr int32 Capacity{ 6 };
+
+	// Index of the lowest free slot, or -1 if the inventory is full
+	FORCEINLINE int32 GetEmptySlot() const
+	{
+		return FreeSlotMask ? static_cast<int32>(FMath::CountTrailingZeros(static_cast<uint32>(FreeSlotMask))) : -1;
+	}
+
+	FORCEINLINE bool IsFull() const { return FreeSlotMask == 0; }
+
+	FORCEINLINE bool IsSlotOccupied(int32 SlotIndex) const
+	{
+		return IsValidSlot(SlotIndex) && (FreeSlotMask & (1 << SlotIndex)) == 0;
+	}
+
+	// Puts the item in the lowest free slot and returns the slot, or -1 if the inventory is full
+	int32 AddItem(AItem* Item);
+
+	// Replaces whatever is in the slot. Passing nullptr frees the slot
+	void SetSlot(int32 SlotIndex, AItem* Item);
+
+	UFUNCTION(BlueprintPure, Category = Inventory)
+	AItem* GetItemInSlot(int32 SlotIndex) const;
+
+	// Weapon in the slot, or nullptr if the slot is empty or holds something else
+	class AWeapon* GetWeaponInSlot(int32 SlotIndex) const;
+
+	// EIT_MAX for empty slots
+	UFUNCTION(BlueprintPure, Category = Inventory)
+	EItemType GetSlotType(int32 SlotIndex) const;
+
+	UFUNCTION(BlueprintPure, Category = Inventory)
+	int32 GetNumItems() const;
+
+	UFUNCTION(BlueprintPure, Category = Inventory)
+	int32 GetAmmoCount(EAmmoType AmmoType) const;
+
+	void SetAmmoCount(EAmmoType AmmoType, int32 Count);
+	void AddAmmo(EAmmoType AmmoType, int32 Count);
+
+	// Queue slot events, broadcast together at the end of the frame
+	void QueueEquipEvent(int32 PreviousSlotIndex, int32 SlotIndex);
+	void QueueHighlightEvent(int32 SlotIndex, bool bHighlight);
+
+	// Every slot event raised this frame, in order
+	UPROPERTY(BlueprintAssignable, Category = Delegates)
+	FInventorySlotsChangedDelegate SlotsChangedDelegate;
+
+	// Native version of SlotsChangedDelegate
+	FOnInventorySlotsChanged OnSlotsChanged;
+
+private:
+	FORCEINLINE static bool IsValidSlot(int32 SlotIndex) { return SlotIndex >= 0 && SlotIndex < Capacity; }
+
+	void BroadcastSlotEvents();
+
+	// Rebuilds FreeSlotMask and SlotTypes from the replicated slots
+	UFUNCTION()
+	void OnRep_Slots();
+
+	UPROPERTY(VisibleAnywhere, ReplicatedUsing = OnRep_Slots, Category = Inventory)
+	AItem* Slots[Capacity];
+
+	// What each slot holds, worked out once when the item is added
+	EItemType SlotTypes[Capacity];
+
+	// Bit i is set while slot i is free
+	uint8 FreeSlotMask;
+
+	// Carried ammo indexed by EAmmoType
+	UPROPERTY(Replicated)
+	FInventoryAmmoCounts AmmoCounts;
+
+	// Slot events waiting for the end of the frame
+	TArray<FInventorySlotEvent> PendingSlotEvents;
+
+	// Events being broadcast, swapped with PendingSlotEvents so both keep their allocations
+	TArray<FInventorySlotEvent> BroadcastingSlotEvents;
+};
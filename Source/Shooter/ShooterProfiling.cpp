@@ -0,0 +1,46 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterProfiling.h"
+
+#include "Misc/ScopeLock.h"
+
+std::atomic<bool> FShooterProfiler::bCapturing{ false };
+FCriticalSection FShooterProfiler::TimingsLock;
+TMap<const TCHAR*, FShooterScopeTiming> FShooterProfiler::Timings;
+
+void FShooterProfiler::BeginCapture()
+{
+	FScopeLock Lock(&TimingsLock);
+	Timings.Reset();
+	bCapturing.store(true, std::memory_order_relaxed);
+}
+
+TMap<FString, FShooterScopeTiming> FShooterProfiler::EndCapture()
+{
+	bCapturing.store(false, std::memory_order_relaxed);
+
+	FScopeLock Lock(&TimingsLock);
+
+	// The same literal can have a different address in each translation unit
+	TMap<FString, FShooterScopeTiming> Result;
+	for (const TPair<const TCHAR*, FShooterScopeTiming>& Timing : Timings)
+	{
+		FShooterScopeTiming& Merged = Result.FindOrAdd(Timing.Key);
+		Merged.Calls += Timing.Value.Calls;
+		Merged.Cycles += Timing.Value.Cycles;
+		Merged.MaxCycles = FMath::Max(Merged.MaxCycles, Timing.Value.MaxCycles);
+	}
+	Timings.Reset();
+	return Result;
+}
+
+void FShooterProfiler::AddTiming(const TCHAR* Name, uint64 Cycles)
+{
+	FScopeLock Lock(&TimingsLock);
+
+	FShooterScopeTiming& Timing = Timings.FindOrAdd(Name);
+	Timing.Calls++;
+	Timing.Cycles += Cycles;
+	Timing.MaxCycles = FMath::Max(Timing.MaxCycles, Cycles);
+}
@@ -0,0 +1,84 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Shooter.h"
+#include "HAL/PlatformTime.h"
+#include "ProfilingDebugging/CpuProfilerTrace.h"
+#include <atomic>
+
+// The FShooterProfiler capture is compiled out of shipping builds, the stat and trace scopes follow the engine's own switches
+#ifndef SHOOTER_PROFILING
+#define SHOOTER_PROFILING !UE_BUILD_SHIPPING
+#endif
+
+// Accumulated time for one named scope
+struct FShooterScopeTiming
+{
+	uint64 Calls{ 0 };
+	uint64 Cycles{ 0 };
+	uint64 MaxCycles{ 0 };
+};
+
+/**
+ * Collects SHOOTER_PROFILE_SCOPE timings between BeginCapture and EndCapture.
+ * Outside a capture a scope costs one relaxed atomic load. Scopes may run on
+ * the anim worker threads, so the timings are guarded by a lock.
+ */
+class SHOOTER_API FShooterProfiler
+{
+public:
+	static void BeginCapture();
+
+	// Stops the capture and returns the timings keyed by scope name
+	static TMap<FString, FShooterScopeTiming> EndCapture();
+
+	static FORCEINLINE bool IsCapturing() { return bCapturing.load(std::memory_order_relaxed); }
+
+	static void AddTiming(const TCHAR* Name, uint64 Cycles);
+
+private:
+	static std::atomic<bool> bCapturing;
+	static FCriticalSection TimingsLock;
+
+	// Keyed by the scope's string literal, merged by name in EndCapture
+	static TMap<const TCHAR*, FShooterScopeTiming> Timings;
+};
+
+class FShooterProfileScope
+{
+public:
+	explicit FShooterProfileScope(const TCHAR* InName) :
+	Name(InName),
+	StartCycles(FShooterProfiler::IsCapturing() ? FPlatformTime::Cycles64() : 0)
+	{
+	}
+
+	~FShooterProfileScope()
+	{
+		if (StartCycles != 0)
+		{
+			FShooterProfiler::AddTiming(Name, FPlatformTime::Cycles64() - StartCycles);
+		}
+	}
+
+private:
+	const TCHAR* Name;
+	uint64 StartCycles;
+};
+
+/**
+ * Times the rest of the scope as Name in "stat Shooter", in Unreal Insights CPU
+ * traces and in FShooterProfiler captures. Name must be a valid identifier.
+ */
+#if SHOOTER_PROFILING
+#define SHOOTER_PROFILE_SCOPE(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Name); \
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT(#Name), STAT_Shooter_##Name, STATGROUP_Shooter); \
+	FShooterProfileScope PREPROCESSOR_JOIN(ShooterProfileScope_, __LINE__)(TEXT(#Name))
+#else
+#define SHOOTER_PROFILE_SCOPE(Name) \
+	TRACE_CPUPROFILER_EVENT_SCOPE(Name); \
+	DECLARE_SCOPE_CYCLE_COUNTER(TEXT(#Name), STAT_Shooter_##Name, STATGROUP_Shooter)
+#endif
@@ -0,0 +1,313 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShooterSimulationCommandlet.h"
+
+#include "Ammo.h"
+#include "DamageSubsystem.h"
+#include "ItemPoolSubsystem.h"
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "ShooterProfiling.h"
+#include "Weapon.h"
+#include "Dom/JsonObject.h"
+#include "Engine/CollisionProfile.h"
+#include "Engine/Engine.h"
+#include "Engine/StaticMesh.h"
+#include "Engine/StaticMeshActor.h"
+#include "Engine/World.h"
+#include "GameFramework/PlayerController.h"
+#include "Math/RandomStream.h"
+#include "Misc/App.h"
+#include "Misc/FileHelper.h"
+#include "Misc/Paths.h"
+#include "Serialization/JsonSerializer.h"
+
+namespace ShooterSimulation
+{
+	// Loads the class named by a command line param, falling back to the native class
+	template<typename T>
+	TSubclassOf<T> LoadClassParam(const FString& Params, const TCHAR* Name)
+	{
+		FString ClassPath;
+		if (!FParse::Value(*Params, Name, ClassPath)) return T::StaticClass();
+
+		UClass* Class = LoadClass<T>(nullptr, *ClassPath);
+		if (Class == nullptr)
+		{
+			UE_LOG(LogShooter, Error, TEXT("ShooterSimulation: could not load %s%s, using %s"), Name, *ClassPath, *T::StaticClass()->GetName());
+			return T::StaticClass();
+		}
+		return Class;
+	}
+}
+
+UShooterSimulationCommandlet::UShooterSimulationCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = false;
+	LogToConsole = true;
+}
+
+int32 UShooterSimulationCommandlet::Main(const FString& Params)
+{
+	int32 NumCharacters{ 16 };
+	int32 NumPickups{ 64 };
+	int32 NumTicks{ 1800 };
+	int32 Seed{ 1337 };
+	float DeltaTime{ 1.f / 60.f };
+	FString OutputPath{ FPaths::Combine(FPaths::ProfilingDir(), TEXT("ShooterSimulation.json")) };
+	FParse::Value(*Params, TEXT("Characters="), NumCharacters);
+	FParse::Value(*Params, TEXT("Pickups="), NumPickups);
+	FParse::Value(*Params, TEXT("Ticks="), NumTicks);
+	FParse::Value(*Params, TEXT("Seed="), Seed);
+	FParse::Value(*Params, TEXT("DeltaTime="), DeltaTime);
+	FParse::Value(*Params, TEXT("Output="), OutputPath);
+	const bool bFirefight{ FParse::Param(*Params, TEXT("Firefight")) };
+
+	const TSubclassOf<AShooterCharacter> CharacterClass{ ShooterSimulation::LoadClassParam<AShooterCharacter>(Params, TEXT("CharacterClass=")) };
+	const TSubclassOf<AWeapon> WeaponClass{ ShooterSimulation::LoadClassParam<AWeapon>(Params, TEXT("WeaponClass=")) };
+	const TSubclassOf<AAmmo> AmmoClass{ ShooterSimulation::LoadClassParam<AAmmo>(Params, TEXT("AmmoClass=")) };
+
+	// Everything random in the run, gameplay included, comes from the seed
+	FMath::RandInit(Seed);
+	FMath::SRandInit(Seed);
+	FRandomStream Random(Seed);
+
+	UWorld* World = UWorld::CreateWorld(EWorldType::Game, false, TEXT("ShooterSimulation"));
+	FWorldContext& WorldContext = GEngine->CreateNewWorldContext(EWorldType::Game);
+	WorldContext.SetCurrentWorld(World);
+	World->AddToRoot();
+
+	World->SetGameMode(FURL());
+	World->InitializeActorsForPlay(FURL());
+	World->BeginPlay();
+
+	// Characters stand on a grid, with the pickups scattered over the same area
+	const int32 GridSize{ FMath::Max(1, FMath::CeilToInt(FMath::Sqrt(static_cast<float>(NumCharacters)))) };
+	constexpr float GridSpacing{ 600.f };
+	const float ArenaExtent{ GridSize * GridSpacing };
+
+	// Floor for the arena, the world is otherwise empty
+	if (UStaticMesh* PlaneMesh = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Plane.Plane")))
+	{
+		AStaticMeshActor* Floor = World->SpawnActor<AStaticMeshActor>(FVector(ArenaExtent * 0.5f, ArenaExtent * 0.5f, 0.f), FRotator::ZeroRotator);
+		Floor->GetStaticMeshComponent()->SetStaticMesh(PlaneMesh);
+		// The plane is 100 units across
+		Floor->SetActorScale3D(FVector(ArenaExtent * 0.04f, ArenaExtent * 0.04f, 1.f));
+		Floor->GetStaticMeshComponent()->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
+	}
+
+	FActorSpawnParameters SpawnParams;
+	SpawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AdjustIfPossibleButAlwaysSpawn;
+
+	TArray<AShooterCharacter*> Characters;
+	for (int32 i = 0; i < NumCharacters; i++)
+	{
+		const FVector Location{ (i % GridSize + 0.5f) * GridSpacing, (i / GridSize + 0.5f) * GridSpacing, 100.f };
+		const FRotator Rotation{ 0.f, Random.FRandRange(-180.f, 180.f), 0.f };
+		AShooterCharacter* Character = World->SpawnActor<AShooterCharacter>(CharacterClass, Location, Rotation, SpawnParams);
+		if (Character == nullptr) continue;
+
+		APlayerController* PlayerController = World->SpawnActor<APlayerController>();
+		PlayerController->Possess(Character);
+		Characters.Add(Character);
+	}
+
+	UItemPoolSubsystem* ItemPool = World->GetSubsystem<UItemPoolSubsystem>();
+	for (int32 i = 0; i < NumPickups; i++)
+	{
+		const FTransform Transform{ FRotator(0.f, Random.FRandRange(-180.f, 180.f), 0.f),
+			FVector(Random.FRandRange(0.f, ArenaExtent), Random.FRandRange(0.f, ArenaExtent), 50.f) };
+		const TSubclassOf<AItem> PickupClass{ (i % 2 == 0) ? TSubclassOf<AItem>(WeaponClass) : TSubclassOf<AItem>(AmmoClass) };
+		if (ItemPool)
+		{
+			ItemPool->AcquireItem(PickupClass, Transform);
+		}
+		else
+		{
+			World->SpawnActor<AItem>(PickupClass, Transform, SpawnParams);
+		}
+	}
+
+	UE_LOG(LogShooter, Display, TEXT("ShooterSimulation: %d characters, %d pickups, %d ticks of %.4f s, seed %d%s"),
+		Characters.Num(), NumPickups, NumTicks, DeltaTime, Seed, bFirefight ? TEXT(", firefight") : TEXT(""));
+
+	TArray<FSimulatedInput> Inputs;
+	Inputs.SetNum(Characters.Num());
+
+	// Firefight targets, everyone shoots at a random other character
+	TArray<int32> Targets;
+	if (bFirefight)
+	{
+		Targets.SetNum(Characters.Num());
+		for (int32 i = 0; i < Characters.Num(); i++)
+		{
+			Targets[i] = Characters.Num() > 1 ? (i + 1 + Random.RandHelper(Characters.Num() - 1)) % Characters.Num() : i;
+		}
+	}
+
+	FApp::SetDeltaTime(DeltaTime);
+	FShooterProfiler::BeginCapture();
+	const double StartSeconds{ FPlatformTime::Seconds() };
+
+	for (int32 TickIndex = 0; TickIndex < NumTicks; TickIndex++)
+	{
+		for (int32 i = 0; i < Characters.Num(); i++)
+		{
+			if (!IsValid(Characters[i])) continue;
+
+			if (bFirefight)
+			{
+				DriveFirefighter(Characters[i], Characters[Targets[i]], Inputs[i]);
+			}
+			else
+			{
+				DriveCharacter(Characters[i], Random, Inputs[i]);
+			}
+		}
+
+		FApp::SetCurrentTime(FApp::GetCurrentTime() + DeltaTime);
+		World->Tick(LEVELTICK_All, DeltaTime);
+		GFrameCounter++;
+	}
+
+	const UDamageSubsystem* Damage = World->GetSubsystem<UDamageSubsystem>();
+	const int64 NumDamageHits{ Damage ? Damage->GetNumHitsApplied() : 0 };
+	const int64 NumDamageEvents{ Damage ? Damage->GetNumDamageEvents() : 0 };
+
+	const double WallSeconds{ FPlatformTime::Seconds() - StartSeconds };
+	const TMap<FString, FShooterScopeTiming> Timings{ FShooterProfiler::EndCapture() };
+
+	World->EndPlay(EEndPlayReason::Quit);
+	GEngine->DestroyWorldContext(World);
+	World->DestroyWorld(false);
+	World->RemoveFromRoot();
+
+	UE_LOG(LogShooter, Display, TEXT("ShooterSimulation: %d ticks in %.2f s, %lld hits in %lld damage events"), NumTicks, WallSeconds, NumDamageHits, NumDamageEvents);
+	for (const TPair<FString, FShooterScopeTiming>& Timing : Timings)
+	{
+		UE_LOG(LogShooter, Display, TEXT("  %-56s %8llu calls %10.3f ms"), *Timing.Key, Timing.Value.Calls,
+			FPlatformTime::ToMilliseconds64(Timing.Value.Cycles));
+	}
+
+	return WriteResults(OutputPath, Timings, Characters.Num(), NumPickups, NumTicks, Seed, DeltaTime, WallSeconds, NumDamageHits, NumDamageEvents) ? 0 : 1;
+}
+
+void UShooterSimulationCommandlet::DriveCharacter(AShooterCharacter* Character, FRandomStream& Random, FSimulatedInput& Input)
+{
+	// Wander and look around every tick
+	Character->MoveForward(Random.FRandRange(-1.f, 1.f));
+	Character->MoveRight(Random.FRandRange(-1.f, 1.f));
+	Character->Turn(Random.FRandRange(-0.5f, 0.5f));
+	Character->LookUp(Random.FRandRange(-0.2f, 0.2f));
+
+	// Release select the tick after pressing it, like a tap
+	if (Input.bSelecting)
+	{
+		Character->SelectButtonReleased();
+		Input.bSelecting = false;
+	}
+
+	// One discrete action at most per tick, weighted like a player's inputs
+	const float Roll{ Random.GetFraction() };
+	if (Roll < 0.02f)
+	{
+		Input.bFiring = !Input.bFiring;
+		Input.bFiring ? Character->FireButtonPressed() : Character->FireButtonReleased();
+	}
+	else if (Roll < 0.03f)
+	{
+		Input.bAiming = !Input.bAiming;
+		Input.bAiming ? Character->AimingButtonPressed() : Character->AimingButtonReleased();
+	}
+	else if (Roll < 0.035f)
+	{
+		Character->ReloadButtonPressed();
+	}
+	else if (Roll < 0.04f)
+	{
+		Character->CrouchButtonPressed();
+	}
+	else if (Roll < 0.05f)
+	{
+		Character->SelectButtonPressed();
+		Input.bSelecting = true;
+	}
+	else if (Roll < 0.055f)
+	{
+		switch (Random.RandHelper(6))
+		{
+		case 0: Character->FKeyPressed(); break;
+		case 1: Character->OneKeyPressed(); break;
+		case 2: Character->TwoKeyPressed(); break;
+		case 3: Character->ThreeKeyPressed(); break;
+		case 4: Character->FourKeyPressed(); break;
+		default: Character->FiveKeyPressed(); break;
+		}
+	}
+}
+
+void UShooterSimulationCommandlet::DriveFirefighter(AShooterCharacter* Character, const AShooterCharacter* Target, FSimulatedInput& Input)
+{
+	if (AController* Controller = Character->GetController())
+	{
+		Controller->SetControlRotation((Target->GetActorLocation() - Character->GetPawnViewLocation()).Rotation());
+	}
+
+	const AWeapon* Weapon = Character->GetEquippedWeapon();
+	if (Weapon && Weapon->GetAmmo() == 0)
+	{
+		Character->ReloadButtonPressed();
+	}
+
+	if (!Input.bFiring)
+	{
+		Character->FireButtonPressed();
+		Input.bFiring = true;
+	}
+}
+
+bool UShooterSimulationCommandlet::WriteResults(const FString& OutputPath, const TMap<FString, FShooterScopeTiming>& Timings,
+	int32 NumCharacters, int32 NumPickups, int32 NumTicks, int32 Seed, float DeltaTime, double WallSeconds,
+	int64 NumDamageHits, int64 NumDamageEvents)
+{
+	TSharedRef<FJsonObject> Root = MakeShared<FJsonObject>();
+	Root->SetNumberField(TEXT("characters"), NumCharacters);
+	Root->SetNumberField(TEXT("pickups"), NumPickups);
+	Root->SetNumberField(TEXT("ticks"), NumTicks);
+	Root->SetNumberField(TEXT("seed"), Seed);
+	Root->SetNumberField(TEXT("deltaTime"), DeltaTime);
+	Root->SetNumberField(TEXT("wallMs"), WallSeconds * 1000.0);
+	Root->SetNumberField(TEXT("damageHits"), static_cast<double>(NumDamageHits));
+	Root->SetNumberField(TEXT("damageEvents"), static_cast<double>(NumDamageEvents));
+
+	TSharedRef<FJsonObject> Functions = MakeShared<FJsonObject>();
+	for (const TPair<FString, FShooterScopeTiming>& Timing : Timings)
+	{
+		const double TotalMs{ FPlatformTime::ToMilliseconds64(Timing.Value.Cycles) };
+
+		TSharedRef<FJsonObject> Function = MakeShared<FJsonObject>();
+		Function->SetNumberField(TEXT("calls"), static_cast<double>(Timing.Value.Calls));
+		Function->SetNumberField(TEXT("totalMs"), TotalMs);
+		Function->SetNumberField(TEXT("perTickMs"), NumTicks > 0 ? TotalMs / NumTicks : 0.0);
+		Function->SetNumberField(TEXT("avgUs"), Timing.Value.Calls > 0 ? TotalMs * 1000.0 / Timing.Value.Calls : 0.0);
+		Function->SetNumberField(TEXT("maxUs"), FPlatformTime::ToMilliseconds64(Timing.Value.MaxCycles) * 1000.0);
+		Functions->SetObjectField(Timing.Key, Function);
+	}
+	Root->SetObjectField(TEXT("functions"), Functions);
+
+	FString Json;
+	const TSharedRef<TJsonWriter<>> Writer = TJsonWriterFactory<>::Create(&Json);
+	FJsonSerializer::Serialize(Root, Writer);
+
+	if (!FFileHelper::SaveStringToFile(Json, *OutputPath))
+	{
+		UE_LOG(LogShooter, Error, TEXT("ShooterSimulation: could not write %s"), *OutputPath);
+		return false;
+	}
+
+	UE_LOG(LogShooter, Display, TEXT("ShooterSimulation: wrote %s"), *OutputPath);
+	return true;
+}
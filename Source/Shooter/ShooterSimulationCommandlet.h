@@ -0,0 +1,57 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Commandlets/Commandlet.h"
+#include "ShooterSimulationCommandlet.generated.h"
+
+/**
+ * Headless combat simulation for catching gameplay thread regressions.
+ * Spawns characters and pickups in an empty world, drives their input handlers
+ * from a seeded random script for a fixed number of fixed-length ticks and
+ * writes the SHOOTER_PROFILE_SCOPE timings as JSON.
+ *
+ * UnrealEditor-Cmd Shooter.uproject -run=ShooterSimulation -nullrhi -unattended
+ *   -Characters=16 -Pickups=64 -Ticks=1800 -Seed=1337 -Output=<path>
+ *   -CharacterClass=<class path> -WeaponClass=<class path> -AmmoClass=<class path>
+ *   -Firefight
+ *
+ * -Firefight is the damage load test: every character keeps aiming at another one and holding
+ * fire. With no viewport to deproject a crosshair from, shots aim from the shooter's eyes and go
+ * through the normal shot paths into UDamageSubsystem. Run it with -Characters=100 and a
+ * -WeaponClass that has a BarrelSocket.
+ *
+ * The classes default to the native ones, pass the blueprints to get meshes,
+ * sockets and anim blueprints.
+ */
+UCLASS()
+class SHOOTER_API UShooterSimulationCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	UShooterSimulationCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	// Buttons each simulated player is holding
+	struct FSimulatedInput
+	{
+		bool bFiring{ false };
+		bool bAiming{ false };
+		bool bSelecting{ false };
+	};
+
+	// Runs one tick of scripted input for a character
+	static void DriveCharacter(class AShooterCharacter* Character, struct FRandomStream& Random, FSimulatedInput& Input);
+
+	// Runs one tick of the firefight script: aim at Target, keep firing, reload when empty
+	static void DriveFirefighter(AShooterCharacter* Character, const AShooterCharacter* Target, FSimulatedInput& Input);
+
+	// Writes the captured timings, returns false if the file could not be saved
+	static bool WriteResults(const FString& OutputPath, const TMap<FString, struct FShooterScopeTiming>& Timings,
+		int32 NumCharacters, int32 NumPickups, int32 NumTicks, int32 Seed, float DeltaTime, double WallSeconds,
+		int64 NumDamageHits, int64 NumDamageEvents);
+};
@@ -0,0 +1,28 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShotPacket.h"
+
+#include "Serialization/BitWriter.h"
+
+bool FShotPacket::NetSerialize(FArchive& Ar, UPackageMap* Map, bool& bOutSuccess)
+{
+	bool bOriginSuccess{ true };
+	bool bDirectionSuccess{ true };
+	Origin.NetSerialize(Ar, Map, bOriginSuccess);
+	Direction.NetSerialize(Ar, Map, bDirectionSuccess);
+	Ar << Seed;
+	Ar << Timestamp;
+
+	bOutSuccess = bOriginSuccess && bDirectionSuccess && !Ar.IsError();
+	return true;
+}
+
+int32 FShotPacket::GetSerializedBits() const
+{
+	FBitWriter Writer(0, true);
+	bool bSuccess{ true };
+	FShotPacket Copy{ *this };
+	Copy.NetSerialize(Writer, nullptr, bSuccess);
+	return static_cast<int32>(Writer.GetNumBits());
+}
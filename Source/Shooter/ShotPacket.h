@@ -0,0 +1,47 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Engine/NetSerialization.h"
+#include "ShotPacket.generated.h"
+
+/**
+ * What a client sends the server for one shot. The server redoes the traces from this
+ * instead of trusting a client FHitResult.
+ */
+USTRUCT()
+struct FShotPacket
+{
+	GENERATED_BODY()
+
+	// Start of the crosshair trace, quantized to 1 unit
+	UPROPERTY()
+	FVector_NetQuantize Origin;
+
+	// Crosshair trace direction, 16 bits per component
+	UPROPERTY()
+	FVector_NetQuantizeNormal Direction;
+
+	// Increments every shot; identifies the shot in corrections and seeds any per-shot randomness
+	UPROPERTY()
+	uint16 Seed{ 0 };
+
+	// Server world time the client fired at, used to rewind the other characters
+	UPROPERTY()
+	float Timestamp{ 0.f };
+
+	bool NetSerialize(FArchive& Ar, class UPackageMap* Map, bool& bOutSuccess);
+
+	// Payload size in bits, used for the bandwidth stats
+	int32 GetSerializedBits() const;
+};
+
+template<>
+struct TStructOpsTypeTraits<FShotPacket> : public TStructOpsTypeTraitsBase2<FShotPacket>
+{
+	enum
+	{
+		WithNetSerializer = true,
+	};
+};
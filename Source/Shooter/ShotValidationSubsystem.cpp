@@ -0,0 +1,316 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "ShotValidationSubsystem.h"
+
+#include "Shooter.h"
+#include "ShooterCharacter.h"
+#include "ShotPacket.h"
+#include "Components/CapsuleComponent.h"
+#include "Components/SkeletalMeshComponent.h"
+#include "Engine/World.h"
+#include "GameFramework/CharacterMovementComponent.h"
+#include "GameFramework/PlayerState.h"
+#include "HAL/IConsoleManager.h"
+
+static TAutoConsoleVariable<float> CVarShotMaxRewindTime(
+	TEXT("Shooter.Net.MaxRewindTime"),
+	0.3f,
+	TEXT("Oldest shot, in seconds, the server will rewind characters for. Older shots are rejected."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarShotMaxOriginError(
+	TEXT("Shooter.Net.MaxOriginError"),
+	300.f,
+	TEXT("Largest distance between a shot's origin and where the server had the shooter at that time."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarShotMaxAimAngle(
+	TEXT("Shooter.Net.MaxAimAngle"),
+	15.f,
+	TEXT("Largest angle, in degrees, between a shot's direction and the shooter's aim on the server."),
+	ECVF_Default);
+
+static FAutoConsoleCommandWithWorld ShotStatsCommand(
+	TEXT("Shooter.Net.ShotStats"),
+	TEXT("Logs shots sent and rejected, and the average bytes per shot, for this world."),
+	FConsoleCommandWithWorldDelegate::CreateLambda([](UWorld* World)
+	{
+		if (const UShotValidationSubsystem* ShotValidation = World ? World->GetSubsystem<UShotValidationSubsystem>() : nullptr)
+		{
+			ShotValidation->LogShotStats();
+		}
+	}));
+
+// Length of the crosshair trace, same as AShooterCharacter::GetCrosshairTraceSegment
+static constexpr float ShotRange{ 50'000.f };
+
+void FCharacterPositionHistory::AddSample(float Time, const FVector& Location, float CapsuleHalfHeight)
+{
+	Samples[Head].Time = Time;
+	Samples[Head].Location = Location;
+	Samples[Head].CapsuleHalfHeight = CapsuleHalfHeight;
+	Head = (Head + 1) % NumSamples;
+	NumValid = FMath::Min(NumValid + 1, NumSamples);
+}
+
+bool FCharacterPositionHistory::GetSampleAtTime(float Time, FVector& OutLocation, float& OutCapsuleHalfHeight) const
+{
+	if (NumValid == 0) return false;
+
+	// Walk back from the newest sample until we pass Time
+	const FCharacterPositionSample* Newer{ nullptr };
+	for (int32 i = 1; i <= NumValid; i++)
+	{
+		const FCharacterPositionSample& Sample = Samples[(Head - i + NumSamples) % NumSamples];
+		if (Sample.Time <= Time)
+		{
+			if (Newer == nullptr)
+			{
+				// Time is after the newest sample
+				OutLocation = Sample.Location;
+				OutCapsuleHalfHeight = Sample.CapsuleHalfHeight;
+			}
+			else
+			{
+				const float Span{ Newer->Time - Sample.Time };
+				const float Alpha{ Span > KINDA_SMALL_NUMBER ? (Time - Sample.Time) / Span : 0.f };
+				OutLocation = FMath::Lerp(Sample.Location, Newer->Location, Alpha);
+				OutCapsuleHalfHeight = FMath::Lerp(Sample.CapsuleHalfHeight, Newer->CapsuleHalfHeight, Alpha);
+			}
+			return true;
+		}
+		Newer = &Sample;
+	}
+
+	// Older than the history, use the oldest sample
+	OutLocation = Newer->Location;
+	OutCapsuleHalfHeight = Newer->CapsuleHalfHeight;
+	return true;
+}
+
+void UShotValidationSubsystem::Deinitialize()
+{
+	Histories.Empty();
+
+	Super::Deinitialize();
+}
+
+void UShotValidationSubsystem::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	// Only the server validates shots
+	const UWorld* World = GetWorld();
+	if (World == nullptr || World->GetNetMode() == NM_Client || World->GetNetMode() == NM_Standalone) return;
+
+	const float Now{ World->GetTimeSeconds() };
+	for (auto It = Histories.CreateIterator(); It; ++It)
+	{
+		const AShooterCharacter* Character = It.Key().Get();
+		if (Character == nullptr)
+		{
+			It.RemoveCurrent();
+			continue;
+		}
+		It.Value().AddSample(Now, Character->GetActorLocation(), Character->GetCapsuleComponent()->GetScaledCapsuleHalfHeight());
+	}
+}
+
+TStatId UShotValidationSubsystem::GetStatId() const
+{
+	RETURN_QUICK_DECLARE_CYCLE_STAT(UShotValidationSubsystem, STATGROUP_Tickables);
+}
+
+void UShotValidationSubsystem::RegisterCharacter(AShooterCharacter* Character)
+{
+	if (Character == nullptr) return;
+
+	// Crouching only changes the half height, which is sampled every tick
+	FCharacterPositionHistory& History = Histories.FindOrAdd(Character);
+	History.CapsuleRadius = Character->GetCapsuleComponent()->GetScaledCapsuleRadius();
+}
+
+void UShotValidationSubsystem::UnregisterCharacter(AShooterCharacter* Character)
+{
+	Histories.Remove(Character);
+}
+
+bool UShotValidationSubsystem::IsShotPlausible(const AShooterCharacter* Shooter, const FShotPacket& Packet) const
+{
+	const UWorld* World = GetWorld();
+	if (Shooter == nullptr || World == nullptr) return false;
+
+	// Not from the future, and not older than we are willing to rewind
+	const float Now{ World->GetTimeSeconds() };
+	const float Age{ Now - Packet.Timestamp };
+	if (Age < -0.05f || Age > CVarShotMaxRewindTime.GetValueOnGameThread()) return false;
+
+	if (!Packet.Direction.IsNormalized()) return false;
+
+	// The crosshair looks along the control rotation, which the server has from the client's moves a frame or two behind
+	const float MinAimCos{ FMath::Cos(FMath::DegreesToRadians(CVarShotMaxAimAngle.GetValueOnGameThread())) };
+	if ((Packet.Direction | Shooter->GetBaseAimRotation().Vector()) < MinAimCos) return false;
+
+	// The crosshair trace starts at the camera, which sits on a boom behind the shooter
+	FVector ShooterLocation{ Shooter->GetActorLocation() };
+	if (const FCharacterPositionHistory* History = Histories.Find(const_cast<AShooterCharacter*>(Shooter)))
+	{
+		float ShooterHalfHeight;
+		History->GetSampleAtTime(Packet.Timestamp, ShooterLocation, ShooterHalfHeight);
+	}
+	const float MaxOriginError{ CVarShotMaxOriginError.GetValueOnGameThread() };
+	return FVector::DistSquared(ShooterLocation, Packet.Origin) <= FMath::Square(MaxOriginError);
+}
+
+float UShotValidationSubsystem::GetRewindTime(const AShooterCharacter* Shooter, const FShotPacket& Packet) const
+{
+	const UWorld* World = GetWorld();
+	const float Now{ World ? World->GetTimeSeconds() : Packet.Timestamp };
+
+	// The client sees the other characters half a round trip after the server moved them...
+	float Latency{ 0.f };
+	if (const APlayerState* PlayerState = Shooter ? Shooter->GetPlayerState() : nullptr)
+	{
+		Latency = PlayerState->GetPingInMilliseconds() * 0.0005f;
+	}
+
+	// ...and then smooths them towards that position over NetworkSimulatedSmoothLocationTime
+	if (const UCharacterMovementComponent* Movement = Shooter ? Shooter->GetCharacterMovement() : nullptr)
+	{
+		Latency += Movement->NetworkSimulatedSmoothLocationTime;
+	}
+
+	const float RewindTime{ FMath::Min(Packet.Timestamp, Now) - Latency };
+	return FMath::Clamp(RewindTime, Now - CVarShotMaxRewindTime.GetValueOnGameThread(), Now);
+}
+
+FVector UShotValidationSubsystem::TraceAimTarget(const AShooterCharacter* Shooter, const FShotPacket& Packet) const
+{
+	const FVector CrosshairEnd{ Packet.Origin + Packet.Direction * ShotRange };
+	FHitResult CrosshairHit;
+	return TraceWithRewind(Shooter, Packet.Origin, CrosshairEnd, GetRewindTime(Shooter, Packet), CrosshairHit) ? CrosshairHit.Location : CrosshairEnd;
+}
+
+bool UShotValidationSubsystem::TraceShot(AShooterCharacter* Shooter, const FShotPacket& Packet, const FVector& MuzzleLocation, FHitResult& OutHit) const
+{
+	// Crosshair trace, finds what the client was aiming at
+	const FVector BeamTarget{ TraceAimTarget(Shooter, Packet) };
+
+	// Barrel trace, same as AShooterCharacter::GetBeamEndLocation
+	const FVector WeaponTraceEnd{ MuzzleLocation + (BeamTarget - MuzzleLocation) * 1.25f };
+	return TraceWithRewind(Shooter, MuzzleLocation, WeaponTraceEnd, GetRewindTime(Shooter, Packet), OutHit);
+}
+
+bool UShotValidationSubsystem::TraceWithRewind(const AShooterCharacter* Shooter, const FVector& Start, const FVector& End, float Time, FHitResult& OutHit) const
+{
+	UWorld* World = GetWorld();
+	if (World == nullptr) return false;
+
+	// Characters are tested below at their rewound positions, so the world trace skips them
+	FCollisionQueryParams QueryParams(SCENE_QUERY_STAT(ShotRewindTrace), false, Shooter);
+	for (const TPair<TWeakObjectPtr<AShooterCharacter>, FCharacterPositionHistory>& Entry : Histories)
+	{
+		if (const AShooterCharacter* Character = Entry.Key.Get())
+		{
+			QueryParams.AddIgnoredActor(Character);
+		}
+	}
+
+	bool bHit = World->LineTraceSingleByChannel(OutHit, Start, End, ECC_Visibility, QueryParams);
+	INC_DWORD_STAT(STAT_ShooterTraces);
+	float ClosestDistance{ bHit ? OutHit.Distance : TNumericLimits<float>::Max() };
+
+	// Character hit at its rewound position, if it is the closest hit
+	AShooterCharacter* HitCharacter = nullptr;
+	FVector HitCharacterRewoundLocation{ FVector::ZeroVector };
+
+	for (const TPair<TWeakObjectPtr<AShooterCharacter>, FCharacterPositionHistory>& Entry : Histories)
+	{
+		AShooterCharacter* Character = Entry.Key.Get();
+		if (Character == nullptr || Character == Shooter) continue;
+
+		const FCharacterPositionHistory& History = Entry.Value;
+		FVector RewoundLocation;
+		float RewoundHalfHeight;
+		if (!History.GetSampleAtTime(Time, RewoundLocation, RewoundHalfHeight)) continue;
+
+		// Capsule is the segment between the centers of its end spheres, inflated by the radius
+		const FVector CapsuleAxis{ 0.f, 0.f, FMath::Max(RewoundHalfHeight - History.CapsuleRadius, 0.f) };
+		FVector PointOnShot;
+		FVector PointOnCapsule;
+		FMath::SegmentDistToSegmentSafe(Start, End, RewoundLocation - CapsuleAxis, RewoundLocation + CapsuleAxis, PointOnShot, PointOnCapsule);
+		if (FVector::DistSquared(PointOnShot, PointOnCapsule) > FMath::Square(History.CapsuleRadius)) continue;
+
+		const float Distance{ static_cast<float>(FVector::Dist(Start, PointOnShot)) };
+		if (Distance < ClosestDistance)
+		{
+			ClosestDistance = Distance;
+			bHit = true;
+
+			OutHit = FHitResult(Character, Character->GetCapsuleComponent(), PointOnShot, (PointOnShot - PointOnCapsule).GetSafeNormal());
+			OutHit.TraceStart = Start;
+			OutHit.TraceEnd = End;
+			OutHit.Distance = Distance;
+			OutHit.bBlockingHit = true;
+
+			HitCharacter = Character;
+			HitCharacterRewoundLocation = RewoundLocation;
+		}
+	}
+
+	if (!bHit)
+	{
+		// Misses still say where the shot ended, for the cosmetics
+		OutHit.TraceStart = Start;
+		OutHit.TraceEnd = End;
+	}
+	else if (HitCharacter)
+	{
+		// Bone for the hit zone, from the mesh alone with the shot moved by as much as the character moved since.
+		// The hit is then on the mesh body, so UDamageSubsystem takes the bone index from Item without tracing again
+		const FVector RewindOffset{ HitCharacter->GetActorLocation() - HitCharacterRewoundLocation };
+		FHitResult BoneHit;
+		if (HitCharacter->GetMesh()->LineTraceComponent(BoneHit, Start + RewindOffset, End + RewindOffset, FCollisionQueryParams(SCENE_QUERY_STAT(ShotRewindBoneTrace))))
+		{
+			OutHit.Component = HitCharacter->GetMesh();
+			OutHit.Item = BoneHit.Item;
+			OutHit.BoneName = BoneHit.BoneName;
+		}
+	}
+	return bHit;
+}
+
+void UShotValidationSubsystem::RecordShotSent(int32 PacketBits)
+{
+	++NumShotsSent;
+	ShotPacketBits += PacketBits;
+	INC_DWORD_STAT(STAT_NetShotsSent);
+	INC_DWORD_STAT_BY(STAT_NetShotBytes, (PacketBits + 7) / 8);
+}
+
+void UShotValidationSubsystem::RecordShotRejected()
+{
+	++NumShotsRejected;
+	INC_DWORD_STAT(STAT_NetShotsRejected);
+}
+
+void UShotValidationSubsystem::RecordCosmeticsSent(int32 PayloadBits)
+{
+	++NumCosmeticsSent;
+	CosmeticsBits += PayloadBits;
+	INC_DWORD_STAT_BY(STAT_NetShotBytes, (PayloadBits + 7) / 8);
+}
+
+void UShotValidationSubsystem::LogShotStats() const
+{
+	UE_LOG(LogShooter, Display, TEXT("Shots sent: %lld (%.1f bytes/shot payload), rejected: %lld, cosmetic multicasts: %lld (%.1f bytes each)"),
+		NumShotsSent, NumShotsSent > 0 ? ShotPacketBits / 8.0 / NumShotsSent : 0.0,
+		NumShotsRejected,
+		NumCosmeticsSent, NumCosmeticsSent > 0 ? CosmeticsBits / 8.0 / NumCosmeticsSent : 0.0);
+}
+
+bool UShotValidationSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
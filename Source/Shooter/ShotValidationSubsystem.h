@@ -0,0 +1,99 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "ShotValidationSubsystem.generated.h"
+
+class AShooterCharacter;
+struct FShotPacket;
+
+// Where a character was at one server time, and how tall its capsule was (crouching changes it)
+struct FCharacterPositionSample
+{
+	float Time{ 0.f };
+	FVector Location{ FVector::ZeroVector };
+	float CapsuleHalfHeight{ 0.f };
+};
+
+// Fixed size ring of recent positions for one character
+struct FCharacterPositionHistory
+{
+	static constexpr int32 NumSamples{ 64 };
+
+	FCharacterPositionSample Samples[NumSamples];
+
+	// Next sample to write
+	int32 Head{ 0 };
+
+	int32 NumValid{ 0 };
+
+	float CapsuleRadius{ 0.f };
+
+	void AddSample(float Time, const FVector& Location, float CapsuleHalfHeight);
+
+	// Location and capsule half height at Time, interpolated between the two samples around it
+	bool GetSampleAtTime(float Time, FVector& OutLocation, float& OutCapsuleHalfHeight) const;
+};
+
+/**
+ * Server side checks for client shots. Records where every character was over the last
+ * second, and traces shots against the other characters moved back to where they were
+ * when the client fired.
+ */
+UCLASS()
+class SHOOTER_API UShotValidationSubsystem : public UTickableWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Deinitialize() override;
+	virtual void Tick(float DeltaTime) override;
+	virtual TStatId GetStatId() const override;
+
+	// Called from AShooterCharacter::BeginPlay / EndPlay on the server
+	void RegisterCharacter(AShooterCharacter* Character);
+	void UnregisterCharacter(AShooterCharacter* Character);
+
+	// Rejects packets fired too far in the past or future, from too far away from the shooter or away from its aim
+	bool IsShotPlausible(const AShooterCharacter* Shooter, const FShotPacket& Packet) const;
+
+	/**
+	 * Server time the shooter's client was seeing the other characters at when it fired: the shot's timestamp
+	 * less half the round trip and the simulated proxy smoothing delay, clamped to the rewind window.
+	 */
+	float GetRewindTime(const AShooterCharacter* Shooter, const FShotPacket& Packet) const;
+
+	// Redoes the crosshair trace of a shot with the other characters rewound, returns what the client was aiming at
+	FVector TraceAimTarget(const AShooterCharacter* Shooter, const FShotPacket& Packet) const;
+
+	/**
+	 * Redoes the crosshair and barrel traces of a shot with the other characters rewound to GetRewindTime.
+	 * @return true if the barrel trace hit something, OutHit.Actor is the character if it was one
+	 */
+	bool TraceShot(AShooterCharacter* Shooter, const FShotPacket& Packet, const FVector& MuzzleLocation, FHitResult& OutHit) const;
+
+	// Bandwidth bookkeeping for Shooter.Net.ShotStats
+	void RecordShotSent(int32 PacketBits);
+	void RecordShotRejected();
+	void RecordCosmeticsSent(int32 PayloadBits);
+
+	// Averages since the world started, printed by Shooter.Net.ShotStats
+	void LogShotStats() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Line trace against the world, then against the rewound capsules of everyone but the shooter
+	bool TraceWithRewind(const AShooterCharacter* Shooter, const FVector& Start, const FVector& End, float Time, FHitResult& OutHit) const;
+
+	TMap<TWeakObjectPtr<AShooterCharacter>, FCharacterPositionHistory> Histories;
+
+	int64 NumShotsSent{ 0 };
+	int64 NumShotsRejected{ 0 };
+	int64 ShotPacketBits{ 0 };
+	int64 NumCosmeticsSent{ 0 };
+	int64 CosmeticsBits{ 0 };
+};
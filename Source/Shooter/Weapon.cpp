@@ -3,9 +3,76 @@
 
 #include "Weapon.h"
 
+#include "CurveBakeSubsystem.h"
+#include "Shooter.h"
+#include "ShooterDataTableSubsystem.h"
+#include "ShooterProfiling.h"
+#include "WeaponAssetSubsystem.h"
+#include "HAL/IConsoleManager.h"
+#include "Net/UnrealNetwork.h"
+#include "PhysicsEngine/BodyInstance.h"
+
+static TAutoConsoleVariable<int32> CVarWeaponsSettleDetection(
+	TEXT("Shooter.Weapons.SettleDetection"),
+	1,
+	TEXT("1 ends a thrown weapon's fall once it is asleep or at rest, 0 always waits the full ThrowWeaponTime."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarWeaponsSettleSpeed(
+	TEXT("Shooter.Weapons.SettleSpeed"),
+	20.f,
+	TEXT("Linear speed, in units per second, below which a thrown weapon counts as at rest."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarWeaponsSettleAngularSpeed(
+	TEXT("Shooter.Weapons.SettleAngularSpeed"),
+	30.f,
+	TEXT("Angular speed, in degrees per second, below which a thrown weapon counts as at rest."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarWeaponsSettleTime(
+	TEXT("Shooter.Weapons.SettleTime"),
+	0.1f,
+	TEXT("Seconds a thrown weapon has to stay below the settle speeds before it becomes a pickup."),
+	ECVF_Default);
+
+void FWeaponDataTable::GetAssetPaths(EWeaponAssetGroup Group, TArray<FSoftObjectPath>& OutPaths) const
+{
+	auto AddPath = [&OutPaths](const FSoftObjectPath& Path)
+	{
+		if (!Path.IsNull())
+		{
+			OutPaths.Add(Path);
+		}
+	};
+
+	if (Group == EWeaponAssetGroup::EWAG_World)
+	{
+		AddPath(ItemMesh.ToSoftObjectPath());
+		AddPath(MaterialInstance.ToSoftObjectPath());
+		AddPath(AnimBP.ToSoftObjectPath());
+		AddPath(DormantMesh.ToSoftObjectPath());
+	}
+	else
+	{
+		AddPath(PickupSound.ToSoftObjectPath());
+		AddPath(EquipSound.ToSoftObjectPath());
+		AddPath(InventoryIcon.ToSoftObjectPath());
+		AddPath(AmmoIcon.ToSoftObjectPath());
+		AddPath(CrosshairMiddle.ToSoftObjectPath());
+		AddPath(CrosshairRight.ToSoftObjectPath());
+		AddPath(CrosshairLeft.ToSoftObjectPath());
+		AddPath(CrosshairTop.ToSoftObjectPath());
+		AddPath(CrosshairBottom.ToSoftObjectPath());
+		AddPath(MuzzleFlash.ToSoftObjectPath());
+		AddPath(FireSound.ToSoftObjectPath());
+	}
+}
+
 AWeapon::AWeapon():
 ThrowWeaponTime(0.7f),
 bFalling(false),
+SettledTime(0.f),
 Ammo(30),
 MagazineCapacity(30),
 WeaponType(EWeaponType::EWT_SubmachineGun),
@@ -13,28 +80,44 @@ AmmoType(EAmmoType::EAT_9mm),
 ReloadMontageSection(FName(TEXT("Reload SMG"))),
 ClipBoneName(TEXT("smg_clip")),
 SlideDisplacement(0.f),
+BakedSlideDisplacementCurve(nullptr),
 SlideDisplacementTime(0.2f),
 bMovingSlide(false),
 MaxSlideDisplacement(4.f),
 MaxRecoilRotation(20.f),
-bAutomatic(true)
+bAutomatic(true),
+bEquipAssetsRequested(false),
+Damage(20.f),
+bProjectile(false),
+MuzzleVelocity(90000.f),
+ProjectileDrag(0.f),
+ProjectileGravityScale(1.f)
 {
+	// Only ticks while falling or moving the pistol slide
 	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.bStartWithTickEnabled = false;
 }
 
 void AWeapon::Tick(float DeltaTime)
 {
 	Super::Tick(DeltaTime);
 
-	// Keep the weapon upright
+	// Throw and slide timers
+	UpdateClock(GetWorld()->GetTimeSeconds());
+
+	// End the fall early once the weapon is at rest
 	if (GetItemState() == EItemState::EIS_Falling && bFalling)
 	{
-		const FRotator MeshRotation { 0.f, GetItemMesh()->GetComponentRotation().Yaw, 0.f};
-		GetItemMesh()->SetWorldRotation(MeshRotation, false, nullptr, ETeleportType::TeleportPhysics);
+		UpdateSettle(DeltaTime);
 	}
 
 	// Update slide on pistol
 	UpdateSlideDisplacement();
+
+	if (!bFalling && !bMovingSlide)
+	{
+		SetActorTickEnabled(false);
+	}
 }
 
 void AWeapon::ThrowWeapon()
@@ -51,9 +134,14 @@ void AWeapon::ThrowWeapon()
 	ImpulseDirection = ImpulseDirection.RotateAngleAxis(RandomRotation, FVector(0.f, 0.f, 1.f));
 	ImpulseDirection *= 20'000.f;
 	GetItemMesh()->AddImpulse(ImpulseDirection);
+	SetUprightLock(true);
 
 	bFalling = true;
-	GetWorldTimerManager().SetTimer(ThrowWeaponTimer, this, &AWeapon::StopFalling, ThrowWeaponTime);
+	SettledTime = 0.f;
+	SetActorTickEnabled(true);
+	// Clients see where the server's physics puts the weapon while it falls
+	SetReplicateMovement(true);
+	Clock.Schedule(EItemClockEvent::EICE_StopFalling, GetWorld()->GetTimeSeconds(), ThrowWeaponTime);
 
 	EnableGlowMaterial();
 }
@@ -76,10 +164,11 @@ void AWeapon::ReloadAmmo(int32 Amount)
 	Ammo += Amount;
 }
 
-void AWeapon::StartSlideTimer()
+void AWeapon::StartSlideTimer(double StartTime)
 {
 	bMovingSlide = true;
-	GetWorldTimerManager().SetTimer(SlideTimer, this, &AWeapon::FinishMovingSlide, SlideDisplacementTime);
+	SetActorTickEnabled(true);
+	Clock.Schedule(EItemClockEvent::EICE_Slide, StartTime, SlideDisplacementTime);
 }
 
 bool AWeapon::ClipIsFull()
@@ -90,83 +179,180 @@ bool AWeapon::ClipIsFull()
 void AWeapon::StopFalling()
 {
 	bFalling = false;
+	SettledTime = 0.f;
+	Clock.Cancel(EItemClockEvent::EICE_StopFalling);
+	SetUprightLock(false);
+	SetReplicateMovement(false);
 	SetItemState(EItemState::EIS_Pickup);
-	StartPulseTimer();
+	StartPulse();
+}
+
+void AWeapon::UpdateSettle(float DeltaTime)
+{
+	if (CVarWeaponsSettleDetection.GetValueOnGameThread() == 0) return;
+
+	const float SettleSpeed{ CVarWeaponsSettleSpeed.GetValueOnGameThread() };
+	const float SettleAngularSpeed{ CVarWeaponsSettleAngularSpeed.GetValueOnGameThread() };
+	const bool bBelowSettleSpeeds{
+		GetItemMesh()->GetPhysicsLinearVelocity().SizeSquared() < FMath::Square(SettleSpeed) &&
+		GetItemMesh()->GetPhysicsAngularVelocityInDegrees().SizeSquared() < FMath::Square(SettleAngularSpeed) };
+
+	SettledTime = bBelowSettleSpeeds ? SettledTime + DeltaTime : 0.f;
+	if (SettledTime >= CVarWeaponsSettleTime.GetValueOnGameThread())
+	{
+		StopFalling();
+	}
+}
+
+void AWeapon::SetUprightLock(bool bLock)
+{
+	FBodyInstance* RootBody = GetItemMesh()->GetBodyInstance();
+	if (RootBody == nullptr) return;
+
+	RootBody->bLockXRotation = bLock;
+	RootBody->bLockYRotation = bLock;
+	RootBody->SetDOFLock(bLock ? EDOFMode::SixDOF : EDOFMode::None);
+
+	// Sleep events are only wanted while falling
+	RootBody->bGenerateWakeEvents = bLock;
+}
+
+void AWeapon::OnItemMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName)
+{
+	if (bFalling && GetItemState() == EItemState::EIS_Falling && CVarWeaponsSettleDetection.GetValueOnGameThread() != 0)
+	{
+		StopFalling();
+	}
 }
 
 void AWeapon::OnConstruction(const FTransform& Transform)
 {
 	Super::OnConstruction(Transform);
 	
-	const FString WeaponTablePath{ TEXT("/Script/Engine.DataTable'/Game/_Game/DataTable/WeaponDataTable.WeaponDataTable'")};
-	UDataTable* WeaponTableObject = Cast<UDataTable>(StaticLoadObject(UDataTable::StaticClass(), nullptr, *WeaponTablePath));
-	
-	if (WeaponTableObject)
+	// Weapon rows are cached by enum value, no table load or row name lookup here
+	UShooterDataTableSubsystem* DataTables = UShooterDataTableSubsystem::Get();
+	if (DataTables)
 	{
-		FWeaponDataTable* WeaponDataRow = nullptr;
-		
-		switch (WeaponType)
-		{
-		case EWeaponType::EWT_SubmachineGun:
-			WeaponDataRow = WeaponTableObject->FindRow<FWeaponDataTable>(FName("SubmachineGun"), TEXT(""));
-			break;
-		
-		case EWeaponType::EWT_AssaultRifle:
-			WeaponDataRow = WeaponTableObject->FindRow<FWeaponDataTable>(FName("AssaultRifle"), TEXT(""));
-			break;
-			
-		case EWeaponType::EWT_Pistol:
-			WeaponDataRow = WeaponTableObject->FindRow<FWeaponDataTable>(FName("Pistol"), TEXT(""));
-			break;
-		}
+		const FWeaponDataTable* WeaponDataRow = DataTables->GetWeaponRow(WeaponType);
 
 		if (WeaponDataRow)
 		{
 			AmmoType = WeaponDataRow->AmmoType;
 			Ammo = WeaponDataRow->WeaponAmmo;
 			MagazineCapacity = WeaponDataRow->MagazineCapacity;
-			SetPickupSound(WeaponDataRow->PickupSound);
-			SetEquipSound(WeaponDataRow->EquipSound);
-			GetItemMesh()->SetSkeletalMesh(WeaponDataRow->ItemMesh);
 			SetItemName(WeaponDataRow->ItemName);
-			SetIconItem(WeaponDataRow->InventoryIcon);
-			SetAmmoIcon(WeaponDataRow->AmmoIcon);
-
-			SetMaterialInstance(WeaponDataRow->MaterialInstance);
-			PreviousMaterialIndex = GetMaterialIndex();
-			GetItemMesh()->SetMaterial(PreviousMaterialIndex, nullptr);
-			SetMaterialIndex(WeaponDataRow->MaterialIndex);
 			SetClipBoneName(WeaponDataRow->ClipBoneName);
 			SetReloadMontageSection(WeaponDataRow->ReloadMontageSection);
-			GetItemMesh()->SetAnimInstanceClass(WeaponDataRow->AnimBP);
-			CrosshairMiddle = WeaponDataRow->CrosshairMiddle;
-			CrosshairLeft = WeaponDataRow->CrosshairLeft;
-			CrosshairRight = WeaponDataRow->CrosshairRight;
-			CrosshairTop = WeaponDataRow->CrosshairTop;
-			CrosshairBottom = WeaponDataRow->CrosshairBottom;
 			AutoFireRate = WeaponDataRow->AutoFireRate;
-			MuzzleFlash = WeaponDataRow->MuzzleFlash;
-			FireSound = WeaponDataRow->FireSound;
 			BoneToHide = WeaponDataRow->BoneToHide;
-			GetItemMesh()->HideBoneByName(BoneToHide, PBO_None);
 			bAutomatic = WeaponDataRow->bAutomatic;
+			Damage = WeaponDataRow->Damage;
+			bProjectile = WeaponDataRow->bProjectile;
+			MuzzleVelocity = WeaponDataRow->MuzzleVelocity;
+			ProjectileDrag = WeaponDataRow->ProjectileDrag;
+			ProjectileGravityScale = WeaponDataRow->ProjectileGravityScale;
+
+			// Mesh, material and anim blueprint are applied now if they are loaded, otherwise once they stream in
+			UWeaponAssetSubsystem::RequestAssets(this, EWeaponAssetGroup::EWAG_World);
+
+			// Sounds, icons and crosshairs wait for a character to come near, unless another weapon already loaded them
+			ApplyWeaponAssets(EWeaponAssetGroup::EWAG_Equip);
 		}
+	}
+}
+
+void AWeapon::ApplyWeaponAssets(EWeaponAssetGroup Group)
+{
+	UShooterDataTableSubsystem* DataTables = UShooterDataTableSubsystem::Get();
+	const FWeaponDataTable* WeaponDataRow = DataTables ? DataTables->GetWeaponRow(WeaponType) : nullptr;
+	if (WeaponDataRow == nullptr) return;
+
+	if (Group == EWeaponAssetGroup::EWAG_World)
+	{
+		GetItemMesh()->SetSkeletalMesh(WeaponDataRow->ItemMesh.Get());
+		GetItemMesh()->SetAnimInstanceClass(WeaponDataRow->AnimBP.Get());
+		GetItemMesh()->HideBoneByName(BoneToHide, PBO_None);
+
+		// A pickup waiting for its dormant mesh can go dormant now
+		SetDormantMesh(WeaponDataRow->DormantMesh.Get());
+		if (HasActorBegunPlay() && !WeaponDataRow->DormantMesh.IsNull())
+		{
+			UpdateItemRegistration();
+		}
+
+		SetMaterialInstance(WeaponDataRow->MaterialInstance.Get());
+		PreviousMaterialIndex = GetMaterialIndex();
+		GetItemMesh()->SetMaterial(PreviousMaterialIndex, nullptr);
+		SetMaterialIndex(WeaponDataRow->MaterialIndex);
 
 		if (GetMaterialInstance())
 		{
 			SetDynamicMaterialInstance(UMaterialInstanceDynamic::Create(GetMaterialInstance(), this));
 			GetDynamicMaterialInstance()->SetVectorParameterValue(TEXT("FresnelColor"), GetGlowColor());
 			GetItemMesh()->SetMaterial(GetMaterialIndex(), GetDynamicMaterialInstance());
-		
-			EnableGlowMaterial();
+
+			// The assets can arrive after the weapon was picked up
+			const EItemState State{ GetItemState() };
+			if (State == EItemState::EIS_Equipped || State == EItemState::EIS_PickedUp)
+			{
+				DisableGlowMaterial();
+			}
+			else
+			{
+				EnableGlowMaterial();
+			}
 		}
 	}
+	else
+	{
+		// Null outside game worlds, which keeps the editor from saving hard references into the level.
+		// In game Get() is already null until the group has loaded
+		const bool bGameWorld{ GetWorld() && GetWorld()->IsGameWorld() };
+		SetPickupSound(bGameWorld ? WeaponDataRow->PickupSound.Get() : nullptr);
+		SetEquipSound(bGameWorld ? WeaponDataRow->EquipSound.Get() : nullptr);
+		SetIconItem(bGameWorld ? WeaponDataRow->InventoryIcon.Get() : nullptr);
+		SetAmmoIcon(bGameWorld ? WeaponDataRow->AmmoIcon.Get() : nullptr);
+		CrosshairMiddle = bGameWorld ? WeaponDataRow->CrosshairMiddle.Get() : nullptr;
+		CrosshairLeft = bGameWorld ? WeaponDataRow->CrosshairLeft.Get() : nullptr;
+		CrosshairRight = bGameWorld ? WeaponDataRow->CrosshairRight.Get() : nullptr;
+		CrosshairTop = bGameWorld ? WeaponDataRow->CrosshairTop.Get() : nullptr;
+		CrosshairBottom = bGameWorld ? WeaponDataRow->CrosshairBottom.Get() : nullptr;
+		MuzzleFlash = bGameWorld ? WeaponDataRow->MuzzleFlash.Get() : nullptr;
+		FireSound = bGameWorld ? WeaponDataRow->FireSound.Get() : nullptr;
+	}
+}
+
+void AWeapon::PrefetchEquipAssets()
+{
+	if (bEquipAssetsRequested) return;
+	bEquipAssetsRequested = true;
+
+	UWeaponAssetSubsystem::RequestAssets(this, EWeaponAssetGroup::EWAG_Equip);
+}
+
+void AWeapon::SetItemProperties(EItemState State)
+{
+	Super::SetItemProperties(State);
+
+	if (State == EItemState::EIS_PickedUp)
+	{
+		PrefetchEquipAssets();
+	}
+	else if (State == EItemState::EIS_Equipped)
+	{
+		// Only blocks if the weapon was equipped before its prefetch completed, e.g. a character's default weapon
+		PrefetchEquipAssets();
+		UWeaponAssetSubsystem::LoadAssetsNow(this, EWeaponAssetGroup::EWAG_World);
+		UWeaponAssetSubsystem::LoadAssetsNow(this, EWeaponAssetGroup::EWAG_Equip);
+	}
 }
 
 void AWeapon::BeginPlay()
 {
 	Super::BeginPlay();
 
+	GetItemMesh()->OnComponentSleep.AddDynamic(this, &AWeapon::OnItemMeshSleep);
+
 	if (BoneToHide != FName(""))
 	{
 		GetItemMesh()->HideBoneByName(BoneToHide, PBO_None);
@@ -180,11 +366,64 @@ void AWeapon::FinishMovingSlide()
 
 void AWeapon::UpdateSlideDisplacement()
 {
+	SHOOTER_PROFILE_SCOPE(Weapon_UpdateSlideDisplacement);
+
 	if (SlideDisplacementCurve && bMovingSlide)
 	{
-		const float ElapsedTime = GetWorldTimerManager().GetTimerElapsed(SlideTimer);
-		const float CurveValue = SlideDisplacementCurve->GetFloatValue(ElapsedTime);
+		const float ElapsedTime = Clock.GetElapsed(EItemClockEvent::EICE_Slide, GetWorld()->GetTimeSeconds());
+		const float CurveValue = UCurveBakeSubsystem::EvaluateFloat(BakedSlideDisplacementCurve, SlideDisplacementCurve, ElapsedTime);
 		SlideDisplacement = CurveValue * MaxSlideDisplacement;
 		RecoilRotation = CurveValue * MaxRecoilRotation;
 	}
 }
+
+void AWeapon::CacheBakedCurves()
+{
+	Super::CacheBakedCurves();
+
+	BakedSlideDisplacementCurve = UCurveBakeSubsystem::FindBakedCurve(this, SlideDisplacementCurve);
+}
+
+void AWeapon::OnClockEvent(EItemClockEvent Event)
+{
+	switch (Event)
+	{
+	case EItemClockEvent::EICE_StopFalling:
+		StopFalling();
+		break;
+	case EItemClockEvent::EICE_Slide:
+		FinishMovingSlide();
+		break;
+	default:
+		Super::OnClockEvent(Event);
+		break;
+	}
+}
+
+void AWeapon::OnReleasedToPool()
+{
+	Super::OnReleasedToPool();
+
+	bFalling = false;
+	SettledTime = 0.f;
+	SetUprightLock(false);
+	SetReplicateMovement(false);
+	bMovingClip = false;
+	bMovingSlide = false;
+	SlideDisplacement = 0.f;
+	RecoilRotation = 0.f;
+	SetActorTickEnabled(false);
+
+	// Refill the magazine to the amount the weapon spawns with
+	UShooterDataTableSubsystem* DataTables = UShooterDataTableSubsystem::Get();
+	const FWeaponDataTable* WeaponDataRow = DataTables ? DataTables->GetWeaponRow(WeaponType) : nullptr;
+	Ammo = WeaponDataRow ? WeaponDataRow->WeaponAmmo : GetClass()->GetDefaultObject<AWeapon>()->Ammo;
+}
+
+void AWeapon::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
+
+	// The owning character predicts its ammo, see AShooterCharacter::ClientCorrectCombat
+	DOREPLIFETIME_CONDITION(AWeapon, Ammo, COND_SkipOwner);
+}
@@ -9,6 +9,17 @@
 #include "WeaponType.h"
 #include "Weapon.generated.h"
 
+// Weapon row assets are streamed in two groups, see UWeaponAssetSubsystem
+enum class EWeaponAssetGroup : uint8
+{
+	// Needed to show the weapon in the world: mesh, material and anim blueprint
+	EWAG_World,
+	// Only needed once a character can pick the weapon up: sounds, icons, crosshairs and muzzle flash
+	EWAG_Equip,
+
+	EWAG_MAX
+};
+
 USTRUCT()
 struct FWeaponDataTable : public FTableRowBase
 {
@@ -24,25 +35,25 @@ struct FWeaponDataTable : public FTableRowBase
 	int32 MagazineCapacity;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	class USoundCue* PickupSound;
+	TSoftObjectPtr<class USoundCue> PickupSound;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	USoundCue* EquipSound;
+	TSoftObjectPtr<USoundCue> EquipSound;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	USkeletalMesh* ItemMesh;
+	TSoftObjectPtr<USkeletalMesh> ItemMesh;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FString ItemName;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* InventoryIcon;
+	TSoftObjectPtr<UTexture2D> InventoryIcon;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* AmmoIcon;
+	TSoftObjectPtr<UTexture2D> AmmoIcon;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UMaterialInstance* MaterialInstance;
+	TSoftObjectPtr<UMaterialInstance> MaterialInstance;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	int32 MaterialIndex;
@@ -54,37 +65,63 @@ struct FWeaponDataTable : public FTableRowBase
 	FName ReloadMontageSection;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	TSubclassOf<UAnimInstance> AnimBP;
+	TSoftClassPtr<UAnimInstance> AnimBP;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairMiddle;
+	TSoftObjectPtr<UTexture2D> CrosshairMiddle;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairRight;
+	TSoftObjectPtr<UTexture2D> CrosshairRight;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairLeft;
+	TSoftObjectPtr<UTexture2D> CrosshairLeft;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairTop;
+	TSoftObjectPtr<UTexture2D> CrosshairTop;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	UTexture2D* CrosshairBottom;
+	TSoftObjectPtr<UTexture2D> CrosshairBottom;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float AutoFireRate;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	class UParticleSystem* MuzzleFlash;
+	TSoftObjectPtr<class UParticleSystem> MuzzleFlash;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
-	USoundCue* FireSound;
+	TSoftObjectPtr<USoundCue> FireSound;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	FName BoneToHide;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool bAutomatic;
+
+	// Damage of one bullet before the hit zone multiplier
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	float Damage{ 20.f };
+
+	// Fires rounds simulated by UBallisticsSubsystem instead of hitscan traces
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics)
+	bool bProjectile{ false };
+
+	// Units per second
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics, meta = (EditCondition = "bProjectile"))
+	float MuzzleVelocity{ 90000.f };
+
+	// Quadratic drag in 1/units, around 8e-6 for a rifle round
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics, meta = (EditCondition = "bProjectile"))
+	float ProjectileDrag{ 0.f };
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = Ballistics, meta = (EditCondition = "bProjectile"))
+	float ProjectileGravityScale{ 1.f };
+
+	// Static stand-in for ItemMesh, drawn while the weapon is a dormant pickup
+	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	TSoftObjectPtr<UStaticMesh> DormantMesh;
+
+	// Soft references of one streaming group, see UWeaponAssetSubsystem
+	void GetAssetPaths(EWeaponAssetGroup Group, TArray<FSoftObjectPath>& OutPaths) const;
 };
 /**
  * 
@@ -97,11 +134,23 @@ public:
 	
 	AWeapon();
 	virtual void Tick(float DeltaTime) override;
+
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
 	
 protected:
 	
 	void StopFalling();
 
+	// Counts how long the falling weapon has been below the settle speeds, stops falling once that reaches Shooter.Weapons.SettleTime
+	void UpdateSettle(float DeltaTime);
+
+	// Locks pitch and roll of the mesh's root body so a thrown weapon lands upright, replaces teleporting it upright every tick
+	void SetUprightLock(bool bLock);
+
+	// Ends the fall as soon as the physics engine puts the weapon to sleep
+	UFUNCTION()
+	void OnItemMeshSleep(UPrimitiveComponent* SleepingComponent, FName BoneName);
+
 	virtual void OnConstruction(const FTransform& Transform) override;
 
 	virtual void BeginPlay() override;
@@ -109,14 +158,24 @@ protected:
 	void FinishMovingSlide();
 
 	void UpdateSlideDisplacement();
+
+	virtual void OnClockEvent(EItemClockEvent Event) override;
+
+	virtual void CacheBakedCurves() override;
+
+	// Prefetches the equip assets once the weapon is in an inventory and makes sure they are in when it is equipped
+	virtual void SetItemProperties(EItemState State) override;
 	
 private:
-	FTimerHandle ThrowWeaponTimer;
+	// Longest a thrown weapon falls for, it usually settles before that
 	float ThrowWeaponTime;
 	bool bFalling;
 
+	// Seconds the falling weapon has been below the settle speeds
+	float SettledTime;
+
 	// Ammo count for this weapon
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category= "Weapon Properties", meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Replicated, Category= "Weapon Properties", meta=(AllowPrivateAccess = "True"))
 	int32 Ammo;
 
 	// Maximum Ammo that our weapon can hold
@@ -149,20 +208,20 @@ private:
 
 	int32 PreviousMaterialIndex;
 	
-	// Textures for the weapon crosshair
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	// Textures for the weapon crosshair. The equip assets are transient, so placed weapons don't hard reference them through the level
+	UPROPERTY(VisibleAnywhere, Transient, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
 	UTexture2D* CrosshairMiddle;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, Transient, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
 	UTexture2D* CrosshairRight;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, Transient, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
 	UTexture2D* CrosshairLeft;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, Transient, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
 	UTexture2D* CrosshairTop;
 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, Transient, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
 	UTexture2D* CrosshairBottom;
 
 	// The speed at which automatic fire happens
@@ -170,11 +229,11 @@ private:
 	float AutoFireRate;
 
 	// Particle system spawned at BarrelSocket 
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, Transient, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
 	class UParticleSystem* MuzzleFlash;
 
 	// Sound played when the weapon is fired
-	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	UPROPERTY(VisibleAnywhere, Transient, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
 	USoundCue* FireSound;
 
 	// Name of the bone to hide on the weapon mesh
@@ -189,8 +248,8 @@ private:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category= Pistol, meta=(AllowPrivateAccess = "True"))
 	UCurveFloat* SlideDisplacementCurve;
 
-	// Timer Handle for updating slide displacement
-	FTimerHandle SlideTimer;
+	// Baked copy of SlideDisplacementCurve, owned by UCurveBakeSubsystem
+	const FBakedCurve* BakedSlideDisplacementCurve;
 
 	// Time for displacing the slide during pistol fire
 	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category= Pistol, meta=(AllowPrivateAccess = "True"))
@@ -215,6 +274,26 @@ private:
 	// True for auto gun fire
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category= "Weapon Properties", meta=(AllowPrivateAccess = "True"))
 	bool bAutomatic;
+
+	// True once the equip assets have been requested from UWeaponAssetSubsystem
+	bool bEquipAssetsRequested;
+
+	// Damage of one bullet before the hit zone multiplier
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	float Damage;
+
+	// Ballistics of the weapon's rounds, from the data table row
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	bool bProjectile;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	float MuzzleVelocity;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	float ProjectileDrag;
+
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category= DataTable, meta=(AllowPrivateAccess = "True"))
+	float ProjectileGravityScale;
 	
 public:
 	// Adds an impulse to the weapon
@@ -222,6 +301,9 @@ public:
 
 	FORCEINLINE int32 GetAmmo() const { return Ammo;}
 
+	// Called when the server corrects the owning client's predicted ammo
+	FORCEINLINE void SetAmmo(int32 Amount) { Ammo = Amount; }
+
 	FORCEINLINE int32 GetMagazineCapacity() const { return MagazineCapacity;}
 	
 	// Called from Character class when firing weapon
@@ -251,7 +333,23 @@ public:
 
 	FORCEINLINE bool GetAutomatic() const { return bAutomatic;}
 
-	void StartSlideTimer();
+	FORCEINLINE float GetDamage() const { return Damage;}
+
+	FORCEINLINE bool IsProjectileWeapon() const { return bProjectile;}
+	FORCEINLINE float GetMuzzleVelocity() const { return MuzzleVelocity;}
+	FORCEINLINE float GetProjectileDrag() const { return ProjectileDrag;}
+	FORCEINLINE float GetProjectileGravityScale() const { return ProjectileGravityScale;}
+
+	// StartTime is the character's combat time of the shot, so the slide stays in step with sub-frame shots
+	void StartSlideTimer(double StartTime);
 
 	bool ClipIsFull();
+
+	virtual void OnReleasedToPool() override;
+
+	// Copies the loaded assets of Group from the weapon row, called by UWeaponAssetSubsystem once they are streamed in
+	void ApplyWeaponAssets(EWeaponAssetGroup Group);
+
+	// Starts streaming the sounds, icons and crosshairs, called when a character comes near the weapon
+	void PrefetchEquipAssets();
 };
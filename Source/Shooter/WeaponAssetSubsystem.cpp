@@ -0,0 +1,236 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+
+#include "WeaponAssetSubsystem.h"
+
+#include "Shooter.h"
+#include "ShooterDataTableSubsystem.h"
+#include "Engine/AssetManager.h"
+#include "Engine/StreamableManager.h"
+#include "Engine/World.h"
+#include "HAL/IConsoleManager.h"
+#include "HAL/PlatformTime.h"
+
+static TAutoConsoleVariable<int32> CVarWeaponsAsyncAssets(
+	TEXT("Shooter.Weapons.AsyncAssets"),
+	1,
+	TEXT("1 streams weapon row assets in the background, 0 loads them synchronously when they are requested."),
+	ECVF_Default);
+
+static const TCHAR* GetAssetGroupName(EWeaponAssetGroup Group)
+{
+	return Group == EWeaponAssetGroup::EWAG_World ? TEXT("World") : TEXT("Equip");
+}
+
+void UWeaponAssetSubsystem::Initialize(FSubsystemCollectionBase& Collection)
+{
+	Super::Initialize(Collection);
+
+	Requests.SetNum(static_cast<int32>(EWeaponType::EWT_MAX) * static_cast<int32>(EWeaponAssetGroup::EWAG_MAX));
+}
+
+void UWeaponAssetSubsystem::Deinitialize()
+{
+	for (FWeaponAssetRequest& WeaponRequest : Requests)
+	{
+		if (WeaponRequest.Handle.IsValid())
+		{
+			WeaponRequest.Handle->CancelHandle();
+		}
+	}
+	Requests.Empty();
+
+	Super::Deinitialize();
+}
+
+void UWeaponAssetSubsystem::RequestAssets(AWeapon* Weapon, EWeaponAssetGroup Group)
+{
+	if (Weapon == nullptr) return;
+
+	UWorld* World = Weapon->GetWorld();
+	UWeaponAssetSubsystem* WeaponAssets = World ? World->GetSubsystem<UWeaponAssetSubsystem>() : nullptr;
+	if (WeaponAssets)
+	{
+		WeaponAssets->Request(Weapon, Group);
+		return;
+	}
+
+	// No subsystem, e.g. the editor running the construction script
+	UShooterDataTableSubsystem* DataTables = UShooterDataTableSubsystem::Get();
+	const FWeaponDataTable* WeaponDataRow = DataTables ? DataTables->GetWeaponRow(Weapon->GetWeaponType()) : nullptr;
+	if (WeaponDataRow == nullptr) return;
+
+	TArray<FSoftObjectPath> Paths;
+	WeaponDataRow->GetAssetPaths(Group, Paths);
+	for (const FSoftObjectPath& Path : Paths)
+	{
+		Path.TryLoad();
+	}
+	Weapon->ApplyWeaponAssets(Group);
+}
+
+void UWeaponAssetSubsystem::LoadAssetsNow(AWeapon* Weapon, EWeaponAssetGroup Group)
+{
+	if (Weapon == nullptr) return;
+
+	UWorld* World = Weapon->GetWorld();
+	UWeaponAssetSubsystem* WeaponAssets = World ? World->GetSubsystem<UWeaponAssetSubsystem>() : nullptr;
+	if (WeaponAssets == nullptr)
+	{
+		RequestAssets(Weapon, Group);
+		return;
+	}
+
+	// Request() returns false for these too, and there is no request slot to wait on
+	const EWeaponType WeaponType{ Weapon->GetWeaponType() };
+	if (WeaponType >= EWeaponType::EWT_MAX || WeaponAssets->Requests.Num() == 0) return;
+
+	// Weapons get the assets either right away or from the completion delegate, so there is nothing to apply twice
+	if (WeaponAssets->AreAssetsLoaded(WeaponType, Group) || WeaponAssets->Request(Weapon, Group)) return;
+
+	FWeaponAssetRequest& WeaponRequest = WeaponAssets->GetRequest(WeaponType, Group);
+	if (WeaponRequest.Handle.IsValid())
+	{
+		UE_LOG(LogShooter, Verbose, TEXT("Waiting for %s assets of %s"), GetAssetGroupName(Group), *UEnum::GetValueAsString(WeaponType));
+		WeaponRequest.Handle->WaitUntilComplete();
+	}
+
+	// The completion delegate may not have run yet, OnAssetsLoaded only applies the assets once
+	WeaponAssets->OnAssetsLoaded(WeaponType, Group);
+}
+
+bool UWeaponAssetSubsystem::AreAssetsLoaded(EWeaponType WeaponType, EWeaponAssetGroup Group) const
+{
+	if (WeaponType >= EWeaponType::EWT_MAX || Requests.Num() == 0) return false;
+
+	return GetRequest(WeaponType, Group).bLoaded;
+}
+
+bool UWeaponAssetSubsystem::Request(AWeapon* Weapon, EWeaponAssetGroup Group)
+{
+	const EWeaponType WeaponType{ Weapon->GetWeaponType() };
+	if (WeaponType >= EWeaponType::EWT_MAX || Requests.Num() == 0) return false;
+
+	FWeaponAssetRequest& WeaponRequest = GetRequest(WeaponType, Group);
+	if (WeaponRequest.bLoaded)
+	{
+		Weapon->ApplyWeaponAssets(Group);
+		return true;
+	}
+
+	WeaponRequest.WaitingWeapons.AddUnique(Weapon);
+	if (WeaponRequest.bRequested) return false;
+	WeaponRequest.bRequested = true;
+	WeaponRequest.RequestTime = FPlatformTime::Seconds();
+
+	UShooterDataTableSubsystem* DataTables = UShooterDataTableSubsystem::Get();
+	const FWeaponDataTable* WeaponDataRow = DataTables ? DataTables->GetWeaponRow(WeaponType) : nullptr;
+
+	TArray<FSoftObjectPath> Paths;
+	if (WeaponDataRow)
+	{
+		WeaponDataRow->GetAssetPaths(Group, Paths);
+	}
+
+	if (Paths.Num() > 0)
+	{
+		FStreamableManager& StreamableManager = UAssetManager::GetStreamableManager();
+		const FStreamableDelegate OnLoaded{ FStreamableDelegate::CreateUObject(this, &UWeaponAssetSubsystem::OnAssetsLoaded, WeaponType, Group) };
+		if (CVarWeaponsAsyncAssets.GetValueOnGameThread() != 0)
+		{
+			WeaponRequest.Handle = StreamableManager.RequestAsyncLoad(MoveTemp(Paths), OnLoaded, FStreamableManager::AsyncLoadHighPriority);
+		}
+		else
+		{
+			WeaponRequest.Handle = StreamableManager.RequestSyncLoad(MoveTemp(Paths));
+		}
+	}
+
+	// Nothing to load, or the assets were already in memory
+	if (!WeaponRequest.Handle.IsValid() || WeaponRequest.Handle->HasLoadCompleted())
+	{
+		OnAssetsLoaded(WeaponType, Group);
+		return true;
+	}
+	return false;
+}
+
+void UWeaponAssetSubsystem::OnAssetsLoaded(EWeaponType WeaponType, EWeaponAssetGroup Group)
+{
+	if (Requests.Num() == 0) return;
+
+	FWeaponAssetRequest& WeaponRequest = GetRequest(WeaponType, Group);
+	if (WeaponRequest.bLoaded) return;
+	WeaponRequest.bLoaded = true;
+	WeaponRequest.LoadSeconds = FPlatformTime::Seconds() - WeaponRequest.RequestTime;
+
+	UE_LOG(LogShooter, Verbose, TEXT("Loaded %s assets of %s in %.2f ms"),
+		GetAssetGroupName(Group), *UEnum::GetValueAsString(WeaponType), WeaponRequest.LoadSeconds * 1000.0);
+
+	TArray<TWeakObjectPtr<AWeapon>> WaitingWeapons{ MoveTemp(WeaponRequest.WaitingWeapons) };
+	for (const TWeakObjectPtr<AWeapon>& Weapon : WaitingWeapons)
+	{
+		if (Weapon.IsValid())
+		{
+			Weapon->ApplyWeaponAssets(Group);
+		}
+	}
+}
+
+void UWeaponAssetSubsystem::LogAssetReport() const
+{
+	UShooterDataTableSubsystem* DataTables = UShooterDataTableSubsystem::Get();
+	if (DataTables == nullptr) return;
+
+	SIZE_T TotalBytes{ 0 };
+	for (int32 TypeIndex = 0; TypeIndex < static_cast<int32>(EWeaponType::EWT_MAX); TypeIndex++)
+	{
+		const EWeaponType WeaponType{ static_cast<EWeaponType>(TypeIndex) };
+		const FWeaponDataTable* WeaponDataRow = DataTables->GetWeaponRow(WeaponType);
+		if (WeaponDataRow == nullptr) continue;
+
+		for (int32 GroupIndex = 0; GroupIndex < static_cast<int32>(EWeaponAssetGroup::EWAG_MAX); GroupIndex++)
+		{
+			const EWeaponAssetGroup Group{ static_cast<EWeaponAssetGroup>(GroupIndex) };
+
+			TArray<FSoftObjectPath> Paths;
+			WeaponDataRow->GetAssetPaths(Group, Paths);
+
+			// Counts assets in memory for any reason, not only the ones this subsystem loaded
+			int32 NumInMemory{ 0 };
+			SIZE_T GroupBytes{ 0 };
+			for (const FSoftObjectPath& Path : Paths)
+			{
+				if (const UObject* Asset = Path.ResolveObject())
+				{
+					NumInMemory++;
+					GroupBytes += Asset->GetResourceSizeBytes(EResourceSizeMode::EstimatedTotal);
+				}
+			}
+			TotalBytes += GroupBytes;
+
+			const FWeaponAssetRequest& WeaponRequest = GetRequest(WeaponType, Group);
+			const TCHAR* State{ WeaponRequest.bLoaded ? TEXT("loaded") : WeaponRequest.bRequested ? TEXT("loading") : TEXT("not requested") };
+			UE_LOG(LogShooter, Log, TEXT("%-30s %-6s %-14s %2d/%2d assets in memory %10.1f KB  load %.2f ms"),
+				*UEnum::GetValueAsString(WeaponType), GetAssetGroupName(Group), State, NumInMemory, Paths.Num(),
+				GroupBytes / 1024.0, FMath::Max(WeaponRequest.LoadSeconds, 0.0) * 1000.0);
+		}
+	}
+	UE_LOG(LogShooter, Log, TEXT("Weapon row assets in memory: %.1f KB"), TotalBytes / 1024.0);
+}
+
+bool UWeaponAssetSubsystem::DoesSupportWorldType(const EWorldType::Type WorldType) const
+{
+	return WorldType == EWorldType::Game || WorldType == EWorldType::PIE;
+}
+
+static FAutoConsoleCommandWithWorld WeaponAssetReportCommand(
+	TEXT("Shooter.Weapons.AssetReport"),
+	TEXT("Logs which weapon row assets are streamed in and their estimated memory."),
+	FConsoleCommandWithWorldDelegate::CreateStatic([](UWorld* World)
+	{
+		const UWeaponAssetSubsystem* WeaponAssets = World ? World->GetSubsystem<UWeaponAssetSubsystem>() : nullptr;
+		if (WeaponAssets == nullptr) return;
+
+		WeaponAssets->LogAssetReport();
+	}));
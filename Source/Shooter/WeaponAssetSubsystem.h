@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Subsystems/WorldSubsystem.h"
+#include "Weapon.h"
+#include "WeaponType.h"
+#include "WeaponAssetSubsystem.generated.h"
+
+struct FStreamableHandle;
+
+// Streaming state of one asset group of one weapon type
+struct FWeaponAssetRequest
+{
+	// Keeps the assets loaded for the lifetime of the world
+	TSharedPtr<FStreamableHandle> Handle;
+
+	// Weapons to apply the assets to once they are in
+	TArray<TWeakObjectPtr<AWeapon>> WaitingWeapons;
+
+	double RequestTime{ 0.0 };
+
+	// Seconds from the request to the assets being in, -1 while loading
+	double LoadSeconds{ -1.0 };
+
+	bool bRequested{ false };
+	bool bLoaded{ false };
+};
+
+/**
+ * Streams the soft referenced assets of the weapon data table rows.
+ * Nothing is loaded with the table; a weapon type's world assets are requested when the first
+ * weapon of that type is constructed and its equip assets when a character comes near one.
+ * Loaded groups stay loaded until the world is torn down.
+ */
+UCLASS()
+class SHOOTER_API UWeaponAssetSubsystem : public UWorldSubsystem
+{
+	GENERATED_BODY()
+
+public:
+	virtual void Initialize(FSubsystemCollectionBase& Collection) override;
+	virtual void Deinitialize() override;
+
+	// Applies Group's assets to Weapon now if they are loaded, otherwise streams them and applies them once they are in.
+	// Worlds without the subsystem, like the editor's, load them synchronously.
+	static void RequestAssets(AWeapon* Weapon, EWeaponAssetGroup Group);
+
+	// Finishes loading Group for Weapon's type now, for a weapon that is needed before its prefetch completed
+	static void LoadAssetsNow(AWeapon* Weapon, EWeaponAssetGroup Group);
+
+	bool AreAssetsLoaded(EWeaponType WeaponType, EWeaponAssetGroup Group) const;
+
+	// Logs the loaded state and resource size of every weapon row asset
+	void LogAssetReport() const;
+
+protected:
+	virtual bool DoesSupportWorldType(const EWorldType::Type WorldType) const override;
+
+private:
+	// Returns true if the assets were already loaded and applied
+	bool Request(AWeapon* Weapon, EWeaponAssetGroup Group);
+
+	void OnAssetsLoaded(EWeaponType WeaponType, EWeaponAssetGroup Group);
+
+	FORCEINLINE FWeaponAssetRequest& GetRequest(EWeaponType WeaponType, EWeaponAssetGroup Group)
+	{
+		return Requests[static_cast<int32>(WeaponType) * static_cast<int32>(EWeaponAssetGroup::EWAG_MAX) + static_cast<int32>(Group)];
+	}
+
+	FORCEINLINE const FWeaponAssetRequest& GetRequest(EWeaponType WeaponType, EWeaponAssetGroup Group) const
+	{
+		return Requests[static_cast<int32>(WeaponType) * static_cast<int32>(EWeaponAssetGroup::EWAG_MAX) + static_cast<int32>(Group)];
+	}
+
+	// One request per weapon type and asset group
+	TArray<FWeaponAssetRequest> Requests;
+};